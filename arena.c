@@ -0,0 +1,113 @@
+/**
+ * @file src/arena.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/arena.h"
+
+#define ARENA_ALIGN 8
+
+/**
+ * @brief Start a new chunk for small allocations.
+ *
+ * @param arena The arena.
+ * @return 0 on success, -1 if the chunk could not be allocated.
+ */
+static int newChunk( Arena* arena ) {
+	if( arena->numChunks >= ARENA_MAX_CHUNKS ) {
+		return -1;
+	}
+	char* chunk = malloc( ARENA_CHUNK_SIZE );
+	if( chunk == NULL ) {
+		return -1;
+	}
+	arena->chunks[arena->numChunks++] = chunk;
+	arena->used = 0;
+	return 0;
+}
+
+/**
+ * @brief Initialize an empty arena.
+ *
+ * @param arena The arena.
+ */
+void arenaInit( Arena* arena ) {
+	arena->numChunks = 0;
+	arena->used = ARENA_CHUNK_SIZE;
+}
+
+/**
+ * @brief Allocate memory from an arena.
+ *
+ * Allocations are 8-byte aligned. Requests larger than a chunk get a chunk of their own.
+ *
+ * @param arena The arena.
+ * @param size Number of bytes.
+ * @return Pointer to the memory, or NULL if it could not be allocated.
+ */
+void* arenaAlloc( Arena* arena, size_t size ) {
+	if( size <= ARENA_CHUNK_SIZE ) {
+		uint32_t ref;
+		return arenaAllocRef( arena, size, &ref );
+	}
+	if( arena->numChunks >= ARENA_MAX_CHUNKS ) {
+		return NULL;
+	}
+	char* chunk = malloc( size );
+	if( chunk == NULL ) {
+		return NULL;
+	}
+	arena->chunks[arena->numChunks++] = chunk;
+	arena->used = ARENA_CHUNK_SIZE;
+	return chunk;
+}
+
+/**
+ * @brief Allocate memory from an arena and return a 32-bit reference to it.
+ *
+ * @param arena The arena.
+ * @param size Number of bytes, at most ARENA_CHUNK_SIZE.
+ * @param ref Pointer to store the reference.
+ * @return Pointer to the memory, or NULL if it could not be allocated.
+ */
+void* arenaAllocRef( Arena* arena, size_t size, uint32_t* ref ) {
+	*ref = ARENA_NO_REF;
+	if( size > ARENA_CHUNK_SIZE ) {
+		return NULL;
+	}
+	size_t offset = ( arena->used + ARENA_ALIGN - 1 ) & ~(size_t)( ARENA_ALIGN - 1 );
+	if( arena->numChunks == 0 || offset + size > ARENA_CHUNK_SIZE ) {
+		if( newChunk( arena ) != 0 ) {
+			return NULL;
+		}
+		offset = 0;
+	}
+	arena->used = offset + size;
+	*ref = ( (uint32_t)( arena->numChunks - 1 ) << ARENA_CHUNK_BITS ) | (uint32_t)offset;
+	return arena->chunks[arena->numChunks - 1] + offset;
+}
+
+/**
+ * @brief Resolve a reference returned by arenaAllocRef().
+ *
+ * @param arena The arena.
+ * @param ref The reference.
+ * @return Pointer to the referenced memory.
+ */
+void* arenaDeref( const Arena* arena, uint32_t ref ) {
+	return arena->chunks[ref >> ARENA_CHUNK_BITS] + ( ref & ( ARENA_CHUNK_SIZE - 1 ) );
+}
+
+/**
+ * @brief Release every allocation of an arena at once.
+ *
+ * @param arena The arena, left empty and ready for reuse.
+ */
+void arenaFree( Arena* arena ) {
+	for( int i = 0; i < arena->numChunks; i++ ) {
+		free( arena->chunks[i] );
+	}
+	arenaInit( arena );
+}
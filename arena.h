@@ -0,0 +1,74 @@
+/**
+ * @file include/arena.h
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ARENA_MAX_CHUNKS 4096
+#define ARENA_CHUNK_BITS 20
+#define ARENA_CHUNK_SIZE ( (size_t)1 << ARENA_CHUNK_BITS )
+#define ARENA_NO_REF UINT32_MAX
+
+/**
+ * @brief Bump allocator over fixed-size chunks.
+ *
+ * Memory is handed out sequentially from 1 MB chunks and only released all at once by arenaFree(). Chunks never
+ * move, so pointers into the arena stay valid until then. Small allocations can also be addressed by a 32-bit
+ * reference (chunk number and offset), which is half the size of a pointer. A zero-filled arena is empty and
+ * ready for use.
+ */
+typedef struct {
+	char* chunks[ARENA_MAX_CHUNKS];
+	int numChunks;
+	size_t used;
+} Arena;
+
+/**
+ * @brief Initialize an empty arena.
+ *
+ * @param arena The arena.
+ */
+void arenaInit( Arena* arena );
+
+/**
+ * @brief Allocate memory from an arena.
+ *
+ * Allocations are 8-byte aligned. Requests larger than a chunk get a chunk of their own.
+ *
+ * @param arena The arena.
+ * @param size Number of bytes.
+ * @return Pointer to the memory, or NULL if it could not be allocated.
+ */
+void* arenaAlloc( Arena* arena, size_t size );
+
+/**
+ * @brief Allocate memory from an arena and return a 32-bit reference to it.
+ *
+ * @param arena The arena.
+ * @param size Number of bytes, at most ARENA_CHUNK_SIZE.
+ * @param ref Pointer to store the reference.
+ * @return Pointer to the memory, or NULL if it could not be allocated.
+ */
+void* arenaAllocRef( Arena* arena, size_t size, uint32_t* ref );
+
+/**
+ * @brief Resolve a reference returned by arenaAllocRef().
+ *
+ * @param arena The arena.
+ * @param ref The reference.
+ * @return Pointer to the referenced memory.
+ */
+void* arenaDeref( const Arena* arena, uint32_t ref );
+
+/**
+ * @brief Release every allocation of an arena at once.
+ *
+ * @param arena The arena, left empty and ready for reuse.
+ */
+void arenaFree( Arena* arena );
+
+#endif // ARENA_H
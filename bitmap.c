@@ -0,0 +1,365 @@
+/**
+ * @file src/bitmap.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/bitmap.h"
+
+#define WORD_BITS 64
+
+/**
+ * @brief Count the set bits of a word.
+ *
+ * @param word The word.
+ * @return The number of set bits.
+ */
+static int popcountWord( uint64_t word ) {
+	#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_popcountll( word );
+	#else
+	word = word - ( ( word >> 1 ) & 0x5555555555555555ULL );
+	word = ( word & 0x3333333333333333ULL ) + ( ( word >> 2 ) & 0x3333333333333333ULL );
+	word = ( word + ( word >> 4 ) ) & 0x0F0F0F0F0F0F0F0FULL;
+	return (int)( ( word * 0x0101010101010101ULL ) >> 56 );
+	#endif
+}
+
+/**
+ * @brief Index of the lowest set bit of a non-zero word.
+ *
+ * @param word The word, must not be zero.
+ * @return The bit index.
+ */
+static int lowestBit( uint64_t word ) {
+	#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll( word );
+	#else
+	int bit = 0;
+	while( ( word & 1 ) == 0 ) {
+		word >>= 1;
+		bit++;
+	}
+	return bit;
+	#endif
+}
+
+/**
+ * @brief Allocate a bitmap with all bits cleared.
+ *
+ * @param bitmap The bitmap to initialize.
+ * @param size Number of bits.
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+int bitmapInit( Bitmap* bitmap, int size ) {
+	if( size < 0 ) {
+		size = 0;
+	}
+	int numWords = ( size + WORD_BITS - 1 ) / WORD_BITS;
+	bitmap->words = calloc( numWords > 0 ? numWords : 1, sizeof( uint64_t ) );
+	if( bitmap->words == NULL ) {
+		bitmap->size = 0;
+		return -1;
+	}
+	bitmap->size = size;
+	return 0;
+}
+
+/**
+ * @brief Release the memory held by a bitmap.
+ *
+ * @param bitmap The bitmap to free.
+ */
+void bitmapFree( Bitmap* bitmap ) {
+	free( bitmap->words );
+	bitmap->words = NULL;
+	bitmap->size = 0;
+}
+
+/**
+ * @brief Check whether a bit is set.
+ *
+ * @param bitmap The bitmap.
+ * @param bit Index of the bit.
+ * @return true if the bit is set, false if it is clear or out of range.
+ */
+bool bitmapTest( const Bitmap* bitmap, int bit ) {
+	if( bit < 0 || bit >= bitmap->size ) {
+		return false;
+	}
+	return ( bitmap->words[bit / WORD_BITS] >> ( bit % WORD_BITS ) ) & 1;
+}
+
+/**
+ * @brief Set a bit. Out-of-range indices are ignored.
+ *
+ * @param bitmap The bitmap.
+ * @param bit Index of the bit.
+ */
+void bitmapSet( Bitmap* bitmap, int bit ) {
+	if( bit < 0 || bit >= bitmap->size ) {
+		return;
+	}
+	bitmap->words[bit / WORD_BITS] |= 1ULL << ( bit % WORD_BITS );
+}
+
+/**
+ * @brief Clear a bit. Out-of-range indices are ignored.
+ *
+ * @param bitmap The bitmap.
+ * @param bit Index of the bit.
+ */
+void bitmapClear( Bitmap* bitmap, int bit ) {
+	if( bit < 0 || bit >= bitmap->size ) {
+		return;
+	}
+	bitmap->words[bit / WORD_BITS] &= ~( 1ULL << ( bit % WORD_BITS ) );
+}
+
+/**
+ * @brief Count the set bits.
+ *
+ * @param bitmap The bitmap.
+ * @return The number of set bits.
+ */
+int bitmapCount( const Bitmap* bitmap ) {
+	int numWords = ( bitmap->size + WORD_BITS - 1 ) / WORD_BITS;
+	int count = 0;
+	for( int i = 0; i < numWords; i++ ) {
+		count += popcountWord( bitmap->words[i] );
+	}
+	return count;
+}
+
+/**
+ * @brief Find the first clear bit at or after a position.
+ *
+ * @param bitmap The bitmap.
+ * @param from Index to start searching from.
+ * @return Index of the clear bit, or -1 if there is none.
+ */
+int bitmapNextClear( const Bitmap* bitmap, int from ) {
+	if( from < 0 ) {
+		from = 0;
+	}
+	if( from >= bitmap->size ) {
+		return -1;
+	}
+	int numWords = ( bitmap->size + WORD_BITS - 1 ) / WORD_BITS;
+	int w = from / WORD_BITS;
+	uint64_t word = ~bitmap->words[w] & ( ~0ULL << ( from % WORD_BITS ) );
+	while( word == 0 ) {
+		if( ++w >= numWords ) {
+			return -1;
+		}
+		word = ~bitmap->words[w];
+	}
+	int bit = w * WORD_BITS + lowestBit( word );
+	return bit < bitmap->size ? bit : -1;
+}
+
+/**
+ * @brief Find the first set bit at or after a position.
+ *
+ * @param bitmap The bitmap.
+ * @param from Index to start searching from.
+ * @return Index of the set bit, or -1 if there is none.
+ */
+int bitmapNextSet( const Bitmap* bitmap, int from ) {
+	if( from < 0 ) {
+		from = 0;
+	}
+	if( from >= bitmap->size ) {
+		return -1;
+	}
+	int numWords = ( bitmap->size + WORD_BITS - 1 ) / WORD_BITS;
+	int w = from / WORD_BITS;
+	uint64_t word = bitmap->words[w] & ( ~0ULL << ( from % WORD_BITS ) );
+	while( word == 0 ) {
+		if( ++w >= numWords ) {
+			return -1;
+		}
+		word = bitmap->words[w];
+	}
+	return w * WORD_BITS + lowestBit( word );
+}
+
+/**
+ * @brief Find the next run of clear bits inside a range.
+ *
+ * The run is located with two word-level scans, so full and empty stretches of 64 bits are skipped at once.
+ *
+ * @param bitmap The bitmap.
+ * @param from Index to start searching from.
+ * @param to End of the range (exclusive); the run is cut off there.
+ * @param runLength Pointer to store the length of the run.
+ * @return Index of the first bit of the run, or -1 if the range has no clear bit.
+ */
+int bitmapNextClearRun( const Bitmap* bitmap, int from, int to, int* runLength ) {
+	int start = bitmapNextClear( bitmap, from );
+	if( start < 0 || start >= to ) {
+		return -1;
+	}
+	int end = bitmapNextSet( bitmap, start );
+	if( end < 0 || end > to ) {
+		end = to;
+	}
+	*runLength = end - start;
+	return start;
+}
+
+/**
+ * @brief Set every bit of a range.
+ *
+ * Whole words inside the range are filled at once.
+ *
+ * @param bitmap The bitmap.
+ * @param from First bit of the range.
+ * @param to End of the range (exclusive); it is cut off at the size of the bitmap.
+ */
+void bitmapSetRange( Bitmap* bitmap, int from, int to ) {
+	if( from < 0 ) {
+		from = 0;
+	}
+	if( to > bitmap->size ) {
+		to = bitmap->size;
+	}
+	while( from < to ) {
+		int bit = from % WORD_BITS;
+		int count = to - from < WORD_BITS - bit ? to - from : WORD_BITS - bit;
+		bitmap->words[from / WORD_BITS] |= count == WORD_BITS ? ~0ULL : ( ( 1ULL << count ) - 1 ) << bit;
+		from += count;
+	}
+}
+
+/**
+ * @brief Keep only the bits that are also set in another bitmap, one word at a time.
+ *
+ * Bits beyond the size of the other bitmap are cleared.
+ *
+ * @param bitmap The bitmap to update.
+ * @param other The other bitmap.
+ */
+void bitmapAnd( Bitmap* bitmap, const Bitmap* other ) {
+	int numWords = ( bitmap->size + WORD_BITS - 1 ) / WORD_BITS;
+	int otherWords = ( other->size + WORD_BITS - 1 ) / WORD_BITS;
+	for( int w = 0; w < numWords; w++ ) {
+		bitmap->words[w] &= w < otherWords ? other->words[w] : 0;
+	}
+}
+
+/**
+ * @brief Set the bits that are set in another bitmap, one word at a time.
+ *
+ * @param bitmap The bitmap to update.
+ * @param other The other bitmap; bits beyond the size of the bitmap are ignored.
+ */
+void bitmapOr( Bitmap* bitmap, const Bitmap* other ) {
+	int numWords = ( bitmap->size + WORD_BITS - 1 ) / WORD_BITS;
+	int otherWords = ( other->size + WORD_BITS - 1 ) / WORD_BITS;
+	for( int w = 0; w < numWords && w < otherWords; w++ ) {
+		bitmap->words[w] |= other->words[w];
+	}
+	if( numWords > 0 && bitmap->size % WORD_BITS != 0 ) {
+		bitmap->words[numWords - 1] &= ( 1ULL << ( bitmap->size % WORD_BITS ) ) - 1;
+	}
+}
+
+/**
+ * @brief Clear the bits that are set in another bitmap, one word at a time.
+ *
+ * @param bitmap The bitmap to update.
+ * @param other The other bitmap.
+ */
+void bitmapAndNot( Bitmap* bitmap, const Bitmap* other ) {
+	int numWords = ( bitmap->size + WORD_BITS - 1 ) / WORD_BITS;
+	int otherWords = ( other->size + WORD_BITS - 1 ) / WORD_BITS;
+	for( int w = 0; w < numWords && w < otherWords; w++ ) {
+		bitmap->words[w] &= ~other->words[w];
+	}
+}
+
+/**
+ * @brief Read a number of a seat list, stopping once it passes a limit.
+ *
+ * @param text The seat list.
+ * @param length Number of characters of text to read.
+ * @param position Position of the first digit, advanced past the last one.
+ * @param limit The limit.
+ * @return The number, or limit if it is larger.
+ */
+static int parseListNumber( const char* text, size_t length, size_t* position, int limit ) {
+	int64_t value = 0;
+	for( ; *position < length && text[*position] >= '0' && text[*position] <= '9'; ( *position )++ ) {
+		if( value < limit ) {
+			value = value * 10 + ( text[*position] - '0' );
+		}
+	}
+	return value < limit ? (int)value : limit;
+}
+
+/**
+ * @brief Set the bits listed in a text seat list.
+ *
+ * Accepts the comma-separated form used by shows.txt ("2,14,7") as well as ranges ("1-30,45").
+ *
+ * @param bitmap The bitmap to update.
+ * @param text The seat list.
+ * @param length Number of characters of text to read.
+ * @return The number of listed numbers and ranges that reached past the end of the bitmap; their bits past the end
+ *         are skipped.
+ */
+int bitmapParseList( Bitmap* bitmap, const char* text, size_t length ) {
+	int skipped = 0;
+	size_t i = 0;
+	while( i < length ) {
+		if( text[i] < '0' || text[i] > '9' ) {
+			i++;
+			continue;
+		}
+		int first = parseListNumber( text, length, &i, bitmap->size );
+		int last = first;
+		if( i + 1 < length && text[i] == '-' && text[i + 1] >= '0' && text[i + 1] <= '9' ) {
+			i++;
+			last = parseListNumber( text, length, &i, bitmap->size );
+		}
+		if( last >= bitmap->size ) {
+			skipped++;
+			last = bitmap->size - 1;
+		}
+		for( int bit = first; bit <= last; bit++ ) {
+			bitmapSet( bitmap, bit );
+		}
+	}
+	return skipped;
+}
+
+/**
+ * @brief Write the set bits as a text seat list.
+ *
+ * Runs of three or more consecutive bits are written as ranges ("1-30"), others as single numbers.
+ *
+ * @param bitmap The bitmap.
+ * @param file The file to write to.
+ */
+void bitmapWriteList( const Bitmap* bitmap, FILE* file ) {
+	bool isFirst = true;
+	int first = bitmapNextSet( bitmap, 0 );
+	while( first >= 0 ) {
+		int end = bitmapNextClear( bitmap, first );
+		int last = ( end < 0 ? bitmap->size : end ) - 1;
+		if( !isFirst ) {
+			fputc( ',', file );
+		}
+		isFirst = false;
+		if( last - first >= 2 ) {
+			fprintf( file, "%d-%d", first, last );
+		} else if( last > first ) {
+			fprintf( file, "%d,%d", first, last );
+		} else {
+			fprintf( file, "%d", first );
+		}
+		first = end < 0 ? -1 : bitmapNextSet( bitmap, end );
+	}
+}
@@ -0,0 +1,163 @@
+/**
+ * @file include/bitmap.h
+ */
+
+#ifndef BITMAP_H
+#define BITMAP_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Fixed-size bit set stored in 64-bit words.
+ *
+ * Used as a seat map: bit n is set when seat n is booked. Bit 0 is never used by seats so seat numbers can be
+ * used as bit indices directly.
+ */
+typedef struct {
+	uint64_t* words;
+	int size;
+} Bitmap;
+
+/**
+ * @brief Allocate a bitmap with all bits cleared.
+ *
+ * @param bitmap The bitmap to initialize.
+ * @param size Number of bits.
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+int bitmapInit( Bitmap* bitmap, int size );
+
+/**
+ * @brief Release the memory held by a bitmap.
+ *
+ * @param bitmap The bitmap to free.
+ */
+void bitmapFree( Bitmap* bitmap );
+
+/**
+ * @brief Check whether a bit is set.
+ *
+ * @param bitmap The bitmap.
+ * @param bit Index of the bit.
+ * @return true if the bit is set, false if it is clear or out of range.
+ */
+bool bitmapTest( const Bitmap* bitmap, int bit );
+
+/**
+ * @brief Set a bit. Out-of-range indices are ignored.
+ *
+ * @param bitmap The bitmap.
+ * @param bit Index of the bit.
+ */
+void bitmapSet( Bitmap* bitmap, int bit );
+
+/**
+ * @brief Clear a bit. Out-of-range indices are ignored.
+ *
+ * @param bitmap The bitmap.
+ * @param bit Index of the bit.
+ */
+void bitmapClear( Bitmap* bitmap, int bit );
+
+/**
+ * @brief Count the set bits.
+ *
+ * @param bitmap The bitmap.
+ * @return The number of set bits.
+ */
+int bitmapCount( const Bitmap* bitmap );
+
+/**
+ * @brief Find the first clear bit at or after a position.
+ *
+ * @param bitmap The bitmap.
+ * @param from Index to start searching from.
+ * @return Index of the clear bit, or -1 if there is none.
+ */
+int bitmapNextClear( const Bitmap* bitmap, int from );
+
+/**
+ * @brief Find the first set bit at or after a position.
+ *
+ * @param bitmap The bitmap.
+ * @param from Index to start searching from.
+ * @return Index of the set bit, or -1 if there is none.
+ */
+int bitmapNextSet( const Bitmap* bitmap, int from );
+
+/**
+ * @brief Find the next run of clear bits inside a range.
+ *
+ * The run is located with two word-level scans, so full and empty stretches of 64 bits are skipped at once.
+ *
+ * @param bitmap The bitmap.
+ * @param from Index to start searching from.
+ * @param to End of the range (exclusive); the run is cut off there.
+ * @param runLength Pointer to store the length of the run.
+ * @return Index of the first bit of the run, or -1 if the range has no clear bit.
+ */
+int bitmapNextClearRun( const Bitmap* bitmap, int from, int to, int* runLength );
+
+/**
+ * @brief Set every bit of a range.
+ *
+ * Whole words inside the range are filled at once.
+ *
+ * @param bitmap The bitmap.
+ * @param from First bit of the range.
+ * @param to End of the range (exclusive); it is cut off at the size of the bitmap.
+ */
+void bitmapSetRange( Bitmap* bitmap, int from, int to );
+
+/**
+ * @brief Keep only the bits that are also set in another bitmap, one word at a time.
+ *
+ * Bits beyond the size of the other bitmap are cleared.
+ *
+ * @param bitmap The bitmap to update.
+ * @param other The other bitmap.
+ */
+void bitmapAnd( Bitmap* bitmap, const Bitmap* other );
+
+/**
+ * @brief Set the bits that are set in another bitmap, one word at a time.
+ *
+ * @param bitmap The bitmap to update.
+ * @param other The other bitmap; bits beyond the size of the bitmap are ignored.
+ */
+void bitmapOr( Bitmap* bitmap, const Bitmap* other );
+
+/**
+ * @brief Clear the bits that are set in another bitmap, one word at a time.
+ *
+ * @param bitmap The bitmap to update.
+ * @param other The other bitmap.
+ */
+void bitmapAndNot( Bitmap* bitmap, const Bitmap* other );
+
+/**
+ * @brief Set the bits listed in a text seat list.
+ *
+ * Accepts the comma-separated form used by shows.txt ("2,14,7") as well as ranges ("1-30,45").
+ *
+ * @param bitmap The bitmap to update.
+ * @param text The seat list.
+ * @param length Number of characters of text to read.
+ * @return The number of listed numbers and ranges that reached past the end of the bitmap; their bits past the end
+ *         are skipped.
+ */
+int bitmapParseList( Bitmap* bitmap, const char* text, size_t length );
+
+/**
+ * @brief Write the set bits as a text seat list.
+ *
+ * Runs of three or more consecutive bits are written as ranges ("1-30"), others as single numbers.
+ *
+ * @param bitmap The bitmap.
+ * @param file The file to write to.
+ */
+void bitmapWriteList( const Bitmap* bitmap, FILE* file );
+
+#endif // BITMAP_H
@@ -0,0 +1,565 @@
+/**
+ * @file src/booking.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/booking.h"
+#include "../include/storelock.h"
+#include "../include/catalog.h"
+#include "../include/tickets.h"
+#include "../include/login.h"
+#include "../include/stats.h"
+#include "../include/holds.h"
+#include "../include/ids.h"
+
+#define SHOW_LOCK_STRIPES 64
+
+#if defined(_WIN32) || defined(_WIN64)
+
+#include <windows.h>
+
+static SRWLOCK showLocks[SHOW_LOCK_STRIPES];
+
+#define prepareLocks()
+#define lockShow( showId ) AcquireSRWLockExclusive( &showLocks[(unsigned)( showId ) % SHOW_LOCK_STRIPES] )
+#define unlockShow( showId ) ReleaseSRWLockExclusive( &showLocks[(unsigned)( showId ) % SHOW_LOCK_STRIPES] )
+
+#else
+
+#include <pthread.h>
+
+static pthread_mutex_t showLocks[SHOW_LOCK_STRIPES];
+static pthread_once_t locksPrepared = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Initialize the show locks.
+ */
+static void initShowLocks() {
+	for( int i = 0; i < SHOW_LOCK_STRIPES; i++ ) {
+		pthread_mutex_init( &showLocks[i], NULL );
+	}
+}
+
+#define prepareLocks() pthread_once( &locksPrepared, initShowLocks )
+#define lockShow( showId ) pthread_mutex_lock( &showLocks[(unsigned)( showId ) % SHOW_LOCK_STRIPES] )
+#define unlockShow( showId ) pthread_mutex_unlock( &showLocks[(unsigned)( showId ) % SHOW_LOCK_STRIPES] )
+
+#endif
+
+static Table accounts = { .itemSize = sizeof( User ) };
+static bool accountsLoaded = false;
+
+/**
+ * @brief Check that a list of seats can be booked.
+ *
+ * @param show The show, whose lock is held.
+ * @param seats The seat numbers.
+ * @param count Number of seats.
+ * @return BOOKING_OK, or a negative BOOKING_ error code.
+ */
+static int checkSeats( const Show* show, const int seats[], int count ) {
+	if( count < 1 || count > show->seats ) {
+		return BOOKING_BAD_SEAT;
+	}
+	if( count > getAvailableSeats( show ) ) {
+		return BOOKING_SEAT_TAKEN;
+	}
+	for( int i = 0; i < count; i++ ) {
+		if( seats[i] < 1 || seats[i] > show->seats ) {
+			return BOOKING_BAD_SEAT;
+		}
+		if( !isSeatFree( show, seats[i] ) ) {
+			return BOOKING_SEAT_TAKEN;
+		}
+		for( int j = 0; j < i; j++ ) {
+			if( seats[j] == seats[i] ) {
+				return BOOKING_BAD_SEAT;
+			}
+		}
+	}
+	return BOOKING_OK;
+}
+
+/**
+ * @brief Check that a credential can be stored in the users database.
+ *
+ * @param text The username or password.
+ * @return true if it is non-empty and free of field separators.
+ */
+static bool isValidCredential( const char* text ) {
+	return text[0] != '\0' && strpbrk( text, "|\r\n" ) == NULL;
+}
+
+/**
+ * @brief Check that the payment fields of a booking can be stored in a journal record.
+ *
+ * @param paymentMethod The payment method.
+ * @param paymentAccount The payment account number.
+ * @return true if both are non-empty and free of field separators.
+ */
+static bool isValidPayment( const char* paymentMethod, const char* paymentAccount ) {
+	return isValidCredential( paymentMethod ) && isValidCredential( paymentAccount );
+}
+
+/**
+ * @brief Generate the ticket and transaction numbers of a booking before any lock is taken.
+ *
+ * @param booked Array of count entries whose ticket numbers are filled in.
+ * @param count Number of tickets.
+ * @param transactionNumber Buffer to store the transaction number in.
+ * @return 0 on success, -1 if the numbers could not be generated.
+ */
+static int prepareBooking( BookedTicket booked[], int count, char transactionNumber[TRANSACTION_NUMBER_LENGTH] ) {
+	if( nextTransactionNumber( transactionNumber, TRANSACTION_NUMBER_LENGTH ) != 0 ) {
+		return -1;
+	}
+	for( int i = 0; i < count; i++ ) {
+		if( nextTicketNumber( booked[i].ticketNumber, TICKET_NUMBER_LENGTH ) != 0 ) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief Store the tickets of checked seats.
+ *
+ * Ticket numbers are checked against the store with the lock taken for reading and drawn again without it, since
+ * drawing one may touch the disk; only storing the tickets takes the store lock exclusively.
+ *
+ * @param userId The ID of the user.
+ * @param showId The ID of the show, whose lock is held.
+ * @param seats The seat numbers, all free.
+ * @param count Number of seats.
+ * @param paymentMethod The payment method; must be non-empty and must not contain '|' or line breaks.
+ * @param paymentAccount The payment account number; must be non-empty and must not contain '|' or line breaks.
+ * @param booked Array of count entries holding the ticket numbers; the ticket IDs and seats are filled in.
+ * @param transactionNumber The transaction number.
+ * @return BOOKING_OK, or BOOKING_FAILED if the tickets could not be stored, in which case none of them is.
+ */
+static int issueTickets( int userId, int showId, const int seats[], int count, const char* paymentMethod,
+						 const char* paymentAccount, BookedTicket booked[], const char* transactionNumber ) {
+	for( int i = 0; i < count; i++ ) {
+		// tickets sold before numbers came from the ID sequences have random numbers that may coincide; numbers
+		// drawn from the sequences never do, so a number found free here stays free until it is stored
+		bool taken = true;
+		while( taken ) {
+			lockStoreForReading();
+			taken = getTicketByNumber( booked[i].ticketNumber ) != NULL;
+			unlockStoreForReading();
+			if( taken && nextTicketNumber( booked[i].ticketNumber, TICKET_NUMBER_LENGTH ) != 0 ) {
+				return BOOKING_FAILED;
+			}
+		}
+	}
+	Ticket* tickets = malloc( sizeof( Ticket ) * count );
+	if( tickets == NULL ) {
+		return BOOKING_FAILED;
+	}
+	lockStore();
+	StrId method = internString( paymentMethod, strlen( paymentMethod ) );
+	StrId account = internString( paymentAccount, strlen( paymentAccount ) );
+	StrId transaction = internString( transactionNumber, strlen( transactionNumber ) );
+	for( int i = 0; i < count; i++ ) {
+		tickets[i].ticketNumber = storeString( booked[i].ticketNumber, strlen( booked[i].ticketNumber ) );
+		tickets[i].userId = userId;
+		tickets[i].showId = showId;
+		tickets[i].seatNumber = seats[i];
+		tickets[i].paymentMethod = method;
+		tickets[i].paymentAccount = account;
+		tickets[i].transactionNumber = transaction;
+		tickets[i].status = 1;
+	}
+	int result = addTickets( tickets, count ) == 0 ? BOOKING_OK : BOOKING_FAILED;
+	unlockStore();
+	for( int i = 0; i < count; i++ ) {
+		booked[i].ticketId = tickets[i].id;
+		booked[i].seatNumber = seats[i];
+	}
+	free( tickets );
+	return result;
+}
+
+/**
+ * @brief Book seats of a show for a user and store the tickets.
+ *
+ * The seats are checked and booked while holding the lock of the show, so concurrent bookings of the same seat
+ * cannot both succeed while bookings of different shows proceed in parallel. Returns once the tickets are on disk;
+ * concurrent bookings share one journal sync.
+ *
+ * @param userId The ID of the user.
+ * @param showId The ID of the show.
+ * @param seats The seat numbers.
+ * @param count Number of seats.
+ * @param paymentMethod The payment method; must be non-empty and must not contain '|' or line breaks.
+ * @param paymentAccount The payment account number; must be non-empty and must not contain '|' or line breaks.
+ * @param booked Array of count entries to store the created tickets in.
+ * @param transactionNumber Buffer to store the transaction number in.
+ * @return BOOKING_OK, or a negative BOOKING_ error code if nothing was booked.
+ */
+int bookSeats( int userId, int showId, const int seats[], int count, const char* paymentMethod,
+			   const char* paymentAccount, BookedTicket booked[], char transactionNumber[TRANSACTION_NUMBER_LENGTH] ) {
+	releaseExpiredHolds();
+	StatTimer timer;
+	startTimer( &timer, STAT_BUY );
+	Show* show = getShowById( showId );
+	if( show == NULL ) {
+		stopTimer( &timer );
+		return BOOKING_NO_SHOW;
+	}
+	if( !isValidPayment( paymentMethod, paymentAccount ) ) {
+		stopTimer( &timer );
+		return BOOKING_BAD_PAYMENT;
+	}
+	if( prepareBooking( booked, count, transactionNumber ) != 0 ) {
+		stopTimer( &timer );
+		return BOOKING_FAILED;
+	}
+	lockShow( showId );
+	int result = checkSeats( show, seats, count );
+	if( result == BOOKING_OK ) {
+		result = issueTickets( userId, showId, seats, count, paymentMethod, paymentAccount, booked, transactionNumber );
+	}
+	unlockShow( showId );
+	if( result == BOOKING_OK && commitTickets() != 0 ) {
+		result = BOOKING_FAILED;
+	}
+	stopTimer( &timer );
+	return result;
+}
+
+/**
+ * @brief Book adjacent seats of a show chosen by the seat allocator.
+ *
+ * The seats are found and booked while holding the lock of the show, so no other booking can take them in between.
+ *
+ * @param userId The ID of the user.
+ * @param showId The ID of the show.
+ * @param count Number of adjacent seats.
+ * @param seatsPerRow Seats per row, or 0 to treat the show as a single row; see findAdjacentSeats().
+ * @param bestFit true to take the shortest free run that fits, false to take the first one.
+ * @param paymentMethod The payment method; must be non-empty and must not contain '|' or line breaks.
+ * @param paymentAccount The payment account number; must be non-empty and must not contain '|' or line breaks.
+ * @param booked Array of count entries to store the created tickets in.
+ * @param transactionNumber Buffer to store the transaction number in.
+ * @return BOOKING_OK, or a negative BOOKING_ error code if nothing was booked.
+ */
+int bookAdjacentSeats( int userId, int showId, int count, int seatsPerRow, bool bestFit, const char* paymentMethod,
+					   const char* paymentAccount, BookedTicket booked[],
+					   char transactionNumber[TRANSACTION_NUMBER_LENGTH] ) {
+	releaseExpiredHolds();
+	StatTimer timer;
+	startTimer( &timer, STAT_BUY );
+	Show* show = getShowById( showId );
+	if( show == NULL || count < 1 ) {
+		stopTimer( &timer );
+		return show == NULL ? BOOKING_NO_SHOW : BOOKING_BAD_SEAT;
+	}
+	if( !isValidPayment( paymentMethod, paymentAccount ) ) {
+		stopTimer( &timer );
+		return BOOKING_BAD_PAYMENT;
+	}
+	int* seats = malloc( sizeof( int ) * count );
+	if( seats == NULL || prepareBooking( booked, count, transactionNumber ) != 0 ) {
+		free( seats );
+		stopTimer( &timer );
+		return BOOKING_FAILED;
+	}
+	lockShow( showId );
+	int result = BOOKING_NO_ADJACENT;
+	int first = findAdjacentSeats( show, count, seatsPerRow, bestFit );
+	if( first >= 0 ) {
+		for( int i = 0; i < count; i++ ) {
+			seats[i] = first + i;
+		}
+		result = issueTickets( userId, showId, seats, count, paymentMethod, paymentAccount, booked, transactionNumber );
+	}
+	unlockShow( showId );
+	if( result == BOOKING_OK && commitTickets() != 0 ) {
+		result = BOOKING_FAILED;
+	}
+	free( seats );
+	stopTimer( &timer );
+	return result;
+}
+
+/**
+ * @brief Release the seats of a removed hold in the catalog.
+ *
+ * @param hold The hold, whose seats are still marked as held.
+ */
+static void unmarkHold( const SeatHold* hold ) {
+	Show* show = getShowById( hold->showId );
+	if( show == NULL ) {
+		return;
+	}
+	lockShow( hold->showId );
+	lockStore();
+	for( int i = 0; i < hold->count; i++ ) {
+		setSeatHeld( show, hold->seats[i], false );
+	}
+	unlockStore();
+	unlockShow( hold->showId );
+}
+
+/**
+ * @brief Give the seats of expired holds back to sale.
+ *
+ * The timer wheel only visits the seconds that passed since the last call, so this is cheap enough to run before
+ * every booking and listing.
+ */
+void releaseExpiredHolds() {
+	prepareLocks();
+	SeatHold expired[64];
+	int numExpired;
+	do {
+		numExpired = takeExpiredHolds( expired, 64 );
+		for( int i = 0; i < numExpired; i++ ) {
+			unmarkHold( &expired[i] );
+			freeHold( &expired[i] );
+		}
+	} while( numExpired == 64 );
+}
+
+/**
+ * @brief Hold seats of a show for a user while they pay.
+ *
+ * Held seats are not free for anyone else until the hold is confirmed, released or expires after getHoldSeconds().
+ *
+ * @param userId The ID of the user.
+ * @param showId The ID of the show.
+ * @param seats The seat numbers.
+ * @param count Number of seats.
+ * @return The ID of the hold, or a negative BOOKING_ error code if nothing was held.
+ */
+int holdSeats( int userId, int showId, const int seats[], int count ) {
+	releaseExpiredHolds();
+	Show* show = getShowById( showId );
+	if( show == NULL ) {
+		return BOOKING_NO_SHOW;
+	}
+	lockShow( showId );
+	int result = checkSeats( show, seats, count );
+	if( result == BOOKING_OK ) {
+		result = addHold( userId, showId, seats, count );
+		if( result < 0 ) {
+			result = BOOKING_FAILED;
+		} else {
+			lockStore();
+			for( int i = 0; i < count; i++ ) {
+				setSeatHeld( show, seats[i], true );
+			}
+			unlockStore();
+		}
+	}
+	unlockShow( showId );
+	return result;
+}
+
+/**
+ * @brief Pay for held seats and store their tickets.
+ *
+ * @param holdId The ID of the hold.
+ * @param userId The ID of the user who must own the hold.
+ * @param paymentMethod The payment method; must be non-empty and must not contain '|' or line breaks.
+ * @param paymentAccount The payment account number; must be non-empty and must not contain '|' or line breaks.
+ * @param maxTickets Number of entries of booked.
+ * @param booked Array to store the created tickets in, one per held seat.
+ * @param transactionNumber Buffer to store the transaction number in.
+ * @return The number of tickets, or a negative BOOKING_ error code if nothing was booked.
+ */
+int confirmHold( int holdId, int userId, const char* paymentMethod, const char* paymentAccount, int maxTickets,
+				 BookedTicket booked[], char transactionNumber[TRANSACTION_NUMBER_LENGTH] ) {
+	releaseExpiredHolds();
+	StatTimer timer;
+	startTimer( &timer, STAT_BUY );
+	// checked before the hold is taken, so the seats stay held for another attempt
+	if( !isValidPayment( paymentMethod, paymentAccount ) ) {
+		stopTimer( &timer );
+		return BOOKING_BAD_PAYMENT;
+	}
+	SeatHold hold;
+	if( !takeHold( holdId, userId, &hold ) ) {
+		stopTimer( &timer );
+		return BOOKING_NO_HOLD;
+	}
+	Show* show = getShowById( hold.showId );
+	int result = show == NULL ? BOOKING_NO_SHOW : hold.count > maxTickets ? BOOKING_FAILED : BOOKING_OK;
+	if( result == BOOKING_OK && prepareBooking( booked, hold.count, transactionNumber ) != 0 ) {
+		result = BOOKING_FAILED;
+	}
+	if( result == BOOKING_OK ) {
+		lockShow( hold.showId );
+		lockStore();
+		for( int i = 0; i < hold.count; i++ ) {
+			setSeatHeld( show, hold.seats[i], false );
+		}
+		unlockStore();
+		result = issueTickets( userId, hold.showId, hold.seats, hold.count, paymentMethod, paymentAccount, booked,
+							   transactionNumber );
+		unlockShow( hold.showId );
+		if( result == BOOKING_OK && commitTickets() != 0 ) {
+			result = BOOKING_FAILED;
+		}
+	} else {
+		unmarkHold( &hold );
+	}
+	int count = hold.count;
+	freeHold( &hold );
+	stopTimer( &timer );
+	return result == BOOKING_OK ? count : result;
+}
+
+/**
+ * @brief Give held seats back to sale before the hold expires.
+ *
+ * @param holdId The ID of the hold.
+ * @param userId The ID of the user who must own the hold, or -1 to skip the check.
+ * @return BOOKING_OK, or BOOKING_NO_HOLD if the hold does not exist or has expired.
+ */
+int releaseHold( int holdId, int userId ) {
+	prepareLocks();
+	SeatHold hold;
+	if( !takeHold( holdId, userId, &hold ) ) {
+		return BOOKING_NO_HOLD;
+	}
+	unmarkHold( &hold );
+	freeHold( &hold );
+	return BOOKING_OK;
+}
+
+/**
+ * @brief Change the status of a ticket, booking or releasing its seat under the lock of its show.
+ *
+ * @param ticketId The ID of the ticket.
+ * @param userId The ID of the user who must own the ticket, or -1 to skip the check.
+ * @param status The new status, 1 for active and 0 for canceled.
+ * @return BOOKING_OK, or a negative BOOKING_ error code.
+ */
+int changeTicketStatus( int ticketId, int userId, int status ) {
+	prepareLocks();
+	StatTimer timer;
+	startTimer( &timer, STAT_CANCEL );
+	lockStoreForReading();
+	const Ticket* ticket = getTicketById( ticketId );
+	int showId = ticket != NULL ? ticket->showId : 0;
+	unlockStoreForReading();
+	if( ticket == NULL ) {
+		stopTimer( &timer );
+		return BOOKING_NO_TICKET;
+	}
+	lockShow( showId );
+	lockStore();
+	int result = BOOKING_OK;
+	Show* show = getShowById( showId );
+	if( userId >= 0 && ticket->userId != userId ) {
+		result = BOOKING_NOT_OWNER;
+	} else if( ticket->status == status ) {
+		result = BOOKING_UNCHANGED;
+	} else if( status && show != NULL && !isSeatFree( show, ticket->seatNumber ) ) {
+		result = BOOKING_SEAT_TAKEN;
+	} else if( setTicketStatus( ticketId, status ) != 0 ) {
+		result = BOOKING_FAILED;
+	}
+	unlockStore();
+	unlockShow( showId );
+	if( result == BOOKING_OK && commitTickets() != 0 ) {
+		result = BOOKING_FAILED;
+	}
+	stopTimer( &timer );
+	return result;
+}
+
+/**
+ * @brief Register a user account.
+ *
+ * @param username The username; must be non-empty and must not contain '|'.
+ * @param password The password; must be non-empty and must not contain '|'.
+ * @return The ID of the new user, or a negative BOOKING_ error code.
+ */
+int registerAccount( const char* username, const char* password ) {
+	if( !isValidCredential( username ) || !isValidCredential( password ) ) {
+		return BOOKING_BAD_LOGIN;
+	}
+	prepareLocks();
+	lockStore();
+	if( !accountsLoaded ) {
+		loadUsersFromFile( &accounts );
+		accountsLoaded = true;
+	}
+	int userId = BOOKING_USER_EXISTS;
+	if( findUserByName( &accounts, username ) < 0 ) {
+		userId = addUser( &accounts, username, password );
+		if( userId >= 0 ) {
+			saveUsersToFile( &accounts );
+		} else {
+			userId = BOOKING_FAILED;
+		}
+	}
+	unlockStore();
+	return userId;
+}
+
+/**
+ * @brief Check the credentials of a user account.
+ *
+ * @param username The username.
+ * @param password The password.
+ * @return The ID of the user, or BOOKING_BAD_LOGIN.
+ */
+int authenticateAccount( const char* username, const char* password ) {
+	prepareLocks();
+	lockStoreForReading();
+	bool loaded = accountsLoaded;
+	int userId = loaded ? authenticateUser( &accounts, username, password ) : -1;
+	unlockStoreForReading();
+	if( !loaded ) {
+		lockStore();
+		if( !accountsLoaded ) {
+			loadUsersFromFile( &accounts );
+			accountsLoaded = true;
+		}
+		userId = authenticateUser( &accounts, username, password );
+		unlockStore();
+	}
+	return userId >= 0 ? userId : BOOKING_BAD_LOGIN;
+}
+
+/**
+ * @brief Describe a booking error code.
+ *
+ * @param code The error code.
+ * @return The description.
+ */
+const char* getBookingError( int code ) {
+	switch( code ) {
+		case BOOKING_OK:
+			return "ok";
+		case BOOKING_NO_SHOW:
+			return "show not found";
+		case BOOKING_BAD_SEAT:
+			return "seat does not exist";
+		case BOOKING_SEAT_TAKEN:
+			return "seat is already booked";
+		case BOOKING_NO_TICKET:
+			return "ticket not found";
+		case BOOKING_NOT_OWNER:
+			return "ticket belongs to another user";
+		case BOOKING_UNCHANGED:
+			return "ticket already has that status";
+		case BOOKING_USER_EXISTS:
+			return "username already exists";
+		case BOOKING_BAD_LOGIN:
+			return "invalid username or password";
+		case BOOKING_NO_ADJACENT:
+			return "not enough adjacent free seats";
+		case BOOKING_NO_HOLD:
+			return "seat hold not found or expired";
+		case BOOKING_BAD_PAYMENT:
+			return "invalid payment method or account";
+		default:
+			return "system error";
+	}
+}
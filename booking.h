@@ -0,0 +1,158 @@
+/**
+ * @file include/booking.h
+ */
+
+#ifndef BOOKING_H
+#define BOOKING_H
+
+#include "utilities.h"
+#include "storelock.h"
+
+#define BOOKING_OK 0
+#define BOOKING_NO_SHOW -1
+#define BOOKING_BAD_SEAT -2
+#define BOOKING_SEAT_TAKEN -3
+#define BOOKING_NO_TICKET -4
+#define BOOKING_NOT_OWNER -5
+#define BOOKING_UNCHANGED -6
+#define BOOKING_FAILED -7
+#define BOOKING_USER_EXISTS -8
+#define BOOKING_BAD_LOGIN -9
+#define BOOKING_NO_ADJACENT -10
+#define BOOKING_NO_HOLD -11
+#define BOOKING_BAD_PAYMENT -12
+
+#define TICKET_NUMBER_LENGTH 10
+#define TRANSACTION_NUMBER_LENGTH 10
+
+/**
+ * @brief A ticket created by bookSeats().
+ */
+typedef struct {
+	int ticketId;
+	int seatNumber;
+	char ticketNumber[TICKET_NUMBER_LENGTH];
+} BookedTicket;
+
+/**
+ * @brief Book seats of a show for a user and store the tickets.
+ *
+ * The seats are checked and booked while holding the lock of the show, so concurrent bookings of the same seat
+ * cannot both succeed while bookings of different shows proceed in parallel. Returns once the tickets are on disk;
+ * concurrent bookings share one journal sync.
+ *
+ * @param userId The ID of the user.
+ * @param showId The ID of the show.
+ * @param seats The seat numbers.
+ * @param count Number of seats.
+ * @param paymentMethod The payment method; must be non-empty and must not contain '|' or line breaks.
+ * @param paymentAccount The payment account number; must be non-empty and must not contain '|' or line breaks.
+ * @param booked Array of count entries to store the created tickets in.
+ * @param transactionNumber Buffer to store the transaction number in.
+ * @return BOOKING_OK, or a negative BOOKING_ error code if nothing was booked.
+ */
+int bookSeats( int userId, int showId, const int seats[], int count, const char* paymentMethod,
+			   const char* paymentAccount, BookedTicket booked[], char transactionNumber[TRANSACTION_NUMBER_LENGTH] );
+
+/**
+ * @brief Book adjacent seats of a show chosen by the seat allocator.
+ *
+ * The seats are found and booked while holding the lock of the show, so no other booking can take them in between.
+ *
+ * @param userId The ID of the user.
+ * @param showId The ID of the show.
+ * @param count Number of adjacent seats.
+ * @param seatsPerRow Seats per row, or 0 to treat the show as a single row; see findAdjacentSeats().
+ * @param bestFit true to take the shortest free run that fits, false to take the first one.
+ * @param paymentMethod The payment method; must be non-empty and must not contain '|' or line breaks.
+ * @param paymentAccount The payment account number; must be non-empty and must not contain '|' or line breaks.
+ * @param booked Array of count entries to store the created tickets in.
+ * @param transactionNumber Buffer to store the transaction number in.
+ * @return BOOKING_OK, or a negative BOOKING_ error code if nothing was booked.
+ */
+int bookAdjacentSeats( int userId, int showId, int count, int seatsPerRow, bool bestFit, const char* paymentMethod,
+					   const char* paymentAccount, BookedTicket booked[],
+					   char transactionNumber[TRANSACTION_NUMBER_LENGTH] );
+
+/**
+ * @brief Give the seats of expired holds back to sale.
+ *
+ * The timer wheel only visits the seconds that passed since the last call, so this is cheap enough to run before
+ * every booking and listing.
+ */
+void releaseExpiredHolds();
+
+/**
+ * @brief Hold seats of a show for a user while they pay.
+ *
+ * Held seats are not free for anyone else until the hold is confirmed, released or expires after getHoldSeconds().
+ *
+ * @param userId The ID of the user.
+ * @param showId The ID of the show.
+ * @param seats The seat numbers.
+ * @param count Number of seats.
+ * @return The ID of the hold, or a negative BOOKING_ error code if nothing was held.
+ */
+int holdSeats( int userId, int showId, const int seats[], int count );
+
+/**
+ * @brief Pay for held seats and store their tickets.
+ *
+ * @param holdId The ID of the hold.
+ * @param userId The ID of the user who must own the hold.
+ * @param paymentMethod The payment method; must be non-empty and must not contain '|' or line breaks.
+ * @param paymentAccount The payment account number; must be non-empty and must not contain '|' or line breaks.
+ * @param maxTickets Number of entries of booked.
+ * @param booked Array to store the created tickets in, one per held seat.
+ * @param transactionNumber Buffer to store the transaction number in.
+ * @return The number of tickets, or a negative BOOKING_ error code if nothing was booked.
+ */
+int confirmHold( int holdId, int userId, const char* paymentMethod, const char* paymentAccount, int maxTickets,
+				 BookedTicket booked[], char transactionNumber[TRANSACTION_NUMBER_LENGTH] );
+
+/**
+ * @brief Give held seats back to sale before the hold expires.
+ *
+ * @param holdId The ID of the hold.
+ * @param userId The ID of the user who must own the hold, or -1 to skip the check.
+ * @return BOOKING_OK, or BOOKING_NO_HOLD if the hold does not exist or has expired.
+ */
+int releaseHold( int holdId, int userId );
+
+/**
+ * @brief Change the status of a ticket, booking or releasing its seat under the lock of its show.
+ *
+ * @param ticketId The ID of the ticket.
+ * @param userId The ID of the user who must own the ticket, or -1 to skip the check.
+ * @param status The new status, 1 for active and 0 for canceled.
+ * @return BOOKING_OK, or a negative BOOKING_ error code.
+ */
+int changeTicketStatus( int ticketId, int userId, int status );
+
+/**
+ * @brief Register a user account.
+ *
+ * @param username The username; must be non-empty and must not contain '|'.
+ * @param password The password; must be non-empty and must not contain '|'.
+ * @return The ID of the new user, or a negative BOOKING_ error code.
+ */
+int registerAccount( const char* username, const char* password );
+
+/**
+ * @brief Check the credentials of a user account.
+ *
+ * @param username The username.
+ * @param password The password.
+ * @return The ID of the user, or BOOKING_BAD_LOGIN.
+ */
+int authenticateAccount( const char* username, const char* password );
+
+/**
+ * @brief Describe a booking error code.
+ *
+ * @param code The error code.
+ * @return The description.
+ */
+const char* getBookingError( int code );
+
+#endif // BOOKING_H
@@ -0,0 +1,557 @@
+/**
+ * @file src/catalog.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "../include/catalog.h"
+#include "../include/table.h"
+#include "../include/intmap.h"
+#include "../include/datafile.h"
+#include "../include/snapshot.h"
+#include "../include/stats.h"
+#include "../include/search.h"
+#include "../include/facets.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+	#include <windows.h>
+#endif
+
+/**
+ * @brief Entry of the date index: a day number and the position of the show in the catalog.
+ */
+typedef struct {
+	int day;
+	int index;
+} ShowDate;
+
+static Table catalogShows = { .itemSize = sizeof( Show ) };
+static IntMap showIndex;
+static ShowDate* showsByDate = NULL;
+static char catalogFilename[MAX_LENGTH] = "";
+static uint64_t catalogJournalOffset = 0;
+static bool catalogSnapshotCurrent = false;
+
+/**
+ * @brief Row of a show in the catalog snapshot; strings and the seat map are heap offsets.
+ */
+typedef struct {
+	int32_t id;
+	int32_t price;
+	int32_t seats;
+	int32_t available;
+	int32_t day;
+	uint32_t singer;
+	uint32_t date;
+	uint32_t venue;
+	uint32_t type;
+	uint32_t booked;
+} ShowRecord;
+
+/**
+ * @brief Order date index entries by day, then by position in the catalog.
+ */
+static int compareShowDates( const void* a, const void* b ) {
+	const ShowDate* x = a;
+	const ShowDate* y = b;
+	if( x->day != y->day ) {
+		return x->day < y->day ? -1 : 1;
+	}
+	return ( x->index > y->index ) - ( x->index < y->index );
+}
+
+/**
+ * @brief Build the index of the catalog in date order and store the position of every show in it.
+ *
+ * @return 0 on success, -1 if the index could not be allocated.
+ */
+static int buildDateIndex() {
+	free( showsByDate );
+	showsByDate = malloc( sizeof( ShowDate ) * ( catalogShows.count + 1 ) );
+	if( showsByDate == NULL ) {
+		return -1;
+	}
+	for( int i = 0; i < catalogShows.count; i++ ) {
+		showsByDate[i].day = ( (const Show*)tableAt( &catalogShows, i ) )->day;
+		showsByDate[i].index = i;
+	}
+	qsort( showsByDate, catalogShows.count, sizeof( ShowDate ), compareShowDates );
+	for( int i = 0; i < catalogShows.count; i++ ) {
+		( (Show*)tableAt( &catalogShows, showsByDate[i].index ) )->position = i;
+	}
+	return 0;
+}
+
+/**
+ * @brief Load the catalog from its snapshot.
+ *
+ * @param filename The name of the shows database file the snapshot must match.
+ * @return The number of loaded shows, or -1 if the snapshot is missing, stale or damaged.
+ */
+static int loadShowsFromSnapshot( const char* filename ) {
+	char snapshotName[MAX_LENGTH];
+	getSnapshotFilename( filename, snapshotName, sizeof( snapshotName ) );
+	Snapshot snapshot;
+	if( openSnapshot( &snapshot, snapshotName, filename, sizeof( ShowRecord ) ) != 0 ) {
+		return -1;
+	}
+	bool valid = true;
+	for( uint64_t i = 0; valid && i < snapshot.header->rowCount; i++ ) {
+		const ShowRecord* record = getSnapshotRow( &snapshot, i );
+		Show show;
+		show.id = record->id;
+		show.price = record->price;
+		show.seats = record->seats;
+		show.available = record->available;
+		show.heldSeats = 0;
+		show.held = (Bitmap){ 0 };
+		show.day = record->day;
+		size_t numWords = ( (size_t)record->seats + 64 ) / 64;
+		const uint64_t* words = getSnapshotWords( &snapshot, record->booked, numWords );
+		if( record->seats < 0 || words == NULL || !loadSnapshotString( &snapshot, record->singer, true, &show.singer ) ||
+				!loadSnapshotString( &snapshot, record->date, true, &show.date ) ||
+				!loadSnapshotString( &snapshot, record->venue, true, &show.venue ) ||
+				!loadSnapshotString( &snapshot, record->type, true, &show.type ) ||
+				bitmapInit( &show.booked, show.seats + 1 ) != 0 ) {
+			valid = false;
+			break;
+		}
+		memcpy( show.booked.words, words, numWords * sizeof( uint64_t ) );
+		if( bitmapTest( &show.booked, 0 ) || show.available != show.seats - bitmapCount( &show.booked ) ) {
+			printf( "Show %d has a stale free seat count in the snapshot, reloading the catalog.\n", show.id );
+			bitmapFree( &show.booked );
+			valid = false;
+			break;
+		}
+		Show* stored = tableAppend( &catalogShows );
+		if( stored == NULL ) {
+			bitmapFree( &show.booked );
+			valid = false;
+			break;
+		}
+		*stored = show;
+		intMapPut( &showIndex, (uint64_t)show.id, catalogShows.count - 1 );
+	}
+	catalogJournalOffset = snapshot.header->journalOffset;
+	closeSnapshot( &snapshot );
+	if( !valid || buildDateIndex() != 0 || buildSearchIndex() != 0 || buildFacetIndex() != 0 ) {
+		freeShows();
+		return -1;
+	}
+	catalogSnapshotCurrent = true;
+	return catalogShows.count;
+}
+
+/**
+ * @brief Load all shows from the shows database into the resident catalog.
+ *
+ * The catalog is loaded once at startup; every later read is served from memory. A current binary snapshot is
+ * preferred; otherwise fields are interned straight from the mapped text file without copying the row.
+ *
+ * @param filename The name of the shows database file.
+ * @return The number of loaded shows, or -1 if the file could not be read.
+ */
+int loadShowsFromFile( const char* filename ) {
+	freeShows();
+	strncpy( catalogFilename, filename, sizeof( catalogFilename ) - 1 );
+	StatTimer timer;
+	startTimer( &timer, STAT_LOAD );
+	int loaded = loadShowsFromSnapshot( filename );
+	if( loaded >= 0 ) {
+		stopTimer( &timer );
+		return loaded;
+	}
+	DataFile file;
+	if( openDataFile( &file, filename ) != 0 ) {
+		stopTimer( &timer );
+		return -1;
+	}
+	StrView fields[8];
+	nextDataRow( &file, fields, 8 );
+	int numFields;
+	while( ( numFields = nextDataRow( &file, fields, 8 ) ) >= 0 ) {
+		Show show;
+		if( numFields < 8 || !parseViewInt( fields[0], &show.id ) || !parseViewInt( fields[5], &show.price ) ||
+				!parseViewInt( fields[6], &show.seats ) || show.seats < 0 ) {
+			continue;
+		}
+		show.singer = internString( fields[1].text, fields[1].length );
+		show.date = internString( fields[2].text, fields[2].length );
+		show.day = parseDate( fields[2].text, fields[2].length );
+		show.venue = internString( fields[3].text, fields[3].length );
+		show.type = internString( fields[4].text, fields[4].length );
+		if( bitmapInit( &show.booked, show.seats + 1 ) != 0 ) {
+			break;
+		}
+		Show* stored = tableAppend( &catalogShows );
+		if( stored == NULL ) {
+			bitmapFree( &show.booked );
+			break;
+		}
+		if( bitmapParseList( &show.booked, fields[7].text, fields[7].length ) > 0 ) {
+			printf( "Show %d lists seats beyond its capacity, ignoring them.\n", show.id );
+		}
+		bitmapClear( &show.booked, 0 );
+		show.available = show.seats - bitmapCount( &show.booked );
+		show.heldSeats = 0;
+		show.held = (Bitmap){ 0 };
+		*stored = show;
+		intMapPut( &showIndex, (uint64_t)show.id, catalogShows.count - 1 );
+	}
+	closeDataFile( &file );
+	int result = buildDateIndex() == 0 && buildSearchIndex() == 0 && buildFacetIndex() == 0 ? catalogShows.count : -1;
+	stopTimer( &timer );
+	return result;
+}
+
+/**
+ * @brief Write the resident catalog back to the shows database.
+ *
+ * @return 0 on success, -1 if the file could not be written.
+ */
+int saveShowsToFile() {
+	char tempFilename[MAX_LENGTH + 4];
+	snprintf( tempFilename, sizeof( tempFilename ), "%s.tmp", catalogFilename );
+	StatTimer timer;
+	startTimer( &timer, STAT_SAVE );
+	FILE* file = fopen( tempFilename, "w" );
+	if( file == NULL ) {
+		stopTimer( &timer );
+		printf( "Error opening file for writing: %s\n", tempFilename );
+		return -1;
+	}
+	countFileOpen();
+	catalogSnapshotCurrent = false;
+	fprintf( file, "id|singer|date|venue|type|price|seats|booked\n" );
+	for( int i = 0; i < catalogShows.count; i++ ) {
+		const Show* show = tableAt( &catalogShows, i );
+		fprintf( file, "%d|%s|%s|%s|%s|%d|%d|", show->id, getString( show->singer ), getString( show->date ),
+				 getString( show->venue ), getString( show->type ), show->price, show->seats );
+		bitmapWriteList( &show->booked, file );
+		fputc( '\n', file );
+	}
+	countBytesWritten( ftell( file ) );
+	bool written = syncFile( file ) == 0;
+	int result = fclose( file ) == 0 && written ? replaceFile( tempFilename, catalogFilename ) : -1;
+	stopTimer( &timer );
+	return result;
+}
+
+/**
+ * @brief Write the resident catalog to its binary snapshot.
+ *
+ * @param journalOffset Length of the ticket journal whose seat changes the catalog reflects.
+ * @return 0 on success, -1 if the snapshot could not be written.
+ */
+int saveShowsSnapshot( uint64_t journalOffset ) {
+	char snapshotName[MAX_LENGTH];
+	getSnapshotFilename( catalogFilename, snapshotName, sizeof( snapshotName ) );
+	SnapshotWriter writer;
+	if( beginSnapshot( &writer, snapshotName, sizeof( ShowRecord ) ) != 0 ) {
+		return -1;
+	}
+	for( int i = 0; i < catalogShows.count; i++ ) {
+		const Show* show = tableAt( &catalogShows, i );
+		ShowRecord record;
+		record.id = show->id;
+		record.price = show->price;
+		record.seats = show->seats;
+		record.available = show->available;
+		record.day = show->day;
+		record.singer = addSnapshotString( &writer, show->singer );
+		record.date = addSnapshotString( &writer, show->date );
+		record.venue = addSnapshotString( &writer, show->venue );
+		record.type = addSnapshotString( &writer, show->type );
+		record.booked = addSnapshotWords( &writer, show->booked.words, ( (size_t)show->seats + 64 ) / 64 );
+		writeSnapshotRow( &writer, &record );
+	}
+	if( endSnapshot( &writer, catalogFilename, journalOffset, 0 ) != 0 ) {
+		return -1;
+	}
+	catalogJournalOffset = journalOffset;
+	catalogSnapshotCurrent = true;
+	return 0;
+}
+
+/**
+ * @brief Get the length of the ticket journal whose seat changes the catalog snapshot reflects.
+ *
+ * @param journalOffset Pointer to store the journal length, 0 when the catalog was loaded from the text database.
+ * @return true if the resident catalog matches its snapshot.
+ */
+bool getCatalogSnapshotOffset( uint64_t* journalOffset ) {
+	*journalOffset = catalogSnapshotCurrent ? catalogJournalOffset : 0;
+	return catalogSnapshotCurrent;
+}
+
+/**
+ * @brief Release the memory held by the resident catalog.
+ */
+void freeShows() {
+	for( int i = 0; i < catalogShows.count; i++ ) {
+		Show* show = tableAt( &catalogShows, i );
+		bitmapFree( &show->booked );
+		bitmapFree( &show->held );
+	}
+	tableFree( &catalogShows );
+	intMapFree( &showIndex );
+	free( showsByDate );
+	showsByDate = NULL;
+	freeSearchIndex();
+	freeFacetIndex();
+	catalogJournalOffset = 0;
+	catalogSnapshotCurrent = false;
+}
+
+/**
+ * @brief Get the number of shows in the catalog.
+ *
+ * @return The number of shows.
+ */
+int getShowCount() {
+	return catalogShows.count;
+}
+
+/**
+ * @brief Get a show by its position in the catalog.
+ *
+ * @param index Position of the show, from 0 to getShowCount() - 1.
+ * @return Pointer to the show, or NULL if the index is out of range.
+ */
+Show* getShowByIndex( int index ) {
+	return tableAt( &catalogShows, index );
+}
+
+/**
+ * @brief Get a show by its ID.
+ *
+ * @param showId The ID of the show.
+ * @return Pointer to the show, or NULL if no show has that ID.
+ */
+Show* getShowById( int showId ) {
+	int index;
+	if( !intMapGet( &showIndex, (uint64_t)showId, &index ) ) {
+		return NULL;
+	}
+	return tableAt( &catalogShows, index );
+}
+
+/**
+ * @brief Find the first show on or after a day in date order.
+ *
+ * Together with getShowByDateOrder() this walks the shows from that day on without visiting earlier ones.
+ *
+ * @param day The day number, as returned by parseDate() or getCurrentDay().
+ * @return Position in date order of the first show on or after that day, or getShowCount() if there is none.
+ */
+int findFirstShowOnOrAfter( int day ) {
+	int low = 0;
+	int high = catalogShows.count;
+	while( low < high ) {
+		int middle = low + ( high - low ) / 2;
+		if( showsByDate[middle].day < day ) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	return low;
+}
+
+/**
+ * @brief Get a show by its position in date order.
+ *
+ * Shows on the same day keep their catalog order.
+ *
+ * @param position Position in date order, from 0 to getShowCount() - 1.
+ * @return Pointer to the show, or NULL if the position is out of range.
+ */
+Show* getShowByDateOrder( int position ) {
+	if( position < 0 || position >= catalogShows.count || showsByDate == NULL ) {
+		return NULL;
+	}
+	return tableAt( &catalogShows, showsByDate[position].index );
+}
+
+/**
+ * @brief Add to a seat counter of a show that may be read without the store lock.
+ *
+ * @param counter The counter.
+ * @param delta Amount to add.
+ */
+static void adjustSeatCounter( int* counter, int delta ) {
+	#if defined(__GNUC__) || defined(__clang__)
+	__atomic_fetch_add( counter, delta, __ATOMIC_RELAXED );
+	#elif defined(_WIN32) || defined(_WIN64)
+	InterlockedExchangeAdd( (volatile LONG*)counter, delta );
+	#else
+	*counter += delta;
+	#endif
+}
+
+/**
+ * @brief Read a seat counter of a show that may be updated by other threads.
+ *
+ * @param counter The counter.
+ * @return Its value.
+ */
+static int readSeatCounter( const int* counter ) {
+	#if defined(__GNUC__) || defined(__clang__)
+	return __atomic_load_n( counter, __ATOMIC_RELAXED );
+	#else
+	return *(volatile const int*)counter;
+	#endif
+}
+
+/**
+ * @brief Book or free a seat of a show and update its available-seat counter and free-seat facet.
+ *
+ * Called with the exclusive store lock held. The counter is updated atomically, so it may be read without the lock.
+ *
+ * @param show The show.
+ * @param seat The seat number, from 1 to the number of seats.
+ * @param booked true to book the seat, false to free it.
+ * @return true if the seat changed state.
+ */
+bool setSeatBooked( Show* show, int seat, bool booked ) {
+	if( seat < 1 || seat > show->seats || bitmapTest( &show->booked, seat ) == booked ) {
+		return false;
+	}
+	if( booked ) {
+		bitmapSet( &show->booked, seat );
+	} else {
+		bitmapClear( &show->booked, seat );
+	}
+	adjustSeatCounter( &show->available, booked ? -1 : 1 );
+	updateFreeSeatFacet( show );
+	return true;
+}
+
+/**
+ * @brief Get the number of free seats of a show.
+ *
+ * Held seats do not count as free.
+ *
+ * @param show The show.
+ * @return The number of free seats.
+ */
+int getAvailableSeats( const Show* show ) {
+	return readSeatCounter( &show->available ) - readSeatCounter( &show->heldSeats );
+}
+
+/**
+ * @brief Mark a free seat as held during payment, or release it.
+ *
+ * Called with the exclusive store lock held. The free-seat facet of the show is updated as well.
+ *
+ * @param show The show.
+ * @param seat The seat number, from 1 to the number of seats.
+ * @param held true to hold the seat, false to release it.
+ * @return true if the seat changed state, false if it is out of range, already in that state, or could not be held.
+ */
+bool setSeatHeld( Show* show, int seat, bool held ) {
+	if( seat < 1 || seat > show->seats ) {
+		return false;
+	}
+	if( show->held.words == NULL && ( !held || bitmapInit( &show->held, show->seats + 1 ) != 0 ) ) {
+		return false;
+	}
+	if( bitmapTest( &show->held, seat ) == held ) {
+		return false;
+	}
+	if( held ) {
+		bitmapSet( &show->held, seat );
+	} else {
+		bitmapClear( &show->held, seat );
+	}
+	adjustSeatCounter( &show->heldSeats, held ? 1 : -1 );
+	updateFreeSeatFacet( show );
+	return true;
+}
+
+/**
+ * @brief Check whether a seat is neither booked nor held.
+ *
+ * @param show The show.
+ * @param seat The seat number.
+ * @return true if the seat exists and is free.
+ */
+bool isSeatFree( const Show* show, int seat ) {
+	return seat >= 1 && seat <= show->seats && !bitmapTest( &show->booked, seat ) &&
+		   ( show->held.words == NULL || !bitmapTest( &show->held, seat ) );
+}
+
+/**
+ * @brief Find the next run of seats that are neither booked nor held.
+ *
+ * @param show The show.
+ * @param from Seat to start searching from.
+ * @param to End of the range (exclusive); the run is cut off there.
+ * @param length Pointer to store the length of the run.
+ * @return The first seat of the run, or -1 if the range has no free seat.
+ */
+int findFreeSeatRun( const Show* show, int from, int to, int* length ) {
+	while( true ) {
+		int start = bitmapNextClearRun( &show->booked, from, to, length );
+		if( start < 0 || readSeatCounter( &show->heldSeats ) == 0 || show->held.words == NULL ) {
+			return start;
+		}
+		int heldSeat = bitmapNextSet( &show->held, start );
+		if( heldSeat < 0 || heldSeat >= start + *length ) {
+			return start;
+		}
+		if( heldSeat > start ) {
+			*length = heldSeat - start;
+			return start;
+		}
+		from = bitmapNextClear( &show->held, start );
+		if( from < 0 ) {
+			return -1;
+		}
+	}
+}
+
+/**
+ * @brief Find adjacent free seats of a show.
+ *
+ * Walks the runs of free, unheld seats row by row. First fit takes the lowest run that is long enough; best fit takes
+ * the shortest such run, which keeps long runs free for larger groups.
+ *
+ * @param show The show, whose seat map must not change during the call.
+ * @param count Number of adjacent seats.
+ * @param seatsPerRow Seats per row, numbered row by row from seat 1; runs never cross a row. 0 treats the show as
+ *                    a single row.
+ * @param bestFit true for best fit, false for first fit.
+ * @return The first seat of the run, or -1 if no run of count free seats exists.
+ */
+int findAdjacentSeats( const Show* show, int count, int seatsPerRow, bool bestFit ) {
+	if( count < 1 || count > getAvailableSeats( show ) ) {
+		return -1;
+	}
+	if( seatsPerRow <= 0 || seatsPerRow > show->seats ) {
+		seatsPerRow = show->seats;
+	}
+	if( count > seatsPerRow ) {
+		return -1;
+	}
+	int bestSeat = -1;
+	int bestLength = 0;
+	for( int rowStart = 1; rowStart <= show->seats; rowStart += seatsPerRow ) {
+		int rowEnd = rowStart + seatsPerRow <= show->seats + 1 ? rowStart + seatsPerRow : show->seats + 1;
+		int length;
+		for( int seat = findFreeSeatRun( show, rowStart, rowEnd, &length ); seat >= 0;
+				seat = findFreeSeatRun( show, seat + length, rowEnd, &length ) ) {
+			if( length < count || ( bestSeat >= 0 && length >= bestLength ) ) {
+				continue;
+			}
+			bestSeat = seat;
+			bestLength = length;
+			if( !bestFit || length == count ) {
+				return bestSeat;
+			}
+		}
+	}
+	return bestSeat;
+}
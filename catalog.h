@@ -0,0 +1,162 @@
+/**
+ * @file include/catalog.h
+ */
+
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include <stdint.h>
+#include "utilities.h"
+
+/**
+ * @brief Load all shows from the shows database into the resident catalog.
+ *
+ * The catalog is loaded once at startup; every later read is served from memory. A current binary snapshot is
+ * preferred; otherwise fields are interned straight from the mapped text file without copying the row.
+ *
+ * @param filename The name of the shows database file.
+ * @return The number of loaded shows, or -1 if the file could not be read.
+ */
+int loadShowsFromFile( const char* filename );
+
+/**
+ * @brief Write the resident catalog back to the shows database.
+ *
+ * @return 0 on success, -1 if the file could not be written.
+ */
+int saveShowsToFile();
+
+/**
+ * @brief Write the resident catalog to its binary snapshot.
+ *
+ * @param journalOffset Length of the ticket journal whose seat changes the catalog reflects.
+ * @return 0 on success, -1 if the snapshot could not be written.
+ */
+int saveShowsSnapshot( uint64_t journalOffset );
+
+/**
+ * @brief Get the length of the ticket journal whose seat changes the catalog snapshot reflects.
+ *
+ * @param journalOffset Pointer to store the journal length, 0 when the catalog was loaded from the text database.
+ * @return true if the resident catalog matches its snapshot.
+ */
+bool getCatalogSnapshotOffset( uint64_t* journalOffset );
+
+/**
+ * @brief Release the memory held by the resident catalog.
+ */
+void freeShows();
+
+/**
+ * @brief Get the number of shows in the catalog.
+ *
+ * @return The number of shows.
+ */
+int getShowCount();
+
+/**
+ * @brief Get a show by its position in the catalog.
+ *
+ * @param index Position of the show, from 0 to getShowCount() - 1.
+ * @return Pointer to the show, or NULL if the index is out of range.
+ */
+Show* getShowByIndex( int index );
+
+/**
+ * @brief Get a show by its ID.
+ *
+ * @param showId The ID of the show.
+ * @return Pointer to the show, or NULL if no show has that ID.
+ */
+Show* getShowById( int showId );
+
+/**
+ * @brief Book or free a seat of a show and update its available-seat counter and free-seat facet.
+ *
+ * Called with the exclusive store lock held. The counter is updated atomically, so it may be read without the lock.
+ *
+ * @param show The show.
+ * @param seat The seat number, from 1 to the number of seats.
+ * @param booked true to book the seat, false to free it.
+ * @return true if the seat changed state.
+ */
+bool setSeatBooked( Show* show, int seat, bool booked );
+
+/**
+ * @brief Get the number of free seats of a show.
+ *
+ * Held seats do not count as free.
+ *
+ * @param show The show.
+ * @return The number of free seats.
+ */
+int getAvailableSeats( const Show* show );
+
+/**
+ * @brief Mark a free seat as held during payment, or release it.
+ *
+ * Called with the exclusive store lock held. The free-seat facet of the show is updated as well.
+ *
+ * @param show The show.
+ * @param seat The seat number, from 1 to the number of seats.
+ * @param held true to hold the seat, false to release it.
+ * @return true if the seat changed state, false if it is out of range, already in that state, or could not be held.
+ */
+bool setSeatHeld( Show* show, int seat, bool held );
+
+/**
+ * @brief Check whether a seat is neither booked nor held.
+ *
+ * @param show The show.
+ * @param seat The seat number.
+ * @return true if the seat exists and is free.
+ */
+bool isSeatFree( const Show* show, int seat );
+
+/**
+ * @brief Find the next run of seats that are neither booked nor held.
+ *
+ * @param show The show.
+ * @param from Seat to start searching from.
+ * @param to End of the range (exclusive); the run is cut off there.
+ * @param length Pointer to store the length of the run.
+ * @return The first seat of the run, or -1 if the range has no free seat.
+ */
+int findFreeSeatRun( const Show* show, int from, int to, int* length );
+
+/**
+ * @brief Find adjacent free seats of a show.
+ *
+ * Walks the runs of free, unheld seats row by row. First fit takes the lowest run that is long enough; best fit takes
+ * the shortest such run, which keeps long runs free for larger groups.
+ *
+ * @param show The show, whose seat map must not change during the call.
+ * @param count Number of adjacent seats.
+ * @param seatsPerRow Seats per row, numbered row by row from seat 1; runs never cross a row. 0 treats the show as
+ *                    a single row.
+ * @param bestFit true for best fit, false for first fit.
+ * @return The first seat of the run, or -1 if no run of count free seats exists.
+ */
+int findAdjacentSeats( const Show* show, int count, int seatsPerRow, bool bestFit );
+
+/**
+ * @brief Find the first show on or after a day in date order.
+ *
+ * Together with getShowByDateOrder() this walks the shows from that day on without visiting earlier ones.
+ *
+ * @param day The day number, as returned by parseDate() or getCurrentDay().
+ * @return Position in date order of the first show on or after that day, or getShowCount() if there is none.
+ */
+int findFirstShowOnOrAfter( int day );
+
+/**
+ * @brief Get a show by its position in date order.
+ *
+ * Shows on the same day keep their catalog order.
+ *
+ * @param position Position in date order, from 0 to getShowCount() - 1.
+ * @return Pointer to the show, or NULL if the position is out of range.
+ */
+Show* getShowByDateOrder( int position );
+
+#endif // CATALOG_H
@@ -0,0 +1,737 @@
+/**
+ * @file src/commands.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/commands.h"
+#include "../include/booking.h"
+#include "../include/storelock.h"
+#include "../include/catalog.h"
+#include "../include/tickets.h"
+#include "../include/datafile.h"
+#include "../include/stats.h"
+#include "../include/holds.h"
+#include "../include/report.h"
+#include "../include/search.h"
+#include "../include/facets.h"
+
+#define FILTER_CONDITIONS 6
+
+/**
+ * @brief Parse an integer argument.
+ *
+ * @param text The argument.
+ * @param value Pointer to store the value.
+ * @return true if the whole argument is a valid integer.
+ */
+static bool parseArgument( const char* text, int* value ) {
+	StrView view = { text, strlen( text ) };
+	return parseViewInt( view, value );
+}
+
+/**
+ * @brief Write an error result.
+ *
+ * @param out Stream to write to.
+ * @param reason The reason.
+ * @return -1.
+ */
+static int fail( FILE* out, const char* reason ) {
+	fprintf( out, "error|%s\n", reason );
+	return -1;
+}
+
+/**
+ * @brief Write the row of a show.
+ *
+ * @param out Stream to write to.
+ * @param show The show.
+ */
+static void writeShow( FILE* out, const Show* show ) {
+	fprintf( out, "show|%d|%s|%s|%s|%s|%d|%d|%d\n", show->id, getString( show->singer ), getString( show->date ),
+			 getString( show->venue ), getString( show->type ), show->price, show->seats, getAvailableSeats( show ) );
+}
+
+/**
+ * @brief Parse a price range argument: "<min>-<max>", "<min>-", "-<max>" or a single price.
+ *
+ * @param text The argument.
+ * @param filter Filter to store the range in.
+ * @return true if the argument is a valid price range.
+ */
+static bool parsePriceRange( char* text, ShowFilter* filter ) {
+	char* dash = strchr( text, '-' );
+	if( dash == NULL ) {
+		return parseArgument( text, &filter->minPrice ) && parseArgument( text, &filter->maxPrice );
+	}
+	*dash = '\0';
+	return ( text[0] == '\0' || parseArgument( text, &filter->minPrice ) ) &&
+		   ( dash[1] == '\0' || parseArgument( dash + 1, &filter->maxPrice ) );
+}
+
+/**
+ * @brief Parse the conditions of list-shows into a filter.
+ *
+ * Every condition is a "<name>=<value>" word; words without "=" continue the value before them, separated by one
+ * space, so that venues may contain spaces.
+ *
+ * @param argc Number of arguments.
+ * @param argv The arguments.
+ * @param filter Filter to fill; it lists the upcoming shows unless a "from" condition is given.
+ * @param values Buffer of FILTER_CONDITIONS values of MAX_LENGTH characters for the genre and venue to point into.
+ * @return true if every condition is valid.
+ */
+static bool parseShowFilter( int argc, char* argv[], ShowFilter* filter, char values[][MAX_LENGTH] ) {
+	static const char* names[FILTER_CONDITIONS] = { "genre", "venue", "price", "from", "to", "seats" };
+	bool given[FILTER_CONDITIONS] = { false };
+	int current = -1;
+	for( int i = 1; i < argc; i++ ) {
+		char* equals = strchr( argv[i], '=' );
+		const char* text = argv[i];
+		if( equals != NULL ) {
+			*equals = '\0';
+			current = -1;
+			for( int condition = 0; condition < FILTER_CONDITIONS; condition++ ) {
+				if( strcmp( argv[i], names[condition] ) == 0 ) {
+					current = condition;
+				}
+			}
+			if( current < 0 || given[current] ) {
+				return false;
+			}
+			given[current] = true;
+			values[current][0] = '\0';
+			text = equals + 1;
+		} else if( current < 0 ) {
+			return false;
+		}
+		size_t length = strlen( values[current] );
+		if( snprintf( values[current] + length, MAX_LENGTH - length, "%s%s", equals != NULL ? "" : " ", text ) >=
+				(int)( MAX_LENGTH - length ) ) {
+			return false;
+		}
+	}
+	initShowFilter( filter );
+	filter->fromDay = getCurrentDay();
+	filter->genre = given[0] ? values[0] : NULL;
+	filter->venue = given[1] ? values[1] : NULL;
+	if( given[2] && !parsePriceRange( values[2], filter ) ) {
+		return false;
+	}
+	if( given[3] && ( filter->fromDay = parseDate( values[3], strlen( values[3] ) ) ) == 0 ) {
+		return false;
+	}
+	if( given[4] && ( filter->toDay = parseDate( values[4], strlen( values[4] ) ) ) == 0 ) {
+		return false;
+	}
+	return !given[5] || ( parseArgument( values[5], &filter->minFreeSeats ) && filter->minFreeSeats >= 0 );
+}
+
+/**
+ * @brief list-shows: write the upcoming shows, or the shows that meet the given conditions, with their free seats,
+ * in date order.
+ *
+ * @param argc Number of arguments.
+ * @param argv The arguments.
+ * @param out Stream to write to.
+ * @return 0 on success, -1 on failure.
+ */
+static int listShows( int argc, char* argv[], FILE* out ) {
+	ShowFilter filter;
+	char values[FILTER_CONDITIONS][MAX_LENGTH];
+	if( !parseShowFilter( argc, argv, &filter, values ) ) {
+		return fail( out, "usage: list-shows [genre=<genre>] [venue=<venue>] [price=<min>-<max>] [from=<date>] "
+					 "[to=<date>] [seats=<count>]" );
+	}
+	StatTimer timer;
+	startTimer( &timer, STAT_VIEW_SHOWS );
+	releaseExpiredHolds();
+	int* positions = malloc( sizeof( int ) * ( getShowCount() + 1 ) );
+	int found = positions != NULL ? filterShows( &filter, positions, getShowCount() ) : -1;
+	if( found < 0 ) {
+		free( positions );
+		stopTimer( &timer );
+		return fail( out, "out of memory" );
+	}
+	lockStoreForReading();
+	for( int i = 0; i < found; i++ ) {
+		writeShow( out, getShowByDateOrder( positions[i] ) );
+	}
+	unlockStoreForReading();
+	fprintf( out, "ok|%d\n", found );
+	free( positions );
+	stopTimer( &timer );
+	return 0;
+}
+
+/**
+ * @brief search: write the upcoming shows whose singer, venue or type matches a query, in date order.
+ *
+ * @param argc Number of arguments.
+ * @param argv The arguments.
+ * @param out Stream to write to.
+ * @return 0 on success, -1 on failure.
+ */
+static int search( int argc, char* argv[], FILE* out ) {
+	static const char* fieldNames[] = { "singer", "venue", "type", "all" };
+	static const int fieldMasks[] = { SEARCH_SINGER, SEARCH_VENUE, SEARCH_TYPE, SEARCH_ALL_FIELDS };
+	int fields = argc >= 3 ? 0 : SEARCH_ALL_FIELDS;
+	for( int i = 0; argc >= 3 && i < 4; i++ ) {
+		if( strcmp( argv[2], fieldNames[i] ) == 0 ) {
+			fields = fieldMasks[i];
+		}
+	}
+	SearchMode mode = argc == 4 && strcmp( argv[3], "prefix" ) == 0 ? SEARCH_PREFIX : SEARCH_SUBSTRING;
+	if( argc < 2 || argc > 4 || fields == 0 || ( argc == 4 && mode != SEARCH_PREFIX &&
+			strcmp( argv[3], "substring" ) != 0 ) ) {
+		return fail( out, "usage: search <query> [singer|venue|type|all] [substring|prefix]" );
+	}
+	StatTimer timer;
+	startTimer( &timer, STAT_VIEW_SHOWS );
+	releaseExpiredHolds();
+	int first = findFirstShowOnOrAfter( getCurrentDay() );
+	int numUpcoming = getShowCount() - first;
+	int* positions = malloc( sizeof( int ) * ( numUpcoming + 1 ) );
+	int found = positions != NULL ? searchShows( argv[1], fields, mode, first, positions, numUpcoming ) : -1;
+	if( found < 0 ) {
+		free( positions );
+		stopTimer( &timer );
+		return fail( out, "out of memory" );
+	}
+	lockStoreForReading();
+	for( int i = 0; i < found; i++ ) {
+		writeShow( out, getShowByDateOrder( positions[i] ) );
+	}
+	unlockStoreForReading();
+	fprintf( out, "ok|%d\n", found );
+	free( positions );
+	stopTimer( &timer );
+	return 0;
+}
+
+/**
+ * @brief buy: book seats of a show.
+ *
+ * @param argc Number of arguments.
+ * @param argv The arguments.
+ * @param out Stream to write to.
+ * @return 0 on success, -1 on failure.
+ */
+static int buy( int argc, char* argv[], FILE* out ) {
+	int userId, showId;
+	if( argc < 6 || !parseArgument( argv[1], &userId ) || !parseArgument( argv[2], &showId ) ) {
+		return fail( out, "usage: buy <userId> <showId> <method> <account> <seat>..." );
+	}
+	int count = argc - 5;
+	int* seats = malloc( sizeof( int ) * count );
+	BookedTicket* booked = malloc( sizeof( BookedTicket ) * count );
+	if( seats == NULL || booked == NULL ) {
+		free( seats );
+		free( booked );
+		return fail( out, getBookingError( BOOKING_FAILED ) );
+	}
+	int result = BOOKING_OK;
+	for( int i = 0; i < count; i++ ) {
+		if( !parseArgument( argv[5 + i], &seats[i] ) ) {
+			result = BOOKING_BAD_SEAT;
+		}
+	}
+	char transactionNumber[TRANSACTION_NUMBER_LENGTH];
+	if( result == BOOKING_OK ) {
+		result = bookSeats( userId, showId, seats, count, argv[3], argv[4], booked, transactionNumber );
+	}
+	if( result == BOOKING_OK ) {
+		for( int i = 0; i < count; i++ ) {
+			fprintf( out, "ticket|%d|%s|%d\n", booked[i].ticketId, booked[i].ticketNumber, booked[i].seatNumber );
+		}
+		fprintf( out, "ok|%s\n", transactionNumber );
+	}
+	free( seats );
+	free( booked );
+	return result == BOOKING_OK ? 0 : fail( out, getBookingError( result ) );
+}
+
+/**
+ * @brief buy-adjacent: book adjacent seats picked by the seat allocator.
+ *
+ * @param argc Number of arguments.
+ * @param argv The arguments.
+ * @param out Stream to write to.
+ * @return 0 on success, -1 on failure.
+ */
+static int buyAdjacent( int argc, char* argv[], FILE* out ) {
+	int userId, showId, count;
+	int seatsPerRow = 0;
+	if( argc < 6 || argc > 8 || !parseArgument( argv[1], &userId ) || !parseArgument( argv[2], &showId ) ||
+			!parseArgument( argv[5], &count ) || count < 1 || count > MAX_COMMAND_ARGS ||
+			( argc > 6 && !parseArgument( argv[6], &seatsPerRow ) ) ||
+			( argc > 7 && strcmp( argv[7], "best" ) != 0 && strcmp( argv[7], "first" ) != 0 ) ) {
+		return fail( out, "usage: buy-adjacent <userId> <showId> <method> <account> <count> [<seatsPerRow> [best|first]]" );
+	}
+	BookedTicket booked[MAX_COMMAND_ARGS];
+	char transactionNumber[TRANSACTION_NUMBER_LENGTH];
+	bool bestFit = argc <= 7 || strcmp( argv[7], "best" ) == 0;
+	int result = bookAdjacentSeats( userId, showId, count, seatsPerRow, bestFit, argv[3], argv[4], booked,
+									transactionNumber );
+	if( result != BOOKING_OK ) {
+		return fail( out, getBookingError( result ) );
+	}
+	for( int i = 0; i < count; i++ ) {
+		fprintf( out, "ticket|%d|%s|%d\n", booked[i].ticketId, booked[i].ticketNumber, booked[i].seatNumber );
+	}
+	fprintf( out, "ok|%s\n", transactionNumber );
+	return 0;
+}
+
+/**
+ * @brief hold: hold seats of a show for a user while they pay.
+ *
+ * @param argc Number of arguments.
+ * @param argv The arguments.
+ * @param out Stream to write to.
+ * @return 0 on success, -1 on failure.
+ */
+static int hold( int argc, char* argv[], FILE* out ) {
+	int userId, showId;
+	if( argc < 4 || !parseArgument( argv[1], &userId ) || !parseArgument( argv[2], &showId ) ) {
+		return fail( out, "usage: hold <userId> <showId> <seat>..." );
+	}
+	int count = argc - 3;
+	// confirm books at most MAX_COMMAND_ARGS tickets
+	if( count > MAX_COMMAND_ARGS ) {
+		return fail( out, "too many seats" );
+	}
+	int seats[MAX_COMMAND_ARGS];
+	for( int i = 0; i < count; i++ ) {
+		if( !parseArgument( argv[3 + i], &seats[i] ) ) {
+			return fail( out, getBookingError( BOOKING_BAD_SEAT ) );
+		}
+	}
+	int holdId = holdSeats( userId, showId, seats, count );
+	if( holdId < 0 ) {
+		return fail( out, getBookingError( holdId ) );
+	}
+	fprintf( out, "ok|%d|%d\n", holdId, getHoldSeconds() );
+	return 0;
+}
+
+/**
+ * @brief confirm: pay for held seats.
+ *
+ * @param argc Number of arguments.
+ * @param argv The arguments.
+ * @param out Stream to write to.
+ * @return 0 on success, -1 on failure.
+ */
+static int confirm( int argc, char* argv[], FILE* out ) {
+	int userId, holdId;
+	if( argc != 5 || !parseArgument( argv[1], &userId ) || !parseArgument( argv[2], &holdId ) ) {
+		return fail( out, "usage: confirm <userId> <holdId> <method> <account>" );
+	}
+	BookedTicket booked[MAX_COMMAND_ARGS];
+	char transactionNumber[TRANSACTION_NUMBER_LENGTH];
+	int count = confirmHold( holdId, userId, argv[3], argv[4], MAX_COMMAND_ARGS, booked, transactionNumber );
+	if( count < 0 ) {
+		return fail( out, getBookingError( count ) );
+	}
+	for( int i = 0; i < count; i++ ) {
+		fprintf( out, "ticket|%d|%s|%d\n", booked[i].ticketId, booked[i].ticketNumber, booked[i].seatNumber );
+	}
+	fprintf( out, "ok|%s\n", transactionNumber );
+	return 0;
+}
+
+/**
+ * @brief release: give held seats back to sale.
+ *
+ * @param argc Number of arguments.
+ * @param argv The arguments.
+ * @param out Stream to write to.
+ * @return 0 on success, -1 on failure.
+ */
+static int release( int argc, char* argv[], FILE* out ) {
+	int userId, holdId;
+	if( argc != 3 || !parseArgument( argv[1], &userId ) || !parseArgument( argv[2], &holdId ) ) {
+		return fail( out, "usage: release <userId> <holdId>" );
+	}
+	int result = releaseHold( holdId, userId );
+	if( result != BOOKING_OK ) {
+		return fail( out, getBookingError( result ) );
+	}
+	fprintf( out, "ok\n" );
+	return 0;
+}
+
+/**
+ * @brief cancel: cancel a ticket of a user.
+ *
+ * @param argc Number of arguments.
+ * @param argv The arguments.
+ * @param out Stream to write to.
+ * @return 0 on success, -1 on failure.
+ */
+static int cancel( int argc, char* argv[], FILE* out ) {
+	int userId, ticketId;
+	if( argc != 3 || !parseArgument( argv[1], &userId ) || !parseArgument( argv[2], &ticketId ) ) {
+		return fail( out, "usage: cancel <userId> <ticketId>" );
+	}
+	int result = changeTicketStatus( ticketId, userId, 0 );
+	if( result != BOOKING_OK ) {
+		return fail( out, getBookingError( result ) );
+	}
+	fprintf( out, "ok\n" );
+	return 0;
+}
+
+/**
+ * @brief my-tickets: write every ticket of a user.
+ *
+ * @param argc Number of arguments.
+ * @param argv The arguments.
+ * @param out Stream to write to.
+ * @return 0 on success, -1 on failure.
+ */
+static int myTickets( int argc, char* argv[], FILE* out ) {
+	int userId;
+	if( argc != 2 || !parseArgument( argv[1], &userId ) ) {
+		return fail( out, "usage: my-tickets <userId>" );
+	}
+	StatTimer timer;
+	startTimer( &timer, STAT_LIST_TICKETS );
+	int count = 0;
+	lockStoreForReading();
+	for( int index = getFirstUserTicket( userId ); index >= 0; index = getNextUserTicket( index ) ) {
+		const Ticket* ticket = getTicketByIndex( index );
+		fprintf( out, "ticket|%d|%s|%d|%d|%s|%s|%s|%d\n", ticket->id, getString( ticket->ticketNumber ),
+				 ticket->showId, ticket->seatNumber, getString( ticket->paymentMethod ),
+				 getString( ticket->paymentAccount ), getString( ticket->transactionNumber ), ticket->status );
+		count++;
+	}
+	unlockStoreForReading();
+	fprintf( out, "ok|%d\n", count );
+	stopTimer( &timer );
+	return 0;
+}
+
+/**
+ * @brief Express a count as a percentage of another.
+ *
+ * @param part The count.
+ * @param whole The count it is a part of.
+ * @return The percentage, or 0 if whole is 0.
+ */
+static double percent( int64_t part, int64_t whole ) {
+	return whole > 0 ? 100.0 * (double)part / (double)whole : 0.0;
+}
+
+/**
+ * @brief Write the venue or genre rows of a sales report.
+ *
+ * @param out Stream to write to.
+ * @param kind The row type, "venue" or "genre".
+ * @param rows The rows.
+ */
+static void writeGroupRows( FILE* out, const char* kind, const Table* rows ) {
+	for( int i = 0; i < rows->count; i++ ) {
+		const SalesRow* row = tableAt( rows, i );
+		fprintf( out, "%s|%s|%d|%lld|%lld|%lld|%lld|%.1f|%.1f\n", kind, row->name, row->shows, (long long)row->seats,
+				 (long long)row->sold, (long long)row->canceled, (long long)row->revenue,
+				 percent( row->sold, row->seats ), percent( row->canceled, row->sold + row->canceled ) );
+	}
+}
+
+/**
+ * @brief report: write revenue, occupancy and cancellation rate per show, venue, genre and payment method.
+ *
+ * @param argc Number of arguments.
+ * @param argv The arguments.
+ * @param out Stream to write to.
+ * @return 0 on success, -1 on failure.
+ */
+static int report( int argc, char* argv[], FILE* out ) {
+	int numThreads = 0;
+	if( argc > 2 || ( argc == 2 && ( !parseArgument( argv[1], &numThreads ) || numThreads < 0 ) ) ) {
+		return fail( out, "usage: report [<threads>]" );
+	}
+	SalesReport sales;
+	if( buildSalesReport( &sales, numThreads ) != 0 ) {
+		return fail( out, "out of memory" );
+	}
+	for( int i = 0; i < sales.shows.count; i++ ) {
+		const SalesRow* row = tableAt( &sales.shows, i );
+		// a show missing from the catalog is listed without its venue, genre and price
+		const Show* show = getShowById( row->showId );
+		fprintf( out, "show|%d|%s|%s|%s|%d|%lld|%lld|%lld|%lld|%.1f|%.1f\n", row->showId, row->name,
+				 show != NULL ? getString( show->venue ) : "", show != NULL ? getString( show->type ) : "",
+				 show != NULL ? show->price : 0, (long long)row->seats,
+				 (long long)row->sold, (long long)row->canceled, (long long)row->revenue,
+				 percent( row->sold, row->seats ), percent( row->canceled, row->sold + row->canceled ) );
+	}
+	writeGroupRows( out, "venue", &sales.venues );
+	writeGroupRows( out, "genre", &sales.genres );
+	for( int i = 0; i < sales.methods.count; i++ ) {
+		const SalesRow* row = tableAt( &sales.methods, i );
+		fprintf( out, "method|%s|%lld|%lld|%lld|%.1f\n", row->name, (long long)row->sold, (long long)row->canceled,
+				 (long long)row->revenue, percent( row->canceled, row->sold + row->canceled ) );
+	}
+	const SalesRow* total = &sales.total;
+	fprintf( out, "total|%d|%lld|%lld|%lld|%lld|%.1f|%.1f\n", total->shows, (long long)total->seats,
+			 (long long)total->sold, (long long)total->canceled, (long long)total->revenue,
+			 percent( total->sold, total->seats ), percent( total->canceled, total->sold + total->canceled ) );
+	fprintf( out, "ok|%lld\n", (long long)( total->sold + total->canceled ) );
+	freeSalesReport( &sales );
+	return 0;
+}
+
+/**
+ * @brief compact: rewrite the changed ticket segments and empty the journal now.
+ *
+ * @param argc Number of arguments.
+ * @param out Stream to write to.
+ * @return 0 on success, -1 on failure.
+ */
+static int compact( int argc, FILE* out ) {
+	if( argc != 1 ) {
+		return fail( out, "usage: compact" );
+	}
+	if( compactTicketsWhenDue( true ) < 0 ) {
+		return fail( out, "compaction failed" );
+	}
+	fprintf( out, "ok\n" );
+	return 0;
+}
+
+/**
+ * @brief register and login: create or check a user account.
+ *
+ * @param argc Number of arguments.
+ * @param argv The arguments.
+ * @param out Stream to write to.
+ * @param sessionUser Pointer to store the ID of the user in, or -1 on failure; may be NULL.
+ * @return 0 on success, -1 on failure.
+ */
+static int account( int argc, char* argv[], FILE* out, int* sessionUser ) {
+	if( sessionUser != NULL ) {
+		*sessionUser = -1;
+	}
+	if( argc != 3 ) {
+		fprintf( out, "error|usage: %s <username> <password>\n", argv[0] );
+		return -1;
+	}
+	int userId = strcmp( argv[0], "register" ) == 0 ? registerAccount( argv[1], argv[2] )
+												   : authenticateAccount( argv[1], argv[2] );
+	if( userId < 0 ) {
+		return fail( out, getBookingError( userId ) );
+	}
+	if( sessionUser != NULL ) {
+		*sessionUser = userId;
+	}
+	fprintf( out, "ok|%d\n", userId );
+	return 0;
+}
+
+/**
+ * @brief Run one booking command and write its result in a machine-readable form.
+ *
+ * Commands:
+ *   list-shows [genre=<genre>] [venue=<venue>]                 one "show|id|singer|date|venue|type|price|seats|available"
+ *       [price=<min>-<max>] [from=<date>] [to=<date>]          row per upcoming show, or per show of that genre and
+ *       [seats=<count>]                                        venue, in that price range and date window, and with
+ *                                                              at least count free seats; dates are "dd,mm,yyyy"
+ *   search <query> [singer|venue|type|all] [substring|prefix] like list-shows, for the upcoming shows whose fields
+ *                                                              contain the query, or have a word starting with it
+ *   buy <userId> <showId> <method> <account> <seat> [<seat>...] one "ticket|id|number|seat" row per ticket
+ *   buy-adjacent <userId> <showId> <method> <account> <count>  like buy, with count adjacent seats picked
+ *       [<seatsPerRow> [best|first]]                           by best fit (default) or first fit, never
+ *                                                              crossing rows of seatsPerRow seats
+ *   hold <userId> <showId> <seat> [<seat>...]                  "ok|<holdId>|<seconds>", the seats stay reserved
+ *                                                              for that many seconds
+ *   confirm <userId> <holdId> <method> <account>               like buy, for the held seats
+ *   release <userId> <holdId>
+ *   cancel <userId> <ticketId>
+ *   my-tickets <userId>                                        one "ticket|id|number|showId|seat|method|account|
+ *                                                              transaction|status" row per ticket
+ *   register <username> <password>                             "ok|<userId>"
+ *   login <username> <password>                                "ok|<userId>"
+ *   report [<threads>]                                         one "show|id|singer|venue|type|price|seats|sold|
+ *                                                              canceled|revenue|occupancy|cancel_rate" row per
+ *                                                              show, then "venue|name|shows|seats|sold|canceled|
+ *                                                              revenue|occupancy|cancel_rate" rows, "genre|..."
+ *                                                              rows like venue, "method|name|sold|canceled|revenue|
+ *                                                              cancel_rate" rows and one "total|shows|seats|sold|
+ *                                                              canceled|revenue|occupancy|cancel_rate" row, with
+ *                                                              percentages; "ok|<tickets>"
+ *   compact                                                    rewrite the changed ticket segments and empty the
+ *                                                              journal now
+ *
+ * Every command ends with a line "ok" or "ok|<value>" on success, or "error|<reason>" on failure.
+ *
+ * @param argc Number of arguments, including the command name.
+ * @param argv The arguments.
+ * @param out Stream to write the result to.
+ * @return 0 if the command succeeded, -1 otherwise.
+ */
+int runCommand( int argc, char* argv[], FILE* out ) {
+	if( argc < 1 ) {
+		return fail( out, "empty command" );
+	}
+	if( argc > MAX_COMMAND_ARGS ) {
+		return fail( out, "too many arguments" );
+	}
+	if( strcmp( argv[0], "list-shows" ) == 0 ) {
+		return listShows( argc, argv, out );
+	}
+	if( strcmp( argv[0], "search" ) == 0 ) {
+		return search( argc, argv, out );
+	}
+	if( strcmp( argv[0], "buy" ) == 0 ) {
+		return buy( argc, argv, out );
+	}
+	if( strcmp( argv[0], "buy-adjacent" ) == 0 ) {
+		return buyAdjacent( argc, argv, out );
+	}
+	if( strcmp( argv[0], "hold" ) == 0 ) {
+		return hold( argc, argv, out );
+	}
+	if( strcmp( argv[0], "confirm" ) == 0 ) {
+		return confirm( argc, argv, out );
+	}
+	if( strcmp( argv[0], "release" ) == 0 ) {
+		return release( argc, argv, out );
+	}
+	if( strcmp( argv[0], "cancel" ) == 0 ) {
+		return cancel( argc, argv, out );
+	}
+	if( strcmp( argv[0], "my-tickets" ) == 0 ) {
+		return myTickets( argc, argv, out );
+	}
+	if( strcmp( argv[0], "register" ) == 0 || strcmp( argv[0], "login" ) == 0 ) {
+		return account( argc, argv, out, NULL );
+	}
+	if( strcmp( argv[0], "report" ) == 0 ) {
+		return report( argc, argv, out );
+	}
+	if( strcmp( argv[0], "compact" ) == 0 ) {
+		return compact( argc, out );
+	}
+	return fail( out, "unknown command" );
+}
+
+/**
+ * @brief Split a request line into whitespace-separated arguments in place.
+ *
+ * @param line The request line, modified by the call.
+ * @param argv Array of MAX_COMMAND_ARGS entries to store the arguments in.
+ * @return Number of arguments, or -1 if the line has more than MAX_COMMAND_ARGS.
+ */
+int splitCommandLine( char* line, char* argv[] ) {
+	int argc = 0;
+	char* position = line;
+	while( true ) {
+		position += strspn( position, " \t\r\n" );
+		if( *position == '\0' ) {
+			break;
+		}
+		if( argc == MAX_COMMAND_ARGS ) {
+			return -1;
+		}
+		argv[argc++] = position;
+		position += strcspn( position, " \t\r\n" );
+		if( *position != '\0' ) {
+			*position++ = '\0';
+		}
+	}
+	return argc;
+}
+
+/**
+ * @brief Check that a command acts only for the user logged in on the stream.
+ *
+ * @param argc Number of arguments, including the command name.
+ * @param argv The arguments.
+ * @param out Stream to write the error to.
+ * @param sessionUser The ID of the logged in user, or -1 if nobody is logged in.
+ * @return 0 if the command may run, -1 after writing the error otherwise.
+ */
+static int checkSessionUser( int argc, char* argv[], FILE* out, int sessionUser ) {
+	static const char* userCommands[] = { "buy", "buy-adjacent", "hold", "confirm", "release", "cancel",
+										  "my-tickets" };
+	for( size_t i = 0; i < sizeof( userCommands ) / sizeof( userCommands[0] ); i++ ) {
+		if( strcmp( argv[0], userCommands[i] ) != 0 ) {
+			continue;
+		}
+		int userId;
+		if( sessionUser < 0 ) {
+			return fail( out, "login required" );
+		}
+		if( argc >= 2 && ( !parseArgument( argv[1], &userId ) || userId != sessionUser ) ) {
+			return fail( out, "user does not match the login" );
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief Run the commands of a request stream, one per line, until end of input or a "quit" line.
+ *
+ * The result of each command is flushed before the next line is read, so a client can wait for it. With
+ * requireLogin, the stream is a session: commands that take a userId are refused until "login" or "register"
+ * succeeds, and then only run for that user. Without it, the ticket store is compacted between commands once it is
+ * due; the daemon does that on a maintenance thread instead. A line longer than MAX_REQUEST_LENGTH is refused
+ * whole.
+ *
+ * @param in Stream to read requests from.
+ * @param out Stream to write results to.
+ * @param requireLogin true to bind the stream to the user who logs in on it, false to trust every userId.
+ * @return Number of failed commands.
+ */
+int runCommandStream( FILE* in, FILE* out, bool requireLogin ) {
+	char line[MAX_REQUEST_LENGTH];
+	int failures = 0;
+	int sessionUser = -1;
+	while( fgets( line, sizeof( line ), in ) ) {
+		if( strchr( line, '\n' ) == NULL && !feof( in ) ) {
+			// the rest of an overlong request must not run as a command of its own
+			int c;
+			while( ( c = fgetc( in ) ) != EOF && c != '\n' ) {
+			}
+			fail( out, "request too long" );
+			failures++;
+			if( fflush( out ) != 0 ) {
+				break;
+			}
+			continue;
+		}
+		char* argv[MAX_COMMAND_ARGS];
+		int argc = splitCommandLine( line, argv );
+		if( argc == 0 ) {
+			continue;
+		}
+		if( argc > 0 && strcmp( argv[0], "quit" ) == 0 ) {
+			break;
+		}
+		int result;
+		if( argc < 0 ) {
+			result = fail( out, "too many arguments" );
+		} else if( requireLogin && ( strcmp( argv[0], "register" ) == 0 || strcmp( argv[0], "login" ) == 0 ) ) {
+			result = account( argc, argv, out, &sessionUser );
+		} else if( requireLogin && checkSessionUser( argc, argv, out, sessionUser ) != 0 ) {
+			result = -1;
+		} else {
+			result = runCommand( argc, argv, out );
+		}
+		if( result != 0 ) {
+			failures++;
+		}
+		if( fflush( out ) != 0 ) {
+			break;
+		}
+		if( !requireLogin ) {
+			compactTicketsWhenDue( false );
+		}
+	}
+	return failures;
+}
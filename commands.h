@@ -0,0 +1,82 @@
+/**
+ * @file include/commands.h
+ */
+
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#define MAX_COMMAND_ARGS 64
+#define MAX_REQUEST_LENGTH 4096
+
+/**
+ * @brief Run one booking command and write its result in a machine-readable form.
+ *
+ * Commands:
+ *   list-shows [genre=<genre>] [venue=<venue>]                 one "show|id|singer|date|venue|type|price|seats|available"
+ *       [price=<min>-<max>] [from=<date>] [to=<date>]          row per upcoming show, or per show of that genre and
+ *       [seats=<count>]                                        venue, in that price range and date window, and with
+ *                                                              at least count free seats; dates are "dd,mm,yyyy"
+ *   search <query> [singer|venue|type|all] [substring|prefix] like list-shows, for the upcoming shows whose fields
+ *                                                              contain the query, or have a word starting with it
+ *   buy <userId> <showId> <method> <account> <seat> [<seat>...] one "ticket|id|number|seat" row per ticket
+ *   buy-adjacent <userId> <showId> <method> <account> <count>  like buy, with count adjacent seats picked
+ *       [<seatsPerRow> [best|first]]                           by best fit (default) or first fit, never
+ *                                                              crossing rows of seatsPerRow seats
+ *   hold <userId> <showId> <seat> [<seat>...]                  "ok|<holdId>|<seconds>", the seats stay reserved
+ *                                                              for that many seconds
+ *   confirm <userId> <holdId> <method> <account>               like buy, for the held seats
+ *   release <userId> <holdId>
+ *   cancel <userId> <ticketId>
+ *   my-tickets <userId>                                        one "ticket|id|number|showId|seat|method|account|
+ *                                                              transaction|status" row per ticket
+ *   register <username> <password>                             "ok|<userId>"
+ *   login <username> <password>                                "ok|<userId>"
+ *   report [<threads>]                                         one "show|id|singer|venue|type|price|seats|sold|
+ *                                                              canceled|revenue|occupancy|cancel_rate" row per
+ *                                                              show, then "venue|name|shows|seats|sold|canceled|
+ *                                                              revenue|occupancy|cancel_rate" rows, "genre|..."
+ *                                                              rows like venue, "method|name|sold|canceled|revenue|
+ *                                                              cancel_rate" rows and one "total|shows|seats|sold|
+ *                                                              canceled|revenue|occupancy|cancel_rate" row, with
+ *                                                              percentages; "ok|<tickets>"
+ *   compact                                                    rewrite the changed ticket segments and empty the
+ *                                                              journal now
+ *
+ * Every command ends with a line "ok" or "ok|<value>" on success, or "error|<reason>" on failure.
+ *
+ * @param argc Number of arguments, including the command name.
+ * @param argv The arguments.
+ * @param out Stream to write the result to.
+ * @return 0 if the command succeeded, -1 otherwise.
+ */
+int runCommand( int argc, char* argv[], FILE* out );
+
+/**
+ * @brief Split a request line into whitespace-separated arguments in place.
+ *
+ * @param line The request line, modified by the call.
+ * @param argv Array of MAX_COMMAND_ARGS entries to store the arguments in.
+ * @return Number of arguments, or -1 if the line has more than MAX_COMMAND_ARGS.
+ */
+int splitCommandLine( char* line, char* argv[] );
+
+/**
+ * @brief Run the commands of a request stream, one per line, until end of input or a "quit" line.
+ *
+ * The result of each command is flushed before the next line is read, so a client can wait for it. With
+ * requireLogin, the stream is a session: commands that take a userId are refused until "login" or "register"
+ * succeeds, and then only run for that user. Without it, the ticket store is compacted between commands once it is
+ * due; the daemon does that on a maintenance thread instead. A line longer than MAX_REQUEST_LENGTH is refused
+ * whole.
+ *
+ * @param in Stream to read requests from.
+ * @param out Stream to write results to.
+ * @param requireLogin true to bind the stream to the user who logs in on it, false to trust every userId.
+ * @return Number of failed commands.
+ */
+int runCommandStream( FILE* in, FILE* out, bool requireLogin );
+
+#endif // COMMANDS_H
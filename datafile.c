@@ -0,0 +1,233 @@
+/**
+ * @file src/datafile.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/datafile.h"
+#include "../include/stats.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+	#include <emmintrin.h>
+	#define HAVE_SSE2 1
+#endif
+
+#define BLOCK_SIZE 16
+
+/**
+ * @brief Index of the lowest set bit of a non-zero mask.
+ *
+ * @param mask The mask, must not be zero.
+ * @return The bit index.
+ */
+static int lowestBit( unsigned mask ) {
+	#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctz( mask );
+	#else
+	int bit = 0;
+	while( ( mask & 1 ) == 0 ) {
+		mask >>= 1;
+		bit++;
+	}
+	return bit;
+	#endif
+}
+
+/**
+ * @brief Find the separators in the block of up to 16 characters that starts at a position.
+ *
+ * @param data The characters.
+ * @param position Start of the block.
+ * @param end End of the data.
+ * @param blockLength Pointer to store the number of characters covered.
+ * @return Bit mask with bit n set when character position + n is '|' or '\n'.
+ */
+static unsigned separatorMask( const char* data, size_t position, size_t end, size_t* blockLength ) {
+	#ifdef HAVE_SSE2
+	if( end - position >= BLOCK_SIZE ) {
+		__m128i block = _mm_loadu_si128( (const __m128i*)( data + position ) );
+		__m128i pipes = _mm_cmpeq_epi8( block, _mm_set1_epi8( '|' ) );
+		__m128i newlines = _mm_cmpeq_epi8( block, _mm_set1_epi8( '\n' ) );
+		*blockLength = BLOCK_SIZE;
+		return (unsigned)_mm_movemask_epi8( _mm_or_si128( pipes, newlines ) );
+	}
+	#endif
+	size_t length = end - position < BLOCK_SIZE ? end - position : BLOCK_SIZE;
+	unsigned mask = 0;
+	for( size_t i = 0; i < length; i++ ) {
+		if( data[position + i] == '|' || data[position + i] == '\n' ) {
+			mask |= 1u << i;
+		}
+	}
+	*blockLength = length;
+	return mask;
+}
+
+/**
+ * @brief Map a data file into memory.
+ *
+ * @param file The data file to open.
+ * @param filename The name of the file.
+ * @return 0 on success, -1 if the file could not be opened.
+ */
+int openDataFile( DataFile* file, const char* filename ) {
+	file->data = NULL;
+	file->size = 0;
+	file->position = 0;
+	file->mapped = false;
+	file->rowTerminated = false;
+	#if defined(_WIN32) || defined(_WIN64)
+	FILE* stream = fopen( filename, "rb" );
+	if( stream == NULL ) {
+		return -1;
+	}
+	fseek( stream, 0, SEEK_END );
+	long size = ftell( stream );
+	fseek( stream, 0, SEEK_SET );
+	char* buffer = malloc( size > 0 ? size : 1 );
+	if( buffer == NULL ) {
+		fclose( stream );
+		return -1;
+	}
+	file->size = fread( buffer, 1, size > 0 ? size : 0, stream );
+	file->data = buffer;
+	fclose( stream );
+	#else
+	int fd = open( filename, O_RDONLY );
+	if( fd < 0 ) {
+		return -1;
+	}
+	struct stat info;
+	if( fstat( fd, &info ) != 0 ) {
+		close( fd );
+		return -1;
+	}
+	if( info.st_size > 0 ) {
+		void* data = mmap( NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		if( data == MAP_FAILED ) {
+			close( fd );
+			return -1;
+		}
+		madvise( data, info.st_size, MADV_SEQUENTIAL );
+		file->data = data;
+		file->size = info.st_size;
+		file->mapped = true;
+	}
+	close( fd );
+	#endif
+	countFileOpen();
+	countBytesRead( file->size );
+	return 0;
+}
+
+/**
+ * @brief Unmap a data file.
+ *
+ * @param file The data file.
+ */
+void closeDataFile( DataFile* file ) {
+	#if defined(_WIN32) || defined(_WIN64)
+	free( (void*)file->data );
+	#else
+	if( file->mapped ) {
+		munmap( (void*)file->data, file->size );
+	}
+	#endif
+	file->data = NULL;
+	file->size = 0;
+	file->position = 0;
+	file->mapped = false;
+}
+
+/**
+ * @brief Split the next row of a data file into fields.
+ *
+ * Fields are separated by '|' and rows by '\n'; a trailing '\r' is dropped. Separators beyond maxFields - 1 are
+ * kept in the last field. After the call, file->rowTerminated tells whether the row ended with a newline, which
+ * is false only for a final row that was cut short.
+ *
+ * @param file The data file.
+ * @param fields Array to store the fields in.
+ * @param maxFields Size of the fields array.
+ * @return The number of fields in the row, or -1 at end of file.
+ */
+int nextDataRow( DataFile* file, StrView fields[], int maxFields ) {
+	if( file->position >= file->size || maxFields < 1 ) {
+		return -1;
+	}
+	const char* data = file->data;
+	size_t start = file->position;
+	size_t position = start;
+	size_t rowEnd = file->size;
+	int numFields = 0;
+	file->rowTerminated = false;
+	while( position < file->size && !file->rowTerminated ) {
+		size_t blockLength;
+		unsigned mask = separatorMask( data, position, file->size, &blockLength );
+		while( mask != 0 ) {
+			size_t separator = position + lowestBit( mask );
+			mask &= mask - 1;
+			if( data[separator] == '\n' ) {
+				rowEnd = separator;
+				file->rowTerminated = true;
+				break;
+			}
+			if( numFields < maxFields - 1 ) {
+				fields[numFields].text = data + start;
+				fields[numFields].length = separator - start;
+				numFields++;
+				start = separator + 1;
+			}
+		}
+		position += blockLength;
+	}
+	size_t fieldEnd = rowEnd;
+	if( fieldEnd > start && data[fieldEnd - 1] == '\r' ) {
+		fieldEnd--;
+	}
+	fields[numFields].text = data + start;
+	fields[numFields].length = fieldEnd - start;
+	numFields++;
+	file->position = file->rowTerminated ? rowEnd + 1 : file->size;
+	return numFields;
+}
+
+/**
+ * @brief Parse a decimal integer field.
+ *
+ * @param view The field.
+ * @param value Pointer to store the value.
+ * @return true if the whole field is a valid integer.
+ */
+bool parseViewInt( StrView view, int* value ) {
+	size_t i = 0;
+	bool negative = false;
+	if( view.length > 0 && view.text[0] == '-' ) {
+		negative = true;
+		i = 1;
+	}
+	if( i == view.length ) {
+		return false;
+	}
+	long long result = 0;
+	for( ; i < view.length; i++ ) {
+		if( view.text[i] < '0' || view.text[i] > '9' || result > 2147483647LL ) {
+			return false;
+		}
+		result = result * 10 + ( view.text[i] - '0' );
+	}
+	if( result > 2147483647LL + ( negative ? 1 : 0 ) ) {
+		return false;
+	}
+	*value = (int)( negative ? -result : result );
+	return true;
+}
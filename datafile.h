@@ -0,0 +1,74 @@
+/**
+ * @file include/datafile.h
+ */
+
+#ifndef DATAFILE_H
+#define DATAFILE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#define MAX_FIELDS 16
+
+/**
+ * @brief Read-only view of characters inside a data file; not null-terminated.
+ */
+typedef struct {
+	const char* text;
+	size_t length;
+} StrView;
+
+/**
+ * @brief A pipe-delimited data file mapped into memory.
+ *
+ * Rows are split in place and returned as views into the mapping, so no field is copied until the caller stores
+ * it. Views stay valid until closeDataFile().
+ */
+typedef struct {
+	const char* data;
+	size_t size;
+	size_t position;
+	bool mapped;
+	bool rowTerminated;
+} DataFile;
+
+/**
+ * @brief Map a data file into memory.
+ *
+ * @param file The data file to open.
+ * @param filename The name of the file.
+ * @return 0 on success, -1 if the file could not be opened.
+ */
+int openDataFile( DataFile* file, const char* filename );
+
+/**
+ * @brief Unmap a data file.
+ *
+ * @param file The data file.
+ */
+void closeDataFile( DataFile* file );
+
+/**
+ * @brief Split the next row of a data file into fields.
+ *
+ * Fields are separated by '|' and rows by '\n'; a trailing '\r' is dropped. Separators beyond maxFields - 1 are
+ * kept in the last field. After the call, file->rowTerminated tells whether the row ended with a newline, which
+ * is false only for a final row that was cut short.
+ *
+ * @param file The data file.
+ * @param fields Array to store the fields in.
+ * @param maxFields Size of the fields array.
+ * @return The number of fields in the row, or -1 at end of file.
+ */
+int nextDataRow( DataFile* file, StrView fields[], int maxFields );
+
+/**
+ * @brief Parse a decimal integer field.
+ *
+ * @param view The field.
+ * @param value Pointer to store the value.
+ * @return true if the whole field is a valid integer.
+ */
+bool parseViewInt( StrView view, int* value );
+
+#endif // DATAFILE_H
@@ -0,0 +1,379 @@
+/**
+ * @file src/facets.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include "../include/facets.h"
+#include "../include/catalog.h"
+#include "../include/storelock.h"
+#include "../include/table.h"
+#include "../include/intmap.h"
+#include "../include/bitmap.h"
+
+/**
+ * @brief A distinct genre or venue and the shows that have it.
+ */
+typedef struct {
+	StrId name;
+	Bitmap shows;
+} FacetValue;
+
+static Table genreValues = { .itemSize = sizeof( FacetValue ) };
+static Table venueValues = { .itemSize = sizeof( FacetValue ) };
+static Bitmap priceBands[FACET_PRICE_BANDS];
+static int bandLowest[FACET_PRICE_BANDS];
+static int bandHighest[FACET_PRICE_BANDS];
+static int numPriceBands = 0;
+static Bitmap freeSeatLevels[FREE_SEAT_LEVELS];
+static uint8_t* showLevels = NULL;
+static int numIndexedShows = 0;
+
+/**
+ * @brief Initialize a filter that every show meets.
+ *
+ * @param filter The filter.
+ */
+void initShowFilter( ShowFilter* filter ) {
+	*filter = (ShowFilter){ NULL, NULL, 0, INT_MAX, 0, INT_MAX, 0 };
+}
+
+/**
+ * @brief Order prices from low to high.
+ */
+static int comparePrices( const void* a, const void* b ) {
+	int x = *(const int*)a;
+	int y = *(const int*)b;
+	return ( x > y ) - ( x < y );
+}
+
+/**
+ * @brief Get the free-seat level of a show.
+ *
+ * @param show The show.
+ * @return The number of levels the show belongs to: 0 without free seats, otherwise one more than the base 2
+ *         logarithm of its free seats, at most FREE_SEAT_LEVELS.
+ */
+static int getFreeSeatLevel( const Show* show ) {
+	int level = 0;
+	for( int free = getAvailableSeats( show ); free > 0 && level < FREE_SEAT_LEVELS; free >>= 1 ) {
+		level++;
+	}
+	return level;
+}
+
+/**
+ * @brief Add a show to the bitmap of its genre or venue, adding the value on first use.
+ *
+ * @param values The genre or venue values.
+ * @param index Map from genre or venue to its value.
+ * @param name The genre or venue of the show.
+ * @param position Position of the show in date order.
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+static int addToValue( Table* values, IntMap* index, StrId name, int position ) {
+	int entry;
+	FacetValue* value;
+	if( intMapGet( index, name, &entry ) ) {
+		value = tableAt( values, entry );
+	} else {
+		value = tableAppend( values );
+		if( value == NULL || bitmapInit( &value->shows, numIndexedShows ) != 0 ) {
+			return -1;
+		}
+		value->name = name;
+		if( intMapPut( index, name, values->count - 1 ) != 0 ) {
+			return -1;
+		}
+	}
+	bitmapSet( &value->shows, position );
+	return 0;
+}
+
+/**
+ * @brief Split the distinct prices into bands and build the bitmap of the shows priced up to each band.
+ *
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+static int buildPriceBands() {
+	int* prices = malloc( sizeof( int ) * ( numIndexedShows + 1 ) );
+	if( prices == NULL ) {
+		return -1;
+	}
+	for( int position = 0; position < numIndexedShows; position++ ) {
+		prices[position] = getShowByDateOrder( position )->price;
+	}
+	qsort( prices, numIndexedShows, sizeof( int ), comparePrices );
+	int numDistinct = 0;
+	for( int i = 0; i < numIndexedShows; i++ ) {
+		if( numDistinct == 0 || prices[i] != prices[numDistinct - 1] ) {
+			prices[numDistinct++] = prices[i];
+		}
+	}
+	int bands = numDistinct < FACET_PRICE_BANDS ? numDistinct : FACET_PRICE_BANDS;
+	int result = 0;
+	for( int band = 0; band < bands; band++ ) {
+		bandLowest[band] = prices[(int)( (int64_t)numDistinct * band / bands )];
+		bandHighest[band] = prices[(int)( (int64_t)numDistinct * ( band + 1 ) / bands ) - 1];
+		if( bitmapInit( &priceBands[band], numIndexedShows ) != 0 ) {
+			result = -1;
+			break;
+		}
+		numPriceBands++;
+	}
+	free( prices );
+	if( result != 0 ) {
+		return -1;
+	}
+	for( int position = 0; position < numIndexedShows; position++ ) {
+		int price = getShowByDateOrder( position )->price;
+		int low = 0;
+		int high = numPriceBands - 1;
+		while( low < high ) {
+			int middle = low + ( high - low ) / 2;
+			if( bandHighest[middle] < price ) {
+				low = middle + 1;
+			} else {
+				high = middle;
+			}
+		}
+		bitmapSet( &priceBands[low], position );
+	}
+	// each band so far holds only its own shows; fold in the cheaper bands to get "priced up to this band"
+	for( int band = 1; band < numPriceBands; band++ ) {
+		bitmapOr( &priceBands[band], &priceBands[band - 1] );
+	}
+	return 0;
+}
+
+/**
+ * @brief Build the bitmap indexes over the genre, venue, price and free seats of every show in the catalog.
+ *
+ * Bit n of every bitmap stands for the show at position n in date order, so a date window is a range of bits.
+ * Every genre and venue has the bitmap of its shows. Prices are split into at most FACET_PRICE_BANDS bands of
+ * distinct prices, and band k has the bitmap of the shows priced up to its highest price. Level k of the free seats
+ * has the bitmap of the shows with at least 2^k free seats. Called by the catalog whenever it is loaded, after its
+ * date index is built.
+ *
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+int buildFacetIndex() {
+	freeFacetIndex();
+	numIndexedShows = getShowCount();
+	IntMap genreIndex = { 0 };
+	IntMap venueIndex = { 0 };
+	int result = 0;
+	for( int position = 0; result == 0 && position < numIndexedShows; position++ ) {
+		const Show* show = getShowByDateOrder( position );
+		if( addToValue( &genreValues, &genreIndex, show->type, position ) != 0 ||
+				addToValue( &venueValues, &venueIndex, show->venue, position ) != 0 ) {
+			result = -1;
+		}
+	}
+	intMapFree( &genreIndex );
+	intMapFree( &venueIndex );
+	if( result == 0 ) {
+		result = buildPriceBands();
+	}
+	for( int level = 0; result == 0 && level < FREE_SEAT_LEVELS; level++ ) {
+		result = bitmapInit( &freeSeatLevels[level], numIndexedShows );
+	}
+	showLevels = result == 0 ? calloc( numIndexedShows + 1, sizeof( uint8_t ) ) : NULL;
+	if( showLevels == NULL ) {
+		freeFacetIndex();
+		return -1;
+	}
+	for( int position = 0; position < numIndexedShows; position++ ) {
+		updateFreeSeatFacet( getShowByDateOrder( position ) );
+	}
+	return 0;
+}
+
+/**
+ * @brief Release the bitmaps of the genre or venue values.
+ *
+ * @param values The values.
+ */
+static void freeValues( Table* values ) {
+	for( int i = 0; i < values->count; i++ ) {
+		bitmapFree( &( (FacetValue*)tableAt( values, i ) )->shows );
+	}
+	tableFree( values );
+}
+
+/**
+ * @brief Release the memory held by the facet index.
+ */
+void freeFacetIndex() {
+	freeValues( &genreValues );
+	freeValues( &venueValues );
+	for( int band = 0; band < numPriceBands; band++ ) {
+		bitmapFree( &priceBands[band] );
+	}
+	numPriceBands = 0;
+	for( int level = 0; level < FREE_SEAT_LEVELS; level++ ) {
+		bitmapFree( &freeSeatLevels[level] );
+	}
+	free( showLevels );
+	showLevels = NULL;
+	numIndexedShows = 0;
+}
+
+/**
+ * @brief Move a show to the free-seat levels of its current number of free seats.
+ *
+ * Called with the exclusive store lock held whenever a seat of the show is booked, freed, held or released.
+ *
+ * @param show The show.
+ */
+void updateFreeSeatFacet( const Show* show ) {
+	// seats change while the catalog is loaded too, before the index exists
+	if( showLevels == NULL || show->position < 0 || show->position >= numIndexedShows ||
+			getShowByDateOrder( show->position ) != show ) {
+		return;
+	}
+	int level = getFreeSeatLevel( show );
+	int previous = showLevels[show->position];
+	for( int i = level; i < previous; i++ ) {
+		bitmapClear( &freeSeatLevels[i], show->position );
+	}
+	for( int i = previous; i < level; i++ ) {
+		bitmapSet( &freeSeatLevels[i], show->position );
+	}
+	showLevels[show->position] = (uint8_t)level;
+}
+
+/**
+ * @brief Compare two strings, ignoring the case of ASCII letters.
+ *
+ * @param a The first string.
+ * @param b The second string.
+ * @return true if they are equal.
+ */
+static bool equalsIgnoringCase( const char* a, const char* b ) {
+	for( ; *a != '\0' && *b != '\0'; a++, b++ ) {
+		char x = *a >= 'A' && *a <= 'Z' ? (char)( *a - 'A' + 'a' ) : *a;
+		char y = *b >= 'A' && *b <= 'Z' ? (char)( *b - 'A' + 'a' ) : *b;
+		if( x != y ) {
+			return false;
+		}
+	}
+	return *a == *b;
+}
+
+/**
+ * @brief Keep only the shows that have a genre or venue.
+ *
+ * @param matches The shows found so far.
+ * @param values The genre or venue values.
+ * @param name The genre or venue.
+ */
+static void keepValue( Bitmap* matches, const Table* values, const char* name ) {
+	for( int i = 0; i < values->count; i++ ) {
+		const FacetValue* value = tableAt( values, i );
+		if( equalsIgnoringCase( getString( value->name ), name ) ) {
+			bitmapAnd( matches, &value->shows );
+			return;
+		}
+	}
+	bitmapAnd( matches, &(Bitmap){ NULL, 0 } );
+}
+
+/**
+ * @brief Keep only the shows in the price bands that overlap a price range.
+ *
+ * @param matches The shows found so far.
+ * @param minPrice The lowest price.
+ * @param maxPrice The highest price.
+ * @return true if a band is only partly in the range, so the price of the shows left still has to be checked.
+ */
+static bool keepPriceRange( Bitmap* matches, int minPrice, int maxPrice ) {
+	int first = 0;
+	while( first < numPriceBands && bandHighest[first] < minPrice ) {
+		first++;
+	}
+	int last = numPriceBands - 1;
+	while( last >= 0 && bandLowest[last] > maxPrice ) {
+		last--;
+	}
+	if( minPrice > maxPrice || first > last ) {
+		bitmapAnd( matches, &(Bitmap){ NULL, 0 } );
+		return false;
+	}
+	bitmapAnd( matches, &priceBands[last] );
+	if( first > 0 ) {
+		bitmapAndNot( matches, &priceBands[first - 1] );
+	}
+	return bandLowest[first] < minPrice || bandHighest[last] > maxPrice;
+}
+
+/**
+ * @brief Keep only the shows at the highest free-seat level that all shows with enough free seats are in.
+ *
+ * @param matches The shows found so far.
+ * @param minFreeSeats The least number of free seats, at least 1.
+ * @return true if that level also has shows with fewer free seats, so the shows left still have to be checked.
+ */
+static bool keepFreeSeats( Bitmap* matches, int minFreeSeats ) {
+	int level = 0;
+	while( level + 1 < FREE_SEAT_LEVELS && ( minFreeSeats >> ( level + 1 ) ) > 0 ) {
+		level++;
+	}
+	bitmapAnd( matches, &freeSeatLevels[level] );
+	return minFreeSeats != 1 << level;
+}
+
+/**
+ * @brief Find the shows that meet a filter, in date order.
+ *
+ * The bitmaps of the conditions are intersected a word at a time. Only when a price range or number of free seats
+ * falls inside a band or level are the remaining shows checked one by one. Takes the store lock for reading.
+ *
+ * @param filter The filter.
+ * @param positions Array to store the date order positions of the matching shows in.
+ * @param maxResults Size of the array.
+ * @return The number of matching shows, which may exceed maxResults, or -1 if memory could not be allocated.
+ */
+int filterShows( const ShowFilter* filter, int positions[], int maxResults ) {
+	lockStoreForReading();
+	Bitmap matches;
+	if( bitmapInit( &matches, numIndexedShows ) != 0 ) {
+		unlockStoreForReading();
+		return -1;
+	}
+	int first = findFirstShowOnOrAfter( filter->fromDay );
+	int end = filter->toDay < INT_MAX ? findFirstShowOnOrAfter( filter->toDay + 1 ) : numIndexedShows;
+	bitmapSetRange( &matches, first, end );
+	if( filter->genre != NULL ) {
+		keepValue( &matches, &genreValues, filter->genre );
+	}
+	if( filter->venue != NULL ) {
+		keepValue( &matches, &venueValues, filter->venue );
+	}
+	bool check = false;
+	if( filter->minPrice > 0 || filter->maxPrice < INT_MAX ) {
+		check = keepPriceRange( &matches, filter->minPrice, filter->maxPrice );
+	}
+	if( filter->minFreeSeats > 0 ) {
+		check = keepFreeSeats( &matches, filter->minFreeSeats ) || check;
+	}
+	int count = 0;
+	for( int position = bitmapNextSet( &matches, first ); position >= 0;
+			position = bitmapNextSet( &matches, position + 1 ) ) {
+		const Show* show = getShowByDateOrder( position );
+		if( check && ( show->price < filter->minPrice || show->price > filter->maxPrice ||
+				getAvailableSeats( show ) < filter->minFreeSeats ) ) {
+			continue;
+		}
+		if( count < maxResults ) {
+			positions[count] = position;
+		}
+		count++;
+	}
+	unlockStoreForReading();
+	bitmapFree( &matches );
+	return count;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file include/facets.h
+ */
+
+#ifndef FACETS_H
+#define FACETS_H
+
+#include "utilities.h"
+
+#define FACET_PRICE_BANDS 64
+#define FREE_SEAT_LEVELS 16
+
+/**
+ * @brief Conditions a show has to meet; initialize with initShowFilter() and set only the ones that apply.
+ *
+ * Genre and venue match whole values, ignoring the case of ASCII letters. Prices and days are inclusive ranges.
+ */
+typedef struct {
+	const char* genre;
+	const char* venue;
+	int minPrice;
+	int maxPrice;
+	int fromDay;
+	int toDay;
+	int minFreeSeats;
+} ShowFilter;
+
+/**
+ * @brief Initialize a filter that every show meets.
+ *
+ * @param filter The filter.
+ */
+void initShowFilter( ShowFilter* filter );
+
+/**
+ * @brief Build the bitmap indexes over the genre, venue, price and free seats of every show in the catalog.
+ *
+ * Bit n of every bitmap stands for the show at position n in date order, so a date window is a range of bits.
+ * Every genre and venue has the bitmap of its shows. Prices are split into at most FACET_PRICE_BANDS bands of
+ * distinct prices, and band k has the bitmap of the shows priced up to its highest price. Level k of the free seats
+ * has the bitmap of the shows with at least 2^k free seats. Called by the catalog whenever it is loaded, after its
+ * date index is built.
+ *
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+int buildFacetIndex();
+
+/**
+ * @brief Release the memory held by the facet index.
+ */
+void freeFacetIndex();
+
+/**
+ * @brief Move a show to the free-seat levels of its current number of free seats.
+ *
+ * Called with the exclusive store lock held whenever a seat of the show is booked, freed, held or released.
+ *
+ * @param show The show.
+ */
+void updateFreeSeatFacet( const Show* show );
+
+/**
+ * @brief Find the shows that meet a filter, in date order.
+ *
+ * The bitmaps of the conditions are intersected a word at a time. Only when a price range or number of free seats
+ * falls inside a band or level are the remaining shows checked one by one. Takes the store lock for reading.
+ *
+ * @param filter The filter.
+ * @param positions Array to store the date order positions of the matching shows in.
+ * @param maxResults Size of the array.
+ * @return The number of matching shows, which may exceed maxResults, or -1 if memory could not be allocated.
+ */
+int filterShows( const ShowFilter* filter, int positions[], int maxResults );
+
+#endif // FACETS_H
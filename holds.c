@@ -0,0 +1,263 @@
+/**
+ * @file src/holds.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "../include/holds.h"
+#include "../include/table.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+
+#include <windows.h>
+
+static SRWLOCK holdsLock = SRWLOCK_INIT;
+
+#define lockHolds() AcquireSRWLockExclusive( &holdsLock )
+#define unlockHolds() ReleaseSRWLockExclusive( &holdsLock )
+
+#else
+
+#include <pthread.h>
+
+static pthread_mutex_t holdsLock = PTHREAD_MUTEX_INITIALIZER;
+
+#define lockHolds() pthread_mutex_lock( &holdsLock )
+#define unlockHolds() pthread_mutex_unlock( &holdsLock )
+
+#endif
+
+#define HOLD_INDEX_MASK ( ( 1 << HOLD_INDEX_BITS ) - 1 )
+#define HOLD_SEQUENCE_LIMIT ( ( 1 << ( 31 - HOLD_INDEX_BITS ) ) - 1 )
+
+/**
+ * @brief Slot of the hold table.
+ *
+ * A live hold sits in the list of the wheel slot of its expiry second; a free slot sits in the free list.
+ */
+typedef struct {
+	int holdId;
+	int userId;
+	int showId;
+	int count;
+	int* seats;
+	int64_t expiresAt;
+	int prev;
+	int next;
+} HoldEntry;
+
+static Table holdEntries = { .itemSize = sizeof( HoldEntry ) };
+static int wheel[HOLD_WHEEL_SLOTS];
+static bool wheelReady = false;
+static int64_t wheelTime = 0;
+static int freeEntries = -1;
+static int holdSequence = 0;
+static int holdSeconds = DEFAULT_HOLD_SECONDS;
+
+/**
+ * @brief Read a monotonic clock.
+ *
+ * @return Seconds since an arbitrary point.
+ */
+static int64_t nowSeconds() {
+	#if defined(_WIN32) || defined(_WIN64)
+	return (int64_t)( GetTickCount64() / 1000 );
+	#else
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return (int64_t)now.tv_sec;
+	#endif
+}
+
+/**
+ * @brief Empty the timer wheel on first use.
+ *
+ * @param now The current second.
+ */
+static void prepareWheel( int64_t now ) {
+	if( wheelReady ) {
+		return;
+	}
+	for( int i = 0; i < HOLD_WHEEL_SLOTS; i++ ) {
+		wheel[i] = -1;
+	}
+	wheelTime = now;
+	wheelReady = true;
+}
+
+/**
+ * @brief Add a hold to the list of the wheel slot of its expiry second.
+ *
+ * @param index Position of the hold in the table.
+ */
+static void linkHold( int index ) {
+	HoldEntry* entry = tableAt( &holdEntries, index );
+	int slot = (int)( entry->expiresAt % HOLD_WHEEL_SLOTS );
+	entry->prev = -1;
+	entry->next = wheel[slot];
+	if( wheel[slot] >= 0 ) {
+		( (HoldEntry*)tableAt( &holdEntries, wheel[slot] ) )->prev = index;
+	}
+	wheel[slot] = index;
+}
+
+/**
+ * @brief Remove a hold from the wheel, hand it to the caller and free its table slot.
+ *
+ * @param index Position of the hold in the table.
+ * @param hold Pointer to store the hold.
+ */
+static void removeHold( int index, SeatHold* hold ) {
+	HoldEntry* entry = tableAt( &holdEntries, index );
+	if( entry->prev >= 0 ) {
+		( (HoldEntry*)tableAt( &holdEntries, entry->prev ) )->next = entry->next;
+	} else {
+		wheel[entry->expiresAt % HOLD_WHEEL_SLOTS] = entry->next;
+	}
+	if( entry->next >= 0 ) {
+		( (HoldEntry*)tableAt( &holdEntries, entry->next ) )->prev = entry->prev;
+	}
+	hold->holdId = entry->holdId;
+	hold->userId = entry->userId;
+	hold->showId = entry->showId;
+	hold->count = entry->count;
+	hold->seats = entry->seats;
+	entry->holdId = -1;
+	entry->seats = NULL;
+	entry->next = freeEntries;
+	freeEntries = index;
+}
+
+/**
+ * @brief Set how long new holds last.
+ *
+ * @param seconds Lifetime of a hold in seconds; values below 1 restore DEFAULT_HOLD_SECONDS.
+ */
+void setHoldSeconds( int seconds ) {
+	holdSeconds = seconds >= 1 ? seconds : DEFAULT_HOLD_SECONDS;
+}
+
+/**
+ * @brief Get how long new holds last.
+ *
+ * @return Lifetime of a hold in seconds.
+ */
+int getHoldSeconds() {
+	return holdSeconds;
+}
+
+/**
+ * @brief Register a hold on seats and schedule its expiry.
+ *
+ * Only records the hold; marking the seats as held in the catalog is up to the caller.
+ *
+ * @param userId The ID of the user.
+ * @param showId The ID of the show.
+ * @param seats The seat numbers, copied.
+ * @param count Number of seats.
+ * @return The ID of the hold, or -1 if it could not be stored.
+ */
+int addHold( int userId, int showId, const int seats[], int count ) {
+	int* copy = malloc( sizeof( int ) * ( count > 0 ? count : 1 ) );
+	if( copy == NULL ) {
+		return -1;
+	}
+	memcpy( copy, seats, sizeof( int ) * count );
+	lockHolds();
+	int64_t now = nowSeconds();
+	prepareWheel( now );
+	int index = freeEntries;
+	if( index >= 0 ) {
+		freeEntries = ( (HoldEntry*)tableAt( &holdEntries, index ) )->next;
+	} else if( holdEntries.count <= HOLD_INDEX_MASK && tableAppend( &holdEntries ) != NULL ) {
+		index = holdEntries.count - 1;
+	} else {
+		unlockHolds();
+		free( copy );
+		return -1;
+	}
+	HoldEntry* entry = tableAt( &holdEntries, index );
+	holdSequence = holdSequence % HOLD_SEQUENCE_LIMIT + 1;
+	entry->holdId = ( holdSequence << HOLD_INDEX_BITS ) | index;
+	entry->userId = userId;
+	entry->showId = showId;
+	entry->count = count;
+	entry->seats = copy;
+	entry->expiresAt = now + holdSeconds;
+	linkHold( index );
+	int holdId = entry->holdId;
+	unlockHolds();
+	return holdId;
+}
+
+/**
+ * @brief Remove a hold that has not expired yet.
+ *
+ * @param holdId The ID of the hold.
+ * @param userId The ID of the user who must own the hold, or -1 to skip the check.
+ * @param hold Pointer to store the hold; release it with freeHold().
+ * @return true if the hold was found and removed.
+ */
+bool takeHold( int holdId, int userId, SeatHold* hold ) {
+	int index = holdId & HOLD_INDEX_MASK;
+	bool found = false;
+	lockHolds();
+	if( holdId >= 0 && index < holdEntries.count ) {
+		const HoldEntry* entry = tableAt( &holdEntries, index );
+		if( entry->holdId == holdId && entry->expiresAt > nowSeconds() && ( userId < 0 || entry->userId == userId ) ) {
+			removeHold( index, hold );
+			found = true;
+		}
+	}
+	unlockHolds();
+	return found;
+}
+
+/**
+ * @brief Remove holds whose time has run out.
+ *
+ * Advances the timer wheel to the current second, visiting only the slots of the seconds that passed. Stops early
+ * when the array is full; call again until it returns less than max.
+ *
+ * @param expired Array to store the removed holds in; release each with freeHold().
+ * @param max Number of entries of the array.
+ * @return Number of removed holds.
+ */
+int takeExpiredHolds( SeatHold expired[], int max ) {
+	int numExpired = 0;
+	lockHolds();
+	int64_t now = nowSeconds();
+	prepareWheel( now );
+	int64_t second = now - wheelTime > HOLD_WHEEL_SLOTS ? now - HOLD_WHEEL_SLOTS + 1 : wheelTime + 1;
+	for( ; second <= now; second++ ) {
+		int index = wheel[second % HOLD_WHEEL_SLOTS];
+		while( index >= 0 ) {
+			const HoldEntry* entry = tableAt( &holdEntries, index );
+			int next = entry->next;
+			if( entry->expiresAt <= now ) {
+				if( numExpired == max ) {
+					unlockHolds();
+					return numExpired;
+				}
+				removeHold( index, &expired[numExpired++] );
+			}
+			index = next;
+		}
+		wheelTime = second;
+	}
+	unlockHolds();
+	return numExpired;
+}
+
+/**
+ * @brief Release the memory of a removed hold.
+ *
+ * @param hold The hold.
+ */
+void freeHold( SeatHold* hold ) {
+	free( hold->seats );
+	hold->seats = NULL;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file include/holds.h
+ */
+
+#ifndef HOLDS_H
+#define HOLDS_H
+
+#include <stdbool.h>
+
+#define HOLD_WHEEL_SLOTS 256
+#define HOLD_INDEX_BITS 20
+#define DEFAULT_HOLD_SECONDS 300
+
+/**
+ * @brief Seats a user has reserved for a limited time while paying.
+ */
+typedef struct {
+	int holdId;
+	int userId;
+	int showId;
+	int count;
+	int* seats;
+} SeatHold;
+
+/**
+ * @brief Set how long new holds last.
+ *
+ * @param seconds Lifetime of a hold in seconds; values below 1 restore DEFAULT_HOLD_SECONDS.
+ */
+void setHoldSeconds( int seconds );
+
+/**
+ * @brief Get how long new holds last.
+ *
+ * @return Lifetime of a hold in seconds.
+ */
+int getHoldSeconds();
+
+/**
+ * @brief Register a hold on seats and schedule its expiry.
+ *
+ * Only records the hold; marking the seats as held in the catalog is up to the caller.
+ *
+ * @param userId The ID of the user.
+ * @param showId The ID of the show.
+ * @param seats The seat numbers, copied.
+ * @param count Number of seats.
+ * @return The ID of the hold, or -1 if it could not be stored.
+ */
+int addHold( int userId, int showId, const int seats[], int count );
+
+/**
+ * @brief Remove a hold that has not expired yet.
+ *
+ * @param holdId The ID of the hold.
+ * @param userId The ID of the user who must own the hold, or -1 to skip the check.
+ * @param hold Pointer to store the hold; release it with freeHold().
+ * @return true if the hold was found and removed.
+ */
+bool takeHold( int holdId, int userId, SeatHold* hold );
+
+/**
+ * @brief Remove holds whose time has run out.
+ *
+ * Advances the timer wheel to the current second, visiting only the slots of the seconds that passed. Stops early
+ * when the array is full; call again until it returns less than max.
+ *
+ * @param expired Array to store the removed holds in; release each with freeHold().
+ * @param max Number of entries of the array.
+ * @return Number of removed holds.
+ */
+int takeExpiredHolds( SeatHold expired[], int max );
+
+/**
+ * @brief Release the memory of a removed hold.
+ *
+ * @param hold The hold.
+ */
+void freeHold( SeatHold* hold );
+
+#endif // HOLDS_H
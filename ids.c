@@ -0,0 +1,379 @@
+/**
+ * @file src/ids.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include "../include/ids.h"
+#include "../include/utilities.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+
+#include <windows.h>
+
+#define IDS_THREAD_LOCAL __declspec( thread )
+
+static SRWLOCK idsLock = SRWLOCK_INIT;
+
+#define lockIds() AcquireSRWLockExclusive( &idsLock )
+#define unlockIds() ReleaseSRWLockExclusive( &idsLock )
+
+#else
+
+#include <pthread.h>
+
+#define IDS_THREAD_LOCAL __thread
+
+static pthread_mutex_t idsLock = PTHREAD_MUTEX_INITIALIZER;
+
+#define lockIds() pthread_mutex_lock( &idsLock )
+#define unlockIds() pthread_mutex_unlock( &idsLock )
+
+#endif
+
+#define ID_HALF_BITS 18
+#define ID_HALF_MASK ( ( 1u << ID_HALF_BITS ) - 1 )
+#define ID_ROUNDS 4
+
+/**
+ * @brief A sequence of unique numbers below domain and the keys of the permutation that scrambles it.
+ */
+typedef struct {
+	uint64_t domain;
+	uint32_t keys[ID_ROUNDS];
+	uint64_t next;
+	uint64_t reserved;
+} IdSequence;
+
+/**
+ * @brief Sequence numbers a thread has taken and not used yet.
+ */
+typedef struct {
+	uint64_t next;
+	uint64_t end;
+} IdBlock;
+
+// 26^3 * 10^5 * 26 ticket numbers and 36^3 * 10^6 transaction numbers, both just below 2^36
+static IdSequence ticketSequence = { 45697600000ull, { 0x5bd1e995u, 0x1b873593u, 0xcc9e2d51u, 0x85ebca6bu }, 0, 0 };
+static IdSequence transactionSequence = { 46656000000ull, { 0x27d4eb2fu, 0x165667b1u, 0xc2b2ae3du, 0x9e3779b1u },
+										  0, 0 };
+static IDS_THREAD_LOCAL IdBlock ticketBlock = { 0, 0 };
+static IDS_THREAD_LOCAL IdBlock transactionBlock = { 0, 0 };
+static char idsFilename[MAX_LENGTH] = "";
+static uint64_t reserveSize = ID_BLOCK_SIZE;
+
+/**
+ * @brief Atomically add to a sequence counter.
+ *
+ * @param counter The counter.
+ * @param delta The amount to add.
+ * @return The value before the addition.
+ */
+static uint64_t fetchAdd( uint64_t* counter, uint64_t delta ) {
+	#if defined(__GNUC__) || defined(__clang__)
+	return __atomic_fetch_add( counter, delta, __ATOMIC_RELAXED );
+	#elif defined(_WIN32) || defined(_WIN64)
+	return (uint64_t)InterlockedExchangeAdd64( (volatile LONG64*)counter, (LONG64)delta );
+	#else
+	uint64_t value = *counter;
+	*counter += delta;
+	return value;
+	#endif
+}
+
+/**
+ * @brief Atomically replace a sequence counter that still holds an expected value.
+ *
+ * @param counter The counter.
+ * @param expected The value the counter must hold.
+ * @param value The new value.
+ * @return true if the counter held the expected value and was replaced.
+ */
+static bool compareExchange( uint64_t* counter, uint64_t expected, uint64_t value ) {
+	#if defined(__GNUC__) || defined(__clang__)
+	return __atomic_compare_exchange_n( counter, &expected, value, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED );
+	#elif defined(_WIN32) || defined(_WIN64)
+	return (uint64_t)InterlockedCompareExchange64( (volatile LONG64*)counter, (LONG64)value, (LONG64)expected ) ==
+		   expected;
+	#else
+	if( *counter != expected ) {
+		return false;
+	}
+	*counter = value;
+	return true;
+	#endif
+}
+
+/**
+ * @brief Read a high-water mark that may be raised by other threads.
+ *
+ * @param mark The mark.
+ * @return Its value.
+ */
+static uint64_t readMark( const uint64_t* mark ) {
+	#if defined(__GNUC__) || defined(__clang__)
+	return __atomic_load_n( mark, __ATOMIC_ACQUIRE );
+	#else
+	return *(volatile const uint64_t*)mark;
+	#endif
+}
+
+/**
+ * @brief Raise a high-water mark once it has been saved.
+ *
+ * @param mark The mark.
+ * @param value The new value.
+ */
+static void storeMark( uint64_t* mark, uint64_t value ) {
+	#if defined(__GNUC__) || defined(__clang__)
+	__atomic_store_n( mark, value, __ATOMIC_RELEASE );
+	#else
+	*(volatile uint64_t*)mark = value;
+	#endif
+}
+
+/**
+ * @brief Write both high-water marks to the ID file.
+ *
+ * Called with the ID lock held.
+ *
+ * @param ticketMark The ticket mark to save.
+ * @param transactionMark The transaction mark to save.
+ * @return 0 on success, -1 if the file could not be written.
+ */
+static int saveMarks( uint64_t ticketMark, uint64_t transactionMark ) {
+	if( idsFilename[0] == '\0' ) {
+		return 0;
+	}
+	char tempFilename[MAX_LENGTH + 4];
+	snprintf( tempFilename, sizeof( tempFilename ), "%s.tmp", idsFilename );
+	FILE* file = fopen( tempFilename, "w" );
+	if( file == NULL ) {
+		return -1;
+	}
+	fprintf( file, "%" PRIu64 "|%" PRIu64 "\n", ticketMark, transactionMark );
+	return fclose( file ) == 0 ? replaceFile( tempFilename, idsFilename ) : -1;
+}
+
+/**
+ * @brief Load the ID high-water marks and remember where to save them.
+ *
+ * Ticket and transaction numbers are sequence numbers scrambled by a fixed permutation, so they look random but
+ * never repeat. Each thread takes blocks of ID_BLOCK_SIZE sequence numbers at a time, and the file records how far
+ * the sequences may have been used, in steps of the reserve size, so that numbers are not reused after a restart.
+ * Without a loaded file the sequences start at zero and are not saved.
+ *
+ * @param filename The name of the ID file; a missing file starts both sequences at zero.
+ * @return 0 on success, -1 if the file exists but could not be read.
+ */
+int loadIdSequences( const char* filename ) {
+	uint64_t ticketMark = 0;
+	uint64_t transactionMark = 0;
+	FILE* file = fopen( filename, "r" );
+	if( file != NULL ) {
+		int fields = fscanf( file, "%" SCNu64 "|%" SCNu64, &ticketMark, &transactionMark );
+		fclose( file );
+		if( fields != 2 ) {
+			return -1;
+		}
+	}
+	lockIds();
+	snprintf( idsFilename, sizeof( idsFilename ), "%s", filename );
+	ticketSequence.next = ticketSequence.reserved = ticketMark;
+	transactionSequence.next = transactionSequence.reserved = transactionMark;
+	unlockIds();
+	return 0;
+}
+
+/**
+ * @brief Set how far ahead of the numbers in use the ID file reserves.
+ *
+ * A short-lived process keeps the default of one block, so it only marks what it takes; the daemon reserves
+ * ID_RESERVE_SIZE so that its threads rarely have to save the file.
+ *
+ * @param size Number of sequence numbers per reservation; values below ID_BLOCK_SIZE restore ID_BLOCK_SIZE.
+ */
+void setIdReserveSize( int size ) {
+	lockIds();
+	reserveSize = size > ID_BLOCK_SIZE ? (uint64_t)size : ID_BLOCK_SIZE;
+	unlockIds();
+}
+
+/**
+ * @brief Take the next block of a sequence for the calling thread.
+ *
+ * The sequence counter is shared, so the ID lock is only taken when the block runs past the saved high-water mark.
+ *
+ * @param sequence The sequence.
+ * @param block The block of the calling thread.
+ * @return 0 on success, -1 if the high-water mark could not be saved or the sequence is exhausted.
+ */
+static int takeBlock( IdSequence* sequence, IdBlock* block ) {
+	uint64_t start = fetchAdd( &sequence->next, ID_BLOCK_SIZE );
+	uint64_t end = start + ID_BLOCK_SIZE;
+	if( end > sequence->domain ) {
+		return -1;
+	}
+	if( end > readMark( &sequence->reserved ) ) {
+		lockIds();
+		int result = 0;
+		if( end > sequence->reserved ) {
+			uint64_t mark = ( end + reserveSize - 1 ) / reserveSize * reserveSize;
+			result = sequence == &ticketSequence ? saveMarks( mark, transactionSequence.reserved )
+												 : saveMarks( ticketSequence.reserved, mark );
+			if( result == 0 ) {
+				storeMark( &sequence->reserved, mark );
+			}
+		}
+		unlockIds();
+		if( result != 0 ) {
+			return -1;
+		}
+	}
+	block->next = start;
+	block->end = end;
+	return 0;
+}
+
+/**
+ * @brief Give back the unused rest of the calling thread's block if no block was taken after it.
+ *
+ * Called with the ID lock held.
+ *
+ * @param sequence The sequence.
+ * @param block The block of the calling thread.
+ * @return true if numbers were given back; the sequence counter is then the end of the numbers in use.
+ */
+static bool giveBackBlock( IdSequence* sequence, IdBlock* block ) {
+	if( block->next == block->end || !compareExchange( &sequence->next, block->end, block->next ) ) {
+		return false;
+	}
+	block->end = block->next;
+	return true;
+}
+
+/**
+ * @brief Give back the numbers the calling thread has taken but not used, and save the marks actually used.
+ *
+ * Numbers are only given back while no other thread has taken a block after the calling thread's, so called when
+ * the process is done with the ticket store this leaves the file at the last number handed out.
+ *
+ * @return 0 on success, -1 if the ID file could not be written.
+ */
+int saveIdSequences() {
+	lockIds();
+	uint64_t ticketMark = ticketSequence.reserved;
+	uint64_t transactionMark = transactionSequence.reserved;
+	if( giveBackBlock( &ticketSequence, &ticketBlock ) ) {
+		ticketMark = readMark( &ticketSequence.next );
+	}
+	if( giveBackBlock( &transactionSequence, &transactionBlock ) ) {
+		transactionMark = readMark( &transactionSequence.next );
+	}
+	int result = 0;
+	if( ticketMark != ticketSequence.reserved || transactionMark != transactionSequence.reserved ) {
+		result = saveMarks( ticketMark, transactionMark );
+		if( result == 0 ) {
+			storeMark( &ticketSequence.reserved, ticketMark );
+			storeMark( &transactionSequence.reserved, transactionMark );
+		}
+	}
+	unlockIds();
+	return result;
+}
+
+/**
+ * @brief Scramble a sequence number into a unique number of the same domain.
+ *
+ * A four-round Feistel network over two 18-bit halves is a bijection on 36-bit numbers; results at or above the
+ * domain are fed through again until they fall inside it, which keeps the mapping a bijection on the domain.
+ *
+ * @param sequence The sequence.
+ * @param value The sequence number, below the domain.
+ * @return The scrambled number, below the domain.
+ */
+static uint64_t permute( const IdSequence* sequence, uint64_t value ) {
+	do {
+		uint32_t left = (uint32_t)( value >> ID_HALF_BITS );
+		uint32_t right = (uint32_t)value & ID_HALF_MASK;
+		for( int round = 0; round < ID_ROUNDS; round++ ) {
+			uint32_t mixed = ( right ^ sequence->keys[round] ) * 0x9e3779b1u;
+			mixed ^= mixed >> 15;
+			uint32_t next = left ^ ( mixed & ID_HALF_MASK );
+			left = right;
+			right = next;
+		}
+		value = ( (uint64_t)left << ID_HALF_BITS ) | right;
+	} while( value >= sequence->domain );
+	return value;
+}
+
+/**
+ * @brief Get the next scrambled number of a sequence for the calling thread.
+ *
+ * @param sequence The sequence.
+ * @param block The block of the calling thread.
+ * @param value Pointer to store the number.
+ * @return 0 on success, -1 if no number is available.
+ */
+static int nextId( IdSequence* sequence, IdBlock* block, uint64_t* value ) {
+	if( block->next == block->end && takeBlock( sequence, block ) != 0 ) {
+		return -1;
+	}
+	*value = permute( sequence, block->next++ );
+	return 0;
+}
+
+/**
+ * @brief Generate a unique ticket number with the pattern of 3 letters, 5 numbers, and 1 letter.
+ *
+ * @param ticketNumber The array to store the ticket number in.
+ * @param size The size of the array, at least 10.
+ * @return 0 on success, -1 if the high-water mark could not be saved or the numbers are exhausted.
+ */
+int nextTicketNumber( char* ticketNumber, size_t size ) {
+	uint64_t value;
+	if( size < 10 || nextId( &ticketSequence, &ticketBlock, &value ) != 0 ) {
+		return -1;
+	}
+	ticketNumber[8] = (char)( 'A' + value % 26 );
+	value /= 26;
+	for( int i = 7; i >= 3; i-- ) {
+		ticketNumber[i] = (char)( '0' + value % 10 );
+		value /= 10;
+	}
+	for( int i = 2; i >= 0; i-- ) {
+		ticketNumber[i] = (char)( 'A' + value % 26 );
+		value /= 26;
+	}
+	ticketNumber[9] = '\0';
+	return 0;
+}
+
+/**
+ * @brief Generate a unique transaction number with the pattern of 3 letters or numbers and 6 numbers.
+ *
+ * @param transactionNumber The array to store the transaction number in.
+ * @param size The size of the array, at least 10.
+ * @return 0 on success, -1 if the high-water mark could not be saved or the numbers are exhausted.
+ */
+int nextTransactionNumber( char* transactionNumber, size_t size ) {
+	static const char characters[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	uint64_t value;
+	if( size < 10 || nextId( &transactionSequence, &transactionBlock, &value ) != 0 ) {
+		return -1;
+	}
+	for( int i = 8; i >= 3; i-- ) {
+		transactionNumber[i] = (char)( '0' + value % 10 );
+		value /= 10;
+	}
+	for( int i = 2; i >= 0; i-- ) {
+		transactionNumber[i] = characters[value % 36];
+		value /= 36;
+	}
+	transactionNumber[9] = '\0';
+	return 0;
+}
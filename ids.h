@@ -0,0 +1,64 @@
+/**
+ * @file include/ids.h
+ */
+
+#ifndef IDS_H
+#define IDS_H
+
+#include <stddef.h>
+
+#define ID_BLOCK_SIZE 256
+#define ID_RESERVE_SIZE 65536
+
+/**
+ * @brief Load the ID high-water marks and remember where to save them.
+ *
+ * Ticket and transaction numbers are sequence numbers scrambled by a fixed permutation, so they look random but
+ * never repeat. Each thread takes blocks of ID_BLOCK_SIZE sequence numbers at a time, and the file records how far
+ * the sequences may have been used, in steps of the reserve size, so that numbers are not reused after a restart.
+ * Without a loaded file the sequences start at zero and are not saved.
+ *
+ * @param filename The name of the ID file; a missing file starts both sequences at zero.
+ * @return 0 on success, -1 if the file exists but could not be read.
+ */
+int loadIdSequences( const char* filename );
+
+/**
+ * @brief Set how far ahead of the numbers in use the ID file reserves.
+ *
+ * A short-lived process keeps the default of one block, so it only marks what it takes; the daemon reserves
+ * ID_RESERVE_SIZE so that its threads rarely have to save the file.
+ *
+ * @param size Number of sequence numbers per reservation; values below ID_BLOCK_SIZE restore ID_BLOCK_SIZE.
+ */
+void setIdReserveSize( int size );
+
+/**
+ * @brief Give back the numbers the calling thread has taken but not used, and save the marks actually used.
+ *
+ * Numbers are only given back while no other thread has taken a block after the calling thread's, so called when
+ * the process is done with the ticket store this leaves the file at the last number handed out.
+ *
+ * @return 0 on success, -1 if the ID file could not be written.
+ */
+int saveIdSequences();
+
+/**
+ * @brief Generate a unique ticket number with the pattern of 3 letters, 5 numbers, and 1 letter.
+ *
+ * @param ticketNumber The array to store the ticket number in.
+ * @param size The size of the array, at least 10.
+ * @return 0 on success, -1 if the high-water mark could not be saved or the numbers are exhausted.
+ */
+int nextTicketNumber( char* ticketNumber, size_t size );
+
+/**
+ * @brief Generate a unique transaction number with the pattern of 3 letters or numbers and 6 numbers.
+ *
+ * @param transactionNumber The array to store the transaction number in.
+ * @param size The size of the array, at least 10.
+ * @return 0 on success, -1 if the high-water mark could not be saved or the numbers are exhausted.
+ */
+int nextTransactionNumber( char* transactionNumber, size_t size );
+
+#endif // IDS_H
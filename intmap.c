@@ -0,0 +1,183 @@
+/**
+ * @file src/intmap.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/intmap.h"
+
+#define INITIAL_INTMAP_CAPACITY 64
+
+/**
+ * @brief Mix the bits of a key so that sequential keys spread over the table.
+ *
+ * @param key The key.
+ * @return The hash.
+ */
+static uint64_t hashKey( uint64_t key ) {
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53ULL;
+	key ^= key >> 33;
+	return key;
+}
+
+/**
+ * @brief Find the slot holding a key, or the empty slot where it belongs.
+ *
+ * @param map The map, with a non-zero capacity.
+ * @param key The key.
+ * @return The slot.
+ */
+static size_t findSlot( const IntMap* map, uint64_t key ) {
+	size_t slot = hashKey( key ) & ( map->capacity - 1 );
+	while( map->keys[slot] != INTMAP_EMPTY_KEY && map->keys[slot] != key ) {
+		slot = ( slot + 1 ) & ( map->capacity - 1 );
+	}
+	return slot;
+}
+
+/**
+ * @brief Move the entries of a map into a table of a larger capacity.
+ *
+ * @param map The map.
+ * @param capacity The new capacity, a power of two.
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+static int resizeMap( IntMap* map, size_t capacity ) {
+	IntMap grown;
+	grown.capacity = capacity;
+	grown.count = map->count;
+	grown.keys = malloc( sizeof( uint64_t ) * grown.capacity );
+	grown.values = malloc( sizeof( int ) * grown.capacity );
+	if( grown.keys == NULL || grown.values == NULL ) {
+		free( grown.keys );
+		free( grown.values );
+		return -1;
+	}
+	memset( grown.keys, 0xFF, sizeof( uint64_t ) * grown.capacity );
+	for( size_t i = 0; i < map->capacity; i++ ) {
+		if( map->keys[i] != INTMAP_EMPTY_KEY ) {
+			size_t slot = findSlot( &grown, map->keys[i] );
+			grown.keys[slot] = map->keys[i];
+			grown.values[slot] = map->values[i];
+		}
+	}
+	free( map->keys );
+	free( map->values );
+	*map = grown;
+	return 0;
+}
+
+/**
+ * @brief Insert a key or replace its value.
+ *
+ * @param map The map.
+ * @param key The key.
+ * @param value The value.
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+int intMapPut( IntMap* map, uint64_t key, int value ) {
+	if( key == INTMAP_EMPTY_KEY ) {
+		return -1;
+	}
+	if( ( map->count + 1 ) * 4 > map->capacity * 3 &&
+			resizeMap( map, map->capacity > 0 ? map->capacity * 2 : INITIAL_INTMAP_CAPACITY ) != 0 ) {
+		return -1;
+	}
+	size_t slot = findSlot( map, key );
+	if( map->keys[slot] == INTMAP_EMPTY_KEY ) {
+		map->keys[slot] = key;
+		map->count++;
+	}
+	map->values[slot] = value;
+	return 0;
+}
+
+/**
+ * @brief Make room for a number of entries in one step.
+ *
+ * Avoids repeated rehashing when the number of entries is known in advance, such as when loading a snapshot.
+ *
+ * @param map The map.
+ * @param count Number of entries the map must hold.
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+int intMapReserve( IntMap* map, size_t count ) {
+	size_t capacity = map->capacity > 0 ? map->capacity : INITIAL_INTMAP_CAPACITY;
+	while( count * 4 > capacity * 3 ) {
+		capacity *= 2;
+	}
+	if( capacity == map->capacity ) {
+		return 0;
+	}
+	return resizeMap( map, capacity );
+}
+
+/**
+ * @brief Look up a key.
+ *
+ * @param map The map.
+ * @param key The key.
+ * @param value Pointer to store the value if the key is found.
+ * @return true if the key is found.
+ */
+bool intMapGet( const IntMap* map, uint64_t key, int* value ) {
+	if( map->capacity == 0 || key == INTMAP_EMPTY_KEY ) {
+		return false;
+	}
+	size_t slot = findSlot( map, key );
+	if( map->keys[slot] == INTMAP_EMPTY_KEY ) {
+		return false;
+	}
+	*value = map->values[slot];
+	return true;
+}
+
+/**
+ * @brief Remove a key.
+ *
+ * The entries that follow it in its run of slots are shifted back, so lookups never need tombstones.
+ *
+ * @param map The map.
+ * @param key The key.
+ * @return true if the key was found and removed.
+ */
+bool intMapRemove( IntMap* map, uint64_t key ) {
+	if( map->capacity == 0 || key == INTMAP_EMPTY_KEY ) {
+		return false;
+	}
+	size_t mask = map->capacity - 1;
+	size_t hole = findSlot( map, key );
+	if( map->keys[hole] == INTMAP_EMPTY_KEY ) {
+		return false;
+	}
+	for( size_t slot = ( hole + 1 ) & mask; map->keys[slot] != INTMAP_EMPTY_KEY; slot = ( slot + 1 ) & mask ) {
+		// an entry may fill the hole unless its home slot lies after the hole, where lookups would no longer reach it
+		size_t home = hashKey( map->keys[slot] ) & mask;
+		if( ( ( slot - home ) & mask ) >= ( ( slot - hole ) & mask ) ) {
+			map->keys[hole] = map->keys[slot];
+			map->values[hole] = map->values[slot];
+			hole = slot;
+		}
+	}
+	map->keys[hole] = INTMAP_EMPTY_KEY;
+	map->count--;
+	return true;
+}
+
+/**
+ * @brief Release the memory held by a map.
+ *
+ * @param map The map, left empty and ready for reuse.
+ */
+void intMapFree( IntMap* map ) {
+	free( map->keys );
+	free( map->values );
+	map->keys = NULL;
+	map->values = NULL;
+	map->capacity = 0;
+	map->count = 0;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file include/intmap.h
+ */
+
+#ifndef INTMAP_H
+#define INTMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Hash map from 64-bit keys to int values with open addressing.
+ *
+ * A zero-filled map is empty and ready for use. The key INTMAP_EMPTY_KEY is reserved.
+ */
+typedef struct {
+	uint64_t* keys;
+	int* values;
+	size_t capacity;
+	size_t count;
+} IntMap;
+
+#define INTMAP_EMPTY_KEY UINT64_MAX
+
+/**
+ * @brief Insert a key or replace its value.
+ *
+ * @param map The map.
+ * @param key The key.
+ * @param value The value.
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+int intMapPut( IntMap* map, uint64_t key, int value );
+
+/**
+ * @brief Make room for a number of entries in one step.
+ *
+ * Avoids repeated rehashing when the number of entries is known in advance, such as when loading a snapshot.
+ *
+ * @param map The map.
+ * @param count Number of entries the map must hold.
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+int intMapReserve( IntMap* map, size_t count );
+
+/**
+ * @brief Look up a key.
+ *
+ * @param map The map.
+ * @param key The key.
+ * @param value Pointer to store the value if the key is found.
+ * @return true if the key is found.
+ */
+bool intMapGet( const IntMap* map, uint64_t key, int* value );
+
+/**
+ * @brief Remove a key.
+ *
+ * The entries that follow it in its run of slots are shifted back, so lookups never need tombstones.
+ *
+ * @param map The map.
+ * @param key The key.
+ * @return true if the key was found and removed.
+ */
+bool intMapRemove( IntMap* map, uint64_t key );
+
+/**
+ * @brief Release the memory held by a map.
+ *
+ * @param map The map, left empty and ready for reuse.
+ */
+void intMapFree( IntMap* map );
+
+#endif // INTMAP_H
@@ -0,0 +1,270 @@
+/**
+ * @file src/journal.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/journal.h"
+#include "../include/utilities.h"
+#include "../include/stats.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+
+#include <windows.h>
+
+#define JOURNAL_THREAD_LOCAL __declspec( thread )
+
+static SRWLOCK journalLock = SRWLOCK_INIT;
+static CONDITION_VARIABLE batchWritten = CONDITION_VARIABLE_INIT;
+static CONDITION_VARIABLE batchFull = CONDITION_VARIABLE_INIT;
+
+#define lockJournal() AcquireSRWLockExclusive( &journalLock )
+#define unlockJournal() ReleaseSRWLockExclusive( &journalLock )
+#define waitJournal( condition ) SleepConditionVariableSRW( ( condition ), &journalLock, INFINITE, 0 )
+#define wakeJournal( condition ) WakeAllConditionVariable( condition )
+
+#else
+
+#include <pthread.h>
+
+#define JOURNAL_THREAD_LOCAL __thread
+
+static pthread_mutex_t journalLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t batchWritten = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t batchFull = PTHREAD_COND_INITIALIZER;
+
+#define lockJournal() pthread_mutex_lock( &journalLock )
+#define unlockJournal() pthread_mutex_unlock( &journalLock )
+#define waitJournal( condition ) pthread_cond_wait( ( condition ), &journalLock )
+#define wakeJournal( condition ) pthread_cond_broadcast( condition )
+
+#endif
+
+/**
+ * @brief Records waiting for a batch, or being written by one.
+ */
+typedef struct {
+	char* data;
+	size_t length;
+	size_t capacity;
+	int records;
+} JournalBuffer;
+
+static FILE* journalFile = NULL;
+static JournalBuffer queued = { NULL, 0, 0, 0 };
+static JournalBuffer writing = { NULL, 0, 0, 0 };
+// positions count every byte ever appended, so they keep growing when the journal is reopened
+static uint64_t appendedPosition = 0;
+static uint64_t durablePosition = 0;
+static bool committing = false;
+static bool journalFailed = false;
+static int commitBatch = DEFAULT_COMMIT_BATCH;
+static int commitWindow = DEFAULT_COMMIT_WINDOW_US;
+static JOURNAL_THREAD_LOCAL uint64_t threadPosition = 0;
+
+/**
+ * @brief Set how records are grouped into one write and sync.
+ *
+ * Records appended while a batch is being written always wait for the next batch. With a window, the thread that
+ * writes a batch also waits up to that long for more records, unless maxRecords are already waiting.
+ *
+ * @param maxRecords Number of waiting records that ends the window early; values below 1 restore
+ *                   DEFAULT_COMMIT_BATCH.
+ * @param windowMicros Longest wait for more records in microseconds; values below 0 restore DEFAULT_COMMIT_WINDOW_US.
+ */
+void setGroupCommit( int maxRecords, int windowMicros ) {
+	lockJournal();
+	commitBatch = maxRecords >= 1 ? maxRecords : DEFAULT_COMMIT_BATCH;
+	commitWindow = windowMicros >= 0 ? windowMicros : DEFAULT_COMMIT_WINDOW_US;
+	unlockJournal();
+}
+
+/**
+ * @brief Wait for a batch to fill up, at most until the commit window has passed.
+ *
+ * Called with the journal lock held by the thread that will write the batch.
+ */
+static void waitForBatch() {
+	if( commitWindow <= 0 || queued.records >= commitBatch ) {
+		return;
+	}
+	#if defined(_WIN32) || defined(_WIN64)
+	ULONGLONG deadline = GetTickCount64() + ( commitWindow + 999 ) / 1000;
+	ULONGLONG now;
+	while( queued.records < commitBatch && ( now = GetTickCount64() ) < deadline ) {
+		SleepConditionVariableSRW( &batchFull, &journalLock, (DWORD)( deadline - now ), 0 );
+	}
+	#else
+	struct timespec deadline;
+	clock_gettime( CLOCK_REALTIME, &deadline );
+	deadline.tv_nsec += (long)( commitWindow % 1000000 ) * 1000;
+	deadline.tv_sec += commitWindow / 1000000 + deadline.tv_nsec / 1000000000;
+	deadline.tv_nsec %= 1000000000;
+	while( queued.records < commitBatch ) {
+		if( pthread_cond_timedwait( &batchFull, &journalLock, &deadline ) != 0 ) {
+			break;
+		}
+	}
+	#endif
+}
+
+/**
+ * @brief Wait until the journal is on disk up to a position, writing batches while no other thread does.
+ *
+ * Called with the journal lock held.
+ *
+ * @param position The position.
+ * @return 0 on success, -1 if the journal could not be written.
+ */
+static int waitDurable( uint64_t position ) {
+	while( durablePosition < position && !journalFailed ) {
+		if( committing ) {
+			waitJournal( &batchWritten );
+			continue;
+		}
+		committing = true;
+		waitForBatch();
+		JournalBuffer batch = queued;
+		queued = writing;
+		queued.length = 0;
+		queued.records = 0;
+		uint64_t end = appendedPosition;
+		FILE* file = journalFile;
+		unlockJournal();
+		bool written = batch.length == 0 ||
+					   ( file != NULL && fwrite( batch.data, 1, batch.length, file ) == batch.length &&
+						 syncFile( file ) == 0 );
+		if( written ) {
+			countBytesWritten( batch.length );
+		}
+		lockJournal();
+		writing = batch;
+		if( written ) {
+			durablePosition = end;
+		} else {
+			journalFailed = true;
+		}
+		committing = false;
+		wakeJournal( &batchWritten );
+	}
+	return durablePosition >= position ? 0 : -1;
+}
+
+/**
+ * @brief Open a journal for appending, closing any journal that is open.
+ *
+ * @param filename The name of the journal file.
+ * @param truncate true to empty the file first.
+ * @return 0 on success, -1 if the file could not be opened.
+ */
+int openJournal( const char* filename, bool truncate ) {
+	lockJournal();
+	waitDurable( appendedPosition );
+	if( truncate ) {
+		// whatever is still queued after a failure is part of the state the caller rewrote
+		queued.length = 0;
+		queued.records = 0;
+		durablePosition = appendedPosition;
+	}
+	if( journalFile != NULL ) {
+		fclose( journalFile );
+	}
+	journalFile = fopen( filename, truncate ? "w" : "a" );
+	journalFailed = false;
+	bool opened = journalFile != NULL;
+	unlockJournal();
+	if( !opened ) {
+		return -1;
+	}
+	countFileOpen();
+	return 0;
+}
+
+/**
+ * @brief Queue a record for the next batch.
+ *
+ * The record is not on disk until commitJournal() returns for the calling thread.
+ *
+ * @param record The record, including its trailing newline.
+ * @param length Length of the record.
+ * @return 0 on success, -1 if no journal is open or memory could not be allocated.
+ */
+int appendJournalRecord( const char* record, size_t length ) {
+	lockJournal();
+	if( journalFile == NULL ) {
+		unlockJournal();
+		return -1;
+	}
+	if( queued.length + length > queued.capacity ) {
+		size_t capacity = queued.capacity > 0 ? queued.capacity * 2 : 4096;
+		while( capacity < queued.length + length ) {
+			capacity *= 2;
+		}
+		char* data = realloc( queued.data, capacity );
+		if( data == NULL ) {
+			unlockJournal();
+			return -1;
+		}
+		queued.data = data;
+		queued.capacity = capacity;
+	}
+	memcpy( queued.data + queued.length, record, length );
+	queued.length += length;
+	queued.records++;
+	appendedPosition += length;
+	threadPosition = appendedPosition;
+	if( queued.records == commitBatch ) {
+		wakeJournal( &batchFull );
+	}
+	unlockJournal();
+	return 0;
+}
+
+/**
+ * @brief Wait until every record appended by the calling thread is written and synced to disk.
+ *
+ * The first waiting thread writes and syncs everything queued so far in one batch; the others wait for it, so
+ * concurrent callers share a single sync.
+ *
+ * @return 0 on success, -1 if the journal could not be written.
+ */
+int commitJournal() {
+	StatTimer timer;
+	startTimer( &timer, STAT_JOURNAL );
+	lockJournal();
+	int result = waitDurable( threadPosition );
+	unlockJournal();
+	stopTimer( &timer );
+	return result;
+}
+
+/**
+ * @brief Wait until every queued record of any thread is on disk.
+ *
+ * @return 0 on success, -1 if the journal could not be written.
+ */
+int flushJournal() {
+	lockJournal();
+	int result = waitDurable( appendedPosition );
+	unlockJournal();
+	return result;
+}
+
+/**
+ * @brief Flush and close the journal.
+ */
+void closeJournal() {
+	lockJournal();
+	waitDurable( appendedPosition );
+	if( journalFile != NULL ) {
+		fclose( journalFile );
+		journalFile = NULL;
+	}
+	free( queued.data );
+	free( writing.data );
+	queued = (JournalBuffer){ NULL, 0, 0, 0 };
+	writing = (JournalBuffer){ NULL, 0, 0, 0 };
+	unlockJournal();
+}
@@ -0,0 +1,69 @@
+/**
+ * @file include/journal.h
+ */
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DEFAULT_COMMIT_BATCH 64
+#define DEFAULT_COMMIT_WINDOW_US 0
+
+/**
+ * @brief Set how records are grouped into one write and sync.
+ *
+ * Records appended while a batch is being written always wait for the next batch. With a window, the thread that
+ * writes a batch also waits up to that long for more records, unless maxRecords are already waiting.
+ *
+ * @param maxRecords Number of waiting records that ends the window early; values below 1 restore
+ *                   DEFAULT_COMMIT_BATCH.
+ * @param windowMicros Longest wait for more records in microseconds; values below 0 restore DEFAULT_COMMIT_WINDOW_US.
+ */
+void setGroupCommit( int maxRecords, int windowMicros );
+
+/**
+ * @brief Open a journal for appending, closing any journal that is open.
+ *
+ * @param filename The name of the journal file.
+ * @param truncate true to empty the file first.
+ * @return 0 on success, -1 if the file could not be opened.
+ */
+int openJournal( const char* filename, bool truncate );
+
+/**
+ * @brief Queue a record for the next batch.
+ *
+ * The record is not on disk until commitJournal() returns for the calling thread.
+ *
+ * @param record The record, including its trailing newline.
+ * @param length Length of the record.
+ * @return 0 on success, -1 if no journal is open or memory could not be allocated.
+ */
+int appendJournalRecord( const char* record, size_t length );
+
+/**
+ * @brief Wait until every record appended by the calling thread is written and synced to disk.
+ *
+ * The first waiting thread writes and syncs everything queued so far in one batch; the others wait for it, so
+ * concurrent callers share a single sync.
+ *
+ * @return 0 on success, -1 if the journal could not be written.
+ */
+int commitJournal();
+
+/**
+ * @brief Wait until every queued record of any thread is on disk.
+ *
+ * @return 0 on success, -1 if the journal could not be written.
+ */
+int flushJournal();
+
+/**
+ * @brief Flush and close the journal.
+ */
+void closeJournal();
+
+#endif // JOURNAL_H
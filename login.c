@@ -7,54 +7,117 @@
 #include <string.h>
 #include "../include/login.h"
 #include "../include/utilities.h"
+#include "../include/datafile.h"
+#include "../include/snapshot.h"
+#include "../include/stats.h"
 
-#define MAX_USERS 100
 #define MAX_LENGTH 500
 
 #define USERS_DATABASE "data/users.txt"
+#define USERS_SNAPSHOT "data/users.bin"
 
 /**
- * Registers a new user.
+ * Row of a user in the users snapshot; strings are heap offsets.
+ */
+typedef struct {
+	int32_t id;
+	uint32_t username;
+	uint32_t password;
+} UserRecord;
+
+/**
+ * Finds a user by username.
  *
- * @param users Array of users.
- * @param numUsers Pointer to the number of existing users.
+ * @param users Table of users.
+ * @param username The username.
+ * @return User ID of the user, or -1 if no user has that username.
+ */
+int findUserByName( const Table* users, const char* username ) {
+	for( int i = 0; i < users->count; i++ ) {
+		const User* user = tableAt( users, i );
+		if( strcmp( getString( user->username ), username ) == 0 ) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+/**
+ * Adds a new user without prompting.
  *
+ * @param users Table of users.
+ * @param username The username.
+ * @param password The password.
+ * @return User ID of the new user, or -1 if the username is taken or the user could not be stored.
  */
-void registerUser( User users[], int *numUsers ) {
-	if( *numUsers >= MAX_USERS ) {
-		printf( "Maximum number of users reached!\n" );
-		return;
+int addUser( Table* users, const char* username, const char* password ) {
+	StatTimer timer;
+	startTimer( &timer, STAT_REGISTER );
+	User* newUser = findUserByName( users, username ) < 0 ? tableAppend( users ) : NULL;
+	if( newUser != NULL ) {
+		newUser->id = users->count - 1;
+		newUser->username = storeString( username, strlen( username ) );
+		newUser->password = storeString( password, strlen( password ) );
+	}
+	stopTimer( &timer );
+	return newUser != NULL ? newUser->id : -1;
+}
+
+/**
+ * Checks a username and password without prompting.
+ *
+ * @param users Table of users.
+ * @param username The username.
+ * @param password The password.
+ * @return User ID of the user, or -1 if the username or password is wrong.
+ */
+int authenticateUser( const Table* users, const char* username, const char* password ) {
+	StatTimer timer;
+	startTimer( &timer, STAT_LOGIN );
+	int userId = findUserByName( users, username );
+	if( userId >= 0 && strcmp( getString( ( (const User*)tableAt( users, userId ) )->password ), password ) != 0 ) {
+		userId = -1;
 	}
-	User newUser;
+	stopTimer( &timer );
+	return userId;
+}
+
+/**
+ * Registers a new user.
+ *
+ * @param users Table of users.
+ *
+ */
+void registerUser( Table* users ) {
+	char username[MAX_LENGTH];
+	char password[MAX_LENGTH];
 	printf( "Enter username: " );
-	fgets( newUser.username, sizeof( newUser.username ), stdin );
-	newUser.username[strcspn( newUser.username, "\n" )] = '\0';
-	for( int i = 0; i < *numUsers; i++ ) {
-		if( strcmp( users[i].username, newUser.username ) == 0 ) {
-			printf( "Username already exists! Please choose a different username.\n" );
-			return;
-		}
+	fgets( username, sizeof( username ), stdin );
+	username[strcspn( username, "\n" )] = '\0';
+	if( findUserByName( users, username ) >= 0 ) {
+		printf( "Username already exists! Please choose a different username.\n" );
+		return;
 	}
 	printf( "Enter password: " );
 	disableEcho();
-	fgets( newUser.password, sizeof( newUser.password ), stdin );
+	fgets( password, sizeof( password ), stdin );
 	enableEcho();
-	newUser.password[strcspn( newUser.password, "\n" )] = '\0';
-	newUser.id = *numUsers;
-	users[*numUsers] = newUser;
-	*numUsers += 1;
+	password[strcspn( password, "\n" )] = '\0';
+	if( addUser( users, username, password ) < 0 ) {
+		printf( "System error, please contact with respective developers.\n" );
+		return;
+	}
 	printf( "\nRegistration successful!\n" );
-	saveUsersToFile( users, *numUsers );
+	saveUsersToFile( users );
 }
 
 /**
  * Logs in a user.
  *
- * @param users Array of users.
- * @param numUsers Number of existing users.
+ * @param users Table of users.
  * @return User ID of the logged-in user, or -1 if login fails.
  */
-int loginUser( User users[], int numUsers ) {
+int loginUser( const Table* users ) {
 	char username[MAX_LENGTH];
 	char password[MAX_LENGTH];
 	printf( "Enter username: " );
@@ -65,56 +128,132 @@ int loginUser( User users[], int numUsers ) {
 	fgets( password, sizeof( password ), stdin );
 	enableEcho();
 	password[strcspn( password, "\n" )] = '\0';
-	for( int i = 0; i < numUsers; i++ ) {
-		if( strcmp( users[i].username, username ) == 0 && strcmp( users[i].password, password ) == 0 ) {
-			printf( "\nLogin successful!\n" );
-			return i;
-		}
+	int userId = authenticateUser( users, username, password );
+	if( userId >= 0 ) {
+		printf( "\nLogin successful!\n" );
+		return userId;
 	}
 	printf( "Invalid username or password! Please try again.\n" );
-	return loginUser( users, numUsers );
+	return loginUser( users );
+}
+
+/**
+ * Saves users to the binary users snapshot.
+ *
+ * @param users Table of users.
+ */
+static void saveUsersSnapshot( const Table* users ) {
+	SnapshotWriter writer;
+	if( beginSnapshot( &writer, USERS_SNAPSHOT, sizeof( UserRecord ) ) != 0 ) {
+		return;
+	}
+	for( int i = 0; i < users->count; i++ ) {
+		const User* user = tableAt( users, i );
+		UserRecord record;
+		record.id = user->id;
+		record.username = addSnapshotString( &writer, user->username );
+		record.password = addSnapshotString( &writer, user->password );
+		writeSnapshotRow( &writer, &record );
+	}
+	endSnapshot( &writer, USERS_DATABASE, 0, 0 );
+}
+
+/**
+ * Loads users from the binary users snapshot.
+ *
+ * @param users Table of users to append to.
+ * @return Number of loaded users, or -1 if the snapshot is missing, stale or damaged.
+ */
+static int loadUsersFromSnapshot( Table* users ) {
+	Snapshot snapshot;
+	if( openSnapshot( &snapshot, USERS_SNAPSHOT, USERS_DATABASE, sizeof( UserRecord ) ) != 0 ) {
+		return -1;
+	}
+	int firstUser = users->count;
+	bool valid = true;
+	for( uint64_t i = 0; valid && i < snapshot.header->rowCount; i++ ) {
+		const UserRecord* record = getSnapshotRow( &snapshot, i );
+		User* user = tableAppend( users );
+		valid = user != NULL && loadSnapshotString( &snapshot, record->username, false, &user->username ) &&
+				loadSnapshotString( &snapshot, record->password, false, &user->password );
+		if( user != NULL ) {
+			user->id = record->id;
+		}
+	}
+	closeSnapshot( &snapshot );
+	if( !valid ) {
+		users->count = firstUser;
+		return -1;
+	}
+	return users->count;
 }
 
 /**
  * Saves users to a text file.
  *
- * @param users Array of users.
- * @param numUsers Number of existing users.
+ * @param users Table of users.
  */
-void saveUsersToFile( User users[], int numUsers ) {
+void saveUsersToFile( const Table* users ) {
+	StatTimer timer;
+	startTimer( &timer, STAT_SAVE );
 	FILE *file = fopen( USERS_DATABASE, "w" );
 	if( file == NULL ) {
+		stopTimer( &timer );
 		printf( "System error, please contact with respective developers.\n" );
 		return;
 	}
+	countFileOpen();
 	fprintf( file, "id|username|password\n" );
-	for( int i = 0; i < numUsers; i++ ) {
-		fprintf( file, "%d|%s|%s\n", users[i].id, users[i].username, users[i].password );
+	for( int i = 0; i < users->count; i++ ) {
+		const User* user = tableAt( users, i );
+		fprintf( file, "%d|%s|%s\n", user->id, getString( user->username ), getString( user->password ) );
 	}
+	countBytesWritten( ftell( file ) );
 	fclose( file );
+	saveUsersSnapshot( users );
+	stopTimer( &timer );
 }
 
 /**
- * Loads users from a text file.
+ * Loads users from a text file, or from the users snapshot while it is current.
  *
- * @param users Array of users.
+ * @param users Table of users to append to.
  * @return Number of loaded users.
  */
-int loadUsersFromFile( User users[] ) {
-	FILE *file = fopen( USERS_DATABASE, "r" );
-	if( file == NULL ) {
+int loadUsersFromFile( Table* users ) {
+	StatTimer timer;
+	startTimer( &timer, STAT_LOAD );
+	int loaded = loadUsersFromSnapshot( users );
+	if( loaded >= 0 ) {
+		stopTimer( &timer );
+		return loaded;
+	}
+	DataFile file;
+	if( openDataFile( &file, USERS_DATABASE ) != 0 ) {
+		stopTimer( &timer );
 		printf( "System error, please contact with respective developers..\n" );
 		return 0;
 	}
-	int numUsers = 0;
-	char line[MAX_LENGTH * 3];
-	fgets( line, sizeof( line ), file );
-	while( fgets( line, sizeof( line ), file ) ) {
-		sscanf( line, "%d|%[^|]|%s", &( users[numUsers].id ), users[numUsers].username, users[numUsers].password );
-		numUsers++;
+	StrView fields[3];
+	int numFields;
+	nextDataRow( &file, fields, 3 );
+	while( ( numFields = nextDataRow( &file, fields, 3 ) ) >= 0 ) {
+		int id;
+		if( numFields != 3 || !parseViewInt( fields[0], &id ) || fields[2].length == 0 ) {
+			continue;
+		}
+		User* user = tableAppend( users );
+		if( user == NULL ) {
+			break;
+		}
+		user->id = id;
+		user->username = storeString( fields[1].text, fields[1].length );
+		user->password = storeString( fields[2].text, fields[2].length );
 	}
-	fclose( file );
-	return numUsers;
+	closeDataFile( &file );
+	saveUsersSnapshot( users );
+	stopTimer( &timer );
+	return users->count;
 }
 
 /**
@@ -123,9 +262,9 @@ int loadUsersFromFile( User users[] ) {
  * @return User ID of the logged-in user, or -1 if login fails.
  */
 int login() {
-	User users[MAX_USERS];
-	int numUsers = 0;
-	numUsers = loadUsersFromFile( users );
+	Table users;
+	tableInit( &users, sizeof( User ) );
+	loadUsersFromFile( &users );
 	int option;
 	int loggedInUserId = -1;
 	do {
@@ -138,11 +277,11 @@ int login() {
 		getchar();
 		switch( option ) {
 			case 1:
-				registerUser( users, &numUsers );
-				loggedInUserId = numUsers - 1;
+				registerUser( &users );
+				loggedInUserId = users.count - 1;
 				break;
 			case 2:
-				loggedInUserId = loginUser( users, numUsers );
+				loggedInUserId = loginUser( &users );
 				break;
 			case 3:
 				printf( "Exiting...\n" );
@@ -153,8 +292,10 @@ int login() {
 		}
 	} while( option != 3 && loggedInUserId == -1 );
 	if( loggedInUserId != -1 ) {
-		printf( "Logged in user ID: %s\n", users[loggedInUserId].username );
+		const User* user = tableAt( &users, loggedInUserId );
+		printf( "Logged in user ID: %s\n", getString( user->username ) );
 	}
-	saveUsersToFile( users, numUsers );
+	saveUsersToFile( &users );
+	tableFree( &users );
 	return loggedInUserId;
 }
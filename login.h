@@ -5,50 +5,81 @@
 #ifndef LOGIN_H
 #define LOGIN_H
 
+#include "strpool.h"
+#include "table.h"
+
 #define MAX_LENGTH 500
 
 /**
  * Structure to hold user information.
+ *
+ * Text fields are handles into the string pool; read them with getString().
  */
 typedef struct {
 	int id;
-	char username[MAX_LENGTH];
-	char password[MAX_LENGTH];
+	StrId username;
+	StrId password;
 } User;
 
+/**
+ * Finds a user by username.
+ *
+ * @param users Table of users.
+ * @param username The username.
+ * @return User ID of the user, or -1 if no user has that username.
+ */
+int findUserByName( const Table* users, const char* username );
+
+/**
+ * Adds a new user without prompting.
+ *
+ * @param users Table of users.
+ * @param username The username.
+ * @param password The password.
+ * @return User ID of the new user, or -1 if the username is taken or the user could not be stored.
+ */
+int addUser( Table* users, const char* username, const char* password );
+
+/**
+ * Checks a username and password without prompting.
+ *
+ * @param users Table of users.
+ * @param username The username.
+ * @param password The password.
+ * @return User ID of the user, or -1 if the username or password is wrong.
+ */
+int authenticateUser( const Table* users, const char* username, const char* password );
+
 /**
  * Registers a new user.
  *
- * @param users Array of users.
- * @param numUsers Pointer to the number of existing users.
+ * @param users Table of users.
  *
  */
-void registerUser( User users[], int *numUsers );
+void registerUser( Table* users );
 
 /**
  * Logs in a user.
  *
- * @param users Array of users.
- * @param numUsers Number of existing users.
+ * @param users Table of users.
  * @return User ID of the logged-in user, or -1 if login fails.
  */
-int loginUser( User users[], int numUsers );
+int loginUser( const Table* users );
 
 /**
  * Saves users to a text file.
  *
- * @param users Array of users.
- * @param numUsers Number of existing users.
+ * @param users Table of users.
  */
-void saveUsersToFile( User users[], int numUsers );
+void saveUsersToFile( const Table* users );
 
 /**
- * Loads users from a text file.
+ * Loads users from a text file, or from the users snapshot while it is current.
  *
- * @param users Array of users.
+ * @param users Table of users to append to.
  * @return Number of loaded users.
  */
-int loadUsersFromFile( User users[] );
+int loadUsersFromFile( Table* users );
 
 
 /**
@@ -10,22 +10,92 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include "include/splash.h"
 #include "include/login.h"
 #include "include/utilities.h"
 #include "include/menu.h"
-
-#define MAX_TICKET 100
-#define MAX_SHOW 100
+#include "include/catalog.h"
+#include "include/tickets.h"
+#include "include/server.h"
+#include "include/commands.h"
+#include "include/stats.h"
+#include "include/pager.h"
+#include "include/holds.h"
+#include "include/ids.h"
+#include "include/journal.h"
 
 #define SHOWS_DATABASE "data/shows.txt"
 #define TICKETS_DATABASE "data/tickets.txt"
+#define TICKETS_JOURNAL "data/tickets.journal"
+#define ID_SEQUENCES "data/ids.seq"
 
-int main() {
+/**
+ * @brief Load the shows and tickets databases.
+ *
+ * @return true on success.
+ */
+static bool loadDatabases() {
+	if( loadShowsFromFile( SHOWS_DATABASE ) < 0 || loadTicketsFromFile( TICKETS_DATABASE, TICKETS_JOURNAL ) < 0 ||
+			loadIdSequences( ID_SEQUENCES ) != 0 ) {
+		printf( "System error, please contact with respective developers.\n" );
+		return false;
+	}
+	return true;
+}
+
+int main( int argc, char* argv[] ) {
+	initStats( getenv( "TICKET_STATS" ) );
+	if( getenv( "TICKET_PAGE_SIZE" ) != NULL ) {
+		setPageSize( atoi( getenv( "TICKET_PAGE_SIZE" ) ) );
+	}
+	if( getenv( "TICKET_HOLD_SECONDS" ) != NULL ) {
+		setHoldSeconds( atoi( getenv( "TICKET_HOLD_SECONDS" ) ) );
+	}
+	if( getenv( "TICKET_COMMIT_BATCH" ) != NULL || getenv( "TICKET_COMMIT_WINDOW_US" ) != NULL ) {
+		setGroupCommit( getenv( "TICKET_COMMIT_BATCH" ) != NULL ? atoi( getenv( "TICKET_COMMIT_BATCH" ) ) : 0,
+						getenv( "TICKET_COMMIT_WINDOW_US" ) != NULL ? atoi( getenv( "TICKET_COMMIT_WINDOW_US" ) ) : -1 );
+	}
+	if( argc >= 2 && strcmp( argv[1], "--server" ) == 0 ) {
+		if( !loadDatabases() ) {
+			return 1;
+		}
+		setIdReserveSize( ID_RESERVE_SIZE );
+		int result = runServer( argc >= 3 ? argv[2] : SERVER_SOCKET, argc >= 4 ? atoi( argv[3] ) : 0 );
+		saveTicketSnapshots();
+		saveIdSequences();
+	freeTickets();
+		return result == 0 ? 0 : 1;
+	}
+	if( argc >= 2 && strcmp( argv[1], "--batch" ) == 0 ) {
+		if( !loadDatabases() ) {
+			return 1;
+		}
+		int failures = runCommandStream( stdin, stdout, false );
+		saveTicketSnapshots();
+		saveIdSequences();
+	freeTickets();
+		return failures == 0 ? 0 : 1;
+	}
+	if( argc >= 2 ) {
+		if( !loadDatabases() ) {
+			return 1;
+		}
+		int result = runCommand( argc - 1, argv + 1, stdout );
+		saveIdSequences();
+	freeTickets();
+		return result == 0 ? 0 : 1;
+	}
 	splashScreen();
+	if( !loadDatabases() ) {
+		return 1;
+	}
 	int userid = login();
 	if( userid >= 0 ) {
 		menu( userid );
 	}
+	saveTicketSnapshots();
+	saveIdSequences();
+	freeTickets();
 	return 0;
 }
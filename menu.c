@@ -8,62 +8,73 @@
 #include "../include/menu.h"
 #include "../include/utilities.h"
 #include "../include/login.h"
+#include "../include/tickets.h"
+#include "../include/ids.h"
 
-#define MAX_TICKET 100
-#define MAX_SHOW 100
-#define MAX_USER 100
-
-#define SHOWS_DATABASE "data/shows.txt"
-#define TICKETS_DATABASE "data/tickets.txt"
+/**
+ * @brief Save the ticket snapshots, release the ticket store and exit.
+ */
+static void exitMenu() {
+	saveTicketSnapshots();
+	saveIdSequences();
+	freeTickets();
+	exit( 0 );
+}
 
 /**
  * @brief Handle navigation
  * @param userid User ID
  */
 void menu( int userid ) {
-	Ticket tickets[MAX_TICKET];
-	Show shows[MAX_SHOW];
+	if( compactTicketsWhenDue( false ) < 0 ) {
+		printf( "System error, please contact with respective developers.\n" );
+	}
 	printf( "\nNavigation:\n" );
 	printf( "\t1. View show(s)\n" );
 	printf( "\t2. Buy ticket(s)\n" );
 	printf( "\t3. Cancel a ticket\n" );
 	printf( "\t4. Show ticket(s)\n" );
 	printf( "\t5. Exit\n" );
+	printf( "\t6. Search show(s)\n" );
 	printf( "Select: " );
 	int selectedOption;
 	scanf( "%d", &selectedOption );
 	switch( selectedOption ) {
 		case 1:
 			printf( "\nUpcoming shows:\n" );
-			viewUpcomingShows( SHOWS_DATABASE, userid, true, false, false );
+			viewUpcomingShows( userid, true, false, false );
 			menu( userid );
 			break;
 		case 2: {
 				printf( "\nAvailable show:\n" );
 				int selectedShow;
-				selectedShow = viewUpcomingShows( SHOWS_DATABASE, userid, true, true, false );
-				buyTicket( tickets, shows, TICKETS_DATABASE, SHOWS_DATABASE, userid, selectedShow );
+				selectedShow = viewUpcomingShows( userid, true, true, false );
+				buyTicket( userid, selectedShow );
 				menu( userid );
 				break;
 			}
 		case 3: {
 				printf( "\nAvailable tickets:\n" );
 				int ticketId;
-				ticketId = showTicketsByUserId( tickets, TICKETS_DATABASE, userid, true, true, false, true );
+				ticketId = showTicketsByUserId( userid, true, true, false, true );
 				updateTicketStatus( ticketId, 0 );
 				menu( userid );
 				break;
 			}
 		case 4:
 			printf( "\nAll your purchased tickets:\n" );
-			showTicketsByUserId( tickets, TICKETS_DATABASE, userid, true, false, false, false );
+			showTicketsByUserId( userid, true, false, false, false );
 			menu( userid );
 			break;
 		case 5:
-			exit( 0 );
+			exitMenu();
+			break;
+		case 6:
+			searchUpcomingShows();
+			menu( userid );
 			break;
 		default:
-			exit( 0 );
+			exitMenu();
 	}
 	return;
 }
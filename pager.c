@@ -0,0 +1,179 @@
+/**
+ * @file src/pager.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "../include/pager.h"
+
+#define OUTPUT_MIN_CAPACITY 4096
+
+static int pageSize = DEFAULT_PAGE_SIZE;
+static char* output = NULL;
+static size_t outputLength = 0;
+static size_t outputCapacity = 0;
+
+/**
+ * @brief Set the number of items per page.
+ *
+ * @param size Number of items per page; values below 1 restore DEFAULT_PAGE_SIZE.
+ */
+void setPageSize( int size ) {
+	pageSize = size >= 1 ? size : DEFAULT_PAGE_SIZE;
+}
+
+/**
+ * @brief Get the number of items per page.
+ *
+ * @return Number of items per page.
+ */
+int getPageSize() {
+	return pageSize;
+}
+
+/**
+ * @brief Append formatted text to the page being rendered.
+ *
+ * @param format The printf() format.
+ */
+void appendOutput( const char* format, ... ) {
+	va_list args;
+	va_start( args, format );
+	int needed = vsnprintf( outputCapacity > 0 ? output + outputLength : NULL, outputCapacity - outputLength, format,
+			args );
+	va_end( args );
+	if( needed < 0 ) {
+		return;
+	}
+	if( outputLength + needed + 1 > outputCapacity ) {
+		size_t capacity = outputCapacity > 0 ? outputCapacity * 2 : OUTPUT_MIN_CAPACITY;
+		while( capacity < outputLength + needed + 1 ) {
+			capacity *= 2;
+		}
+		char* grown = realloc( output, capacity );
+		if( grown == NULL ) {
+			return;
+		}
+		output = grown;
+		outputCapacity = capacity;
+		va_start( args, format );
+		vsnprintf( output + outputLength, outputCapacity - outputLength, format, args );
+		va_end( args );
+	}
+	outputLength += needed;
+}
+
+/**
+ * @brief Get the number of pages of a listing.
+ *
+ * @param pager The pager.
+ * @return Number of pages, at least 1.
+ */
+static int getPageCount( const Pager* pager ) {
+	int numPages = ( pager->numItems + pageSize - 1 ) / pageSize;
+	return numPages > 0 ? numPages : 1;
+}
+
+/**
+ * @brief Set up a listing on its first page.
+ *
+ * @param pager The pager.
+ * @param numItems Number of items in the listing.
+ * @param renderItem Function that formats one item.
+ * @param context Passed to renderItem.
+ * @param noun What an item is called in prompts, such as "show".
+ * @param hasSelect Whether the user picks an item.
+ */
+void initPager( Pager* pager, int numItems, RenderItem renderItem, void* context, const char* noun, bool hasSelect ) {
+	pager->numItems = numItems;
+	pager->page = 0;
+	pager->renderItem = renderItem;
+	pager->context = context;
+	pager->noun = noun;
+	pager->hasSelect = hasSelect;
+}
+
+/**
+ * @brief Render the current page and write it to the standard output.
+ *
+ * @param pager The pager.
+ */
+void showPage( const Pager* pager ) {
+	outputLength = 0;
+	int end = ( pager->page + 1 ) * pageSize;
+	if( end > pager->numItems ) {
+		end = pager->numItems;
+	}
+	for( int item = pager->page * pageSize; item < end; item++ ) {
+		pager->renderItem( item + 1, item, pager->context );
+	}
+	int numPages = getPageCount( pager );
+	if( numPages > 1 ) {
+		appendOutput( "Page %d of %d\n", pager->page + 1, numPages );
+	}
+	fwrite( output, 1, outputLength, stdout );
+}
+
+/**
+ * @brief Let the user page through the listing and, if enabled, pick an item.
+ *
+ * Expects the current page to be on screen already. Reads "n" (next page), "p" (previous page), "g <page>" (jump)
+ * and, when selecting, an item number; "-1" or "q" leaves. A listing that fits on one page and has nothing to select
+ * returns at once.
+ *
+ * @param pager The pager.
+ * @return Position of the selected item, or -1 if nothing was selected.
+ */
+int runPager( Pager* pager ) {
+	int numPages = getPageCount( pager );
+	if( !pager->hasSelect && numPages <= 1 ) {
+		return -1;
+	}
+	char command[32];
+	while( true ) {
+		if( !pager->hasSelect ) {
+			printf( "n/p for the next/previous page, g <page> to jump (q to leave): " );
+		} else if( numPages > 1 ) {
+			printf( "Select a %s, n/p for the next/previous page, g <page> to jump (-1 to cancel): ", pager->noun );
+		} else {
+			printf( "Select a %s (-1 to cancel): ", pager->noun );
+		}
+		if( scanf( "%31s", command ) != 1 ) {
+			return -1;
+		}
+		if( strcmp( command, "n" ) == 0 || strcmp( command, "p" ) == 0 ) {
+			int target = pager->page + ( command[0] == 'n' ? 1 : -1 );
+			if( target < 0 || target >= numPages ) {
+				printf( "This is the %s page.\n", target < 0 ? "first" : "last" );
+				continue;
+			}
+			pager->page = target;
+			showPage( pager );
+			continue;
+		}
+		if( strcmp( command, "g" ) == 0 ) {
+			int target;
+			if( scanf( "%d", &target ) != 1 || target < 1 || target > numPages ) {
+				printf( "Invalid page. Pages go from 1 to %d.\n", numPages );
+				continue;
+			}
+			pager->page = target - 1;
+			showPage( pager );
+			continue;
+		}
+		if( strcmp( command, "q" ) == 0 || strcmp( command, "-1" ) == 0 ) {
+			if( pager->hasSelect ) {
+				printf( "Canceled.\n" );
+			}
+			return -1;
+		}
+		char* end;
+		long serial = strtol( command, &end, 10 );
+		if( pager->hasSelect && *end == '\0' && serial >= 1 && serial <= pager->numItems ) {
+			return (int)serial - 1;
+		}
+		printf( pager->hasSelect ? "Invalid selection. Please try again.\n" : "Invalid command. Please try again.\n" );
+	}
+}
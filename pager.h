@@ -0,0 +1,88 @@
+/**
+ * @file include/pager.h
+ */
+
+#ifndef PAGER_H
+#define PAGER_H
+
+#include <stdbool.h>
+
+#define DEFAULT_PAGE_SIZE 10
+
+/**
+ * @brief Format one item of a listing with appendOutput().
+ *
+ * @param serial Number of the item as shown to the user, starting at 1.
+ * @param item Position of the item in the listing, starting at 0.
+ * @param context The context given to initPager().
+ */
+typedef void ( *RenderItem )( int serial, int item, void* context );
+
+/**
+ * @brief Paginated listing of numbered items.
+ *
+ * Only the items of the current page are formatted. A page is rendered into one reusable buffer and written with a
+ * single call, instead of one printf() per line.
+ */
+typedef struct {
+	int numItems;
+	int page;
+	RenderItem renderItem;
+	void* context;
+	const char* noun;
+	bool hasSelect;
+} Pager;
+
+/**
+ * @brief Set the number of items per page.
+ *
+ * @param size Number of items per page; values below 1 restore DEFAULT_PAGE_SIZE.
+ */
+void setPageSize( int size );
+
+/**
+ * @brief Get the number of items per page.
+ *
+ * @return Number of items per page.
+ */
+int getPageSize();
+
+/**
+ * @brief Append formatted text to the page being rendered.
+ *
+ * @param format The printf() format.
+ */
+void appendOutput( const char* format, ... );
+
+/**
+ * @brief Set up a listing on its first page.
+ *
+ * @param pager The pager.
+ * @param numItems Number of items in the listing.
+ * @param renderItem Function that formats one item.
+ * @param context Passed to renderItem.
+ * @param noun What an item is called in prompts, such as "show".
+ * @param hasSelect Whether the user picks an item.
+ */
+void initPager( Pager* pager, int numItems, RenderItem renderItem, void* context, const char* noun, bool hasSelect );
+
+/**
+ * @brief Render the current page and write it to the standard output.
+ *
+ * @param pager The pager.
+ */
+void showPage( const Pager* pager );
+
+/**
+ * @brief Let the user page through the listing and, if enabled, pick an item.
+ *
+ * Expects the current page to be on screen already. Reads "n" (next page), "p" (previous page), "g <page>" (jump)
+ * and, when selecting, an item number; "-1" or "q" leaves. A listing that fits on one page and has nothing to select
+ * returns at once.
+ *
+ * @param pager The pager.
+ * @return Position of the selected item, or -1 if nothing was selected.
+ */
+int runPager( Pager* pager );
+
+#endif // PAGER_H
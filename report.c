@@ -0,0 +1,350 @@
+/**
+ * @file src/report.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "../include/report.h"
+#include "../include/catalog.h"
+#include "../include/tickets.h"
+#include "../include/storelock.h"
+#include "../include/intmap.h"
+#include "../include/stats.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+	#include <windows.h>
+#else
+	#include <pthread.h>
+	#include <unistd.h>
+#endif
+
+/**
+ * @brief A range of ticket blocks counted by one thread, and its counters.
+ *
+ * Counters are indexed by ( slot * numMethods + method ) * 2 + active, where the slot of a show is its position
+ * in the catalog and tickets of unknown shows share the slot after the last show.
+ */
+typedef struct {
+	const int32_t* slots;
+	int maxShowId;
+	int numMethods;
+	int firstBlock;
+	int endBlock;
+	uint32_t* counts;
+} ReportPartition;
+
+/**
+ * @brief Count the tickets of a partition.
+ *
+ * The counter of each ticket is computed for a whole block first, in a loop without stores through pointers that
+ * the compiler cannot tell apart, so that loop vectorizes; the counters are then incremented in a second loop.
+ *
+ * @param partition The partition.
+ */
+static void countPartition( ReportPartition* partition ) {
+	int32_t keys[TABLE_SEGMENT_ITEMS];
+	const int32_t* slots = partition->slots;
+	uint32_t unknownId = (uint32_t)partition->maxShowId + 1;
+	int32_t stride = partition->numMethods * 2;
+	uint32_t* counts = partition->counts;
+	for( int block = partition->firstBlock; block < partition->endBlock; block++ ) {
+		TicketColumns columns;
+		int count = getTicketColumns( block, &columns );
+		const int32_t* showIds = columns.showIds;
+		const uint8_t* statuses = columns.statuses;
+		const uint8_t* methods = columns.methods;
+		for( int i = 0; i < count; i++ ) {
+			uint32_t showId = (uint32_t)showIds[i];
+			int32_t slot = slots[showId < unknownId ? showId : unknownId];
+			keys[i] = slot * stride + methods[i] * 2 + ( statuses[i] == 1 );
+		}
+		for( int i = 0; i < count; i++ ) {
+			counts[keys[i]]++;
+		}
+	}
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+
+/**
+ * @brief Thread entry point that counts one partition.
+ *
+ * @param argument The partition.
+ * @return 0.
+ */
+static DWORD WINAPI runPartition( LPVOID argument ) {
+	countPartition( argument );
+	return 0;
+}
+
+#else
+
+/**
+ * @brief Thread entry point that counts one partition.
+ *
+ * @param argument The partition.
+ * @return NULL.
+ */
+static void* runPartition( void* argument ) {
+	countPartition( argument );
+	return NULL;
+}
+
+#endif
+
+/**
+ * @brief Count the partitions on separate threads, falling back to the calling thread for any thread that cannot
+ * be started.
+ *
+ * @param partitions The partitions.
+ * @param count Number of partitions.
+ */
+static void countPartitions( ReportPartition partitions[], int count ) {
+	#if defined(_WIN32) || defined(_WIN64)
+	HANDLE threads[MAX_REPORT_THREADS];
+	for( int i = 1; i < count; i++ ) {
+		threads[i] = CreateThread( NULL, 0, runPartition, &partitions[i], 0, NULL );
+	}
+	countPartition( &partitions[0] );
+	for( int i = 1; i < count; i++ ) {
+		if( threads[i] != NULL ) {
+			WaitForSingleObject( threads[i], INFINITE );
+			CloseHandle( threads[i] );
+		} else {
+			countPartition( &partitions[i] );
+		}
+	}
+	#else
+	pthread_t threads[MAX_REPORT_THREADS];
+	bool started[MAX_REPORT_THREADS];
+	for( int i = 1; i < count; i++ ) {
+		started[i] = pthread_create( &threads[i], NULL, runPartition, &partitions[i] ) == 0;
+	}
+	countPartition( &partitions[0] );
+	for( int i = 1; i < count; i++ ) {
+		if( started[i] ) {
+			pthread_join( threads[i], NULL );
+		} else {
+			countPartition( &partitions[i] );
+		}
+	}
+	#endif
+}
+
+/**
+ * @brief Get the number of processors.
+ *
+ * @return The number of online processors, at least 1.
+ */
+static int getProcessorCount() {
+	#if defined(_WIN32) || defined(_WIN64)
+	SYSTEM_INFO info;
+	GetSystemInfo( &info );
+	int count = (int)info.dwNumberOfProcessors;
+	#else
+	int count = (int)sysconf( _SC_NPROCESSORS_ONLN );
+	#endif
+	return count > 0 ? count : 1;
+}
+
+/**
+ * @brief Add the sales of a show to the row of its venue or genre, adding the row on first use.
+ *
+ * @param rows The venue or genre rows.
+ * @param index Map from venue or genre to its row.
+ * @param name The venue or genre.
+ * @param show The sales of the show.
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+static int addToGroup( Table* rows, IntMap* index, StrId name, const SalesRow* show ) {
+	int position;
+	SalesRow* row;
+	if( intMapGet( index, name, &position ) ) {
+		row = tableAt( rows, position );
+	} else {
+		row = tableAppend( rows );
+		if( row == NULL || intMapPut( index, name, rows->count - 1 ) != 0 ) {
+			return -1;
+		}
+		row->showId = -1;
+		row->name = getString( name );
+	}
+	row->shows++;
+	row->seats += show->seats;
+	row->sold += show->sold;
+	row->canceled += show->canceled;
+	row->revenue += show->revenue;
+	return 0;
+}
+
+/**
+ * @brief Turn the added-up counters into the rows of the report.
+ *
+ * @param report The report, with empty tables.
+ * @param totals Added-up counters of all partitions.
+ * @param numShows Number of shows in the catalog.
+ * @param numMethods Number of payment method codes.
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+static int rollUp( SalesReport* report, const int64_t* totals, int numShows, int numMethods ) {
+	IntMap venueIndex = { 0 };
+	IntMap genreIndex = { 0 };
+	int64_t* methodSold = calloc( numMethods, sizeof( int64_t ) );
+	int64_t* methodCanceled = calloc( numMethods, sizeof( int64_t ) );
+	int64_t* methodRevenue = calloc( numMethods, sizeof( int64_t ) );
+	int result = methodSold != NULL && methodCanceled != NULL && methodRevenue != NULL ? 0 : -1;
+	for( int slot = 0; result == 0 && slot <= numShows; slot++ ) {
+		const Show* show = getShowByIndex( slot );
+		int price = show != NULL ? show->price : 0;
+		const int64_t* counts = totals + (size_t)slot * numMethods * 2;
+		SalesRow row = { show != NULL ? show->id : -1, show != NULL ? getString( show->singer ) : "", 1,
+						 show != NULL ? show->seats : 0, 0, 0, 0 };
+		for( int method = 0; method < numMethods; method++ ) {
+			row.canceled += counts[method * 2];
+			row.sold += counts[method * 2 + 1];
+			methodCanceled[method] += counts[method * 2];
+			methodSold[method] += counts[method * 2 + 1];
+			methodRevenue[method] += counts[method * 2 + 1] * price;
+		}
+		row.revenue = row.sold * price;
+		report->total.seats += row.seats;
+		report->total.sold += row.sold;
+		report->total.canceled += row.canceled;
+		report->total.revenue += row.revenue;
+		if( show == NULL ) {
+			continue;
+		}
+		report->total.shows++;
+		SalesRow* stored = tableAppend( &report->shows );
+		if( stored == NULL ) {
+			result = -1;
+			break;
+		}
+		*stored = row;
+		if( addToGroup( &report->venues, &venueIndex, show->venue, &row ) != 0 ||
+				addToGroup( &report->genres, &genreIndex, show->type, &row ) != 0 ) {
+			result = -1;
+		}
+	}
+	for( int method = 0; result == 0 && method < numMethods; method++ ) {
+		const char* name = getPaymentMethodName( method );
+		if( name == NULL ) {
+			continue;
+		}
+		SalesRow* row = tableAppend( &report->methods );
+		if( row == NULL ) {
+			result = -1;
+			break;
+		}
+		*row = (SalesRow){ -1, name, 0, 0, methodSold[method], methodCanceled[method], methodRevenue[method] };
+	}
+	intMapFree( &venueIndex );
+	intMapFree( &genreIndex );
+	free( methodSold );
+	free( methodCanceled );
+	free( methodRevenue );
+	return result;
+}
+
+/**
+ * @brief Compute the sales report in one pass over the ticket columns.
+ *
+ * The ticket blocks are split into contiguous ranges, one per thread; each thread counts the tickets of its range
+ * per show, payment method and status into its own counters, which are then added up and rolled up to venues,
+ * genres and methods. Takes the store lock for reading, so it may run alongside bookings.
+ *
+ * @param report The report to fill; release it with freeSalesReport().
+ * @param numThreads Number of threads, or 0 for one per processor; at most MAX_REPORT_THREADS are used.
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+int buildSalesReport( SalesReport* report, int numThreads ) {
+	tableInit( &report->shows, sizeof( SalesRow ) );
+	tableInit( &report->venues, sizeof( SalesRow ) );
+	tableInit( &report->genres, sizeof( SalesRow ) );
+	tableInit( &report->methods, sizeof( SalesRow ) );
+	report->total = (SalesRow){ -1, "total", 0, 0, 0, 0, 0 };
+	StatTimer timer;
+	startTimer( &timer, STAT_REPORT );
+	lockStoreForReading();
+	int numShows = getShowCount();
+	int maxShowId = -1;
+	for( int i = 0; i < numShows; i++ ) {
+		const Show* show = getShowByIndex( i );
+		if( show->id > maxShowId ) {
+			maxShowId = show->id;
+		}
+	}
+	int numMethods = getPaymentMethodCount() > 0 ? getPaymentMethodCount() : 1;
+	int numBlocks = ( getTicketCount() + TABLE_SEGMENT_ITEMS - 1 ) / TABLE_SEGMENT_ITEMS;
+	if( numThreads <= 0 ) {
+		numThreads = getProcessorCount();
+	}
+	if( numThreads > MAX_REPORT_THREADS ) {
+		numThreads = MAX_REPORT_THREADS;
+	}
+	if( numThreads > numBlocks ) {
+		numThreads = numBlocks > 0 ? numBlocks : 1;
+	}
+	size_t numCounts = (size_t)( numShows + 1 ) * numMethods * 2;
+	int32_t* slots = malloc( sizeof( int32_t ) * ( (size_t)maxShowId + 2 ) );
+	int64_t* totals = calloc( numCounts, sizeof( int64_t ) );
+	ReportPartition partitions[MAX_REPORT_THREADS];
+	int result = slots != NULL && totals != NULL ? 0 : -1;
+	for( int i = 0; i < numThreads; i++ ) {
+		partitions[i].counts = result == 0 ? calloc( numCounts, sizeof( uint32_t ) ) : NULL;
+		if( partitions[i].counts == NULL ) {
+			result = -1;
+		}
+	}
+	if( result == 0 ) {
+		for( int i = 0; i <= maxShowId + 1; i++ ) {
+			slots[i] = numShows;
+		}
+		for( int i = 0; i < numShows; i++ ) {
+			const Show* show = getShowByIndex( i );
+			if( show->id >= 0 ) {
+				slots[show->id] = i;
+			}
+		}
+		for( int i = 0; i < numThreads; i++ ) {
+			partitions[i].slots = slots;
+			partitions[i].maxShowId = maxShowId;
+			partitions[i].numMethods = numMethods;
+			partitions[i].firstBlock = (int)( (int64_t)numBlocks * i / numThreads );
+			partitions[i].endBlock = (int)( (int64_t)numBlocks * ( i + 1 ) / numThreads );
+		}
+		countPartitions( partitions, numThreads );
+		for( int i = 0; i < numThreads; i++ ) {
+			const uint32_t* counts = partitions[i].counts;
+			for( size_t key = 0; key < numCounts; key++ ) {
+				totals[key] += counts[key];
+			}
+		}
+		result = rollUp( report, totals, numShows, numMethods );
+	}
+	unlockStoreForReading();
+	for( int i = 0; i < numThreads; i++ ) {
+		free( partitions[i].counts );
+	}
+	free( slots );
+	free( totals );
+	stopTimer( &timer );
+	if( result != 0 ) {
+		freeSalesReport( report );
+	}
+	return result;
+}
+
+/**
+ * @brief Release the rows of a sales report.
+ *
+ * @param report The report.
+ */
+void freeSalesReport( SalesReport* report ) {
+	tableFree( &report->shows );
+	tableFree( &report->venues );
+	tableFree( &report->genres );
+	tableFree( &report->methods );
+}
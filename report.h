@@ -0,0 +1,61 @@
+/**
+ * @file include/report.h
+ */
+
+#ifndef REPORT_H
+#define REPORT_H
+
+#include <stdint.h>
+#include "table.h"
+
+#define MAX_REPORT_THREADS 64
+
+/**
+ * @brief Sales of one show, venue, genre or payment method.
+ *
+ * Sold tickets are active ones; revenue is the price of the show for each sold ticket. Seats are the capacity of
+ * the shows counted, and stay 0 for payment methods.
+ */
+typedef struct {
+	int showId;
+	const char* name;
+	int shows;
+	int64_t seats;
+	int64_t sold;
+	int64_t canceled;
+	int64_t revenue;
+} SalesRow;
+
+/**
+ * @brief Sales per show in catalog order, per venue and genre in order of first appearance, per payment method
+ * and in total.
+ */
+typedef struct {
+	Table shows;
+	Table venues;
+	Table genres;
+	Table methods;
+	SalesRow total;
+} SalesReport;
+
+/**
+ * @brief Compute the sales report in one pass over the ticket columns.
+ *
+ * The ticket blocks are split into contiguous ranges, one per thread; each thread counts the tickets of its range
+ * per show, payment method and status into its own counters, which are then added up and rolled up to venues,
+ * genres and methods. Takes the store lock for reading, so it may run alongside bookings.
+ *
+ * @param report The report to fill; release it with freeSalesReport().
+ * @param numThreads Number of threads, or 0 for one per processor; at most MAX_REPORT_THREADS are used.
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+int buildSalesReport( SalesReport* report, int numThreads );
+
+/**
+ * @brief Release the rows of a sales report.
+ *
+ * @param report The report.
+ */
+void freeSalesReport( SalesReport* report );
+
+#endif // REPORT_H
@@ -0,0 +1,348 @@
+/**
+ * @file src/search.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "../include/search.h"
+#include "../include/catalog.h"
+#include "../include/table.h"
+#include "../include/intmap.h"
+#include "../include/bitmap.h"
+
+#define SEARCH_FIELDS 3
+
+/**
+ * @brief A distinct value of one field and the shows that have it.
+ */
+typedef struct {
+	StrId text;
+	int field;
+	int firstShow;
+	int numShows;
+} SearchTerm;
+
+static Table searchTerms = { .itemSize = sizeof( SearchTerm ) };
+static int* termShows = NULL;
+static IntMap gramIndex;
+static int* gramStarts = NULL;
+static int* gramTerms = NULL;
+static int numGrams = 0;
+
+/**
+ * @brief Convert an ASCII letter to lower case, leaving every other byte alone.
+ *
+ * @param c The character.
+ * @return The lower case character.
+ */
+static char foldCase( char c ) {
+	return c >= 'A' && c <= 'Z' ? (char)( c - 'A' + 'a' ) : c;
+}
+
+/**
+ * @brief Check whether a character belongs to a word.
+ *
+ * @param c The character; bytes of multi-byte characters count as letters.
+ * @return true for letters, digits and non-ASCII bytes.
+ */
+static bool isWordCharacter( char c ) {
+	unsigned char u = (unsigned char)c;
+	return ( u >= 'a' && u <= 'z' ) || ( u >= 'A' && u <= 'Z' ) || ( u >= '0' && u <= '9' ) || u >= 0x80;
+}
+
+/**
+ * @brief Get the key of a gram.
+ *
+ * @param text The characters of the gram, in any case.
+ * @param length Number of characters, at most SEARCH_GRAM_LENGTH.
+ * @return The key, which also encodes the length.
+ */
+static uint64_t gramKey( const char* text, size_t length ) {
+	uint64_t key = length;
+	for( size_t i = 0; i < length; i++ ) {
+		key = ( key << 8 ) | (unsigned char)foldCase( text[i] );
+	}
+	return key;
+}
+
+/**
+ * @brief Get the value of a field of a show.
+ *
+ * @param show The show.
+ * @param field The field, from 0 to SEARCH_FIELDS - 1 for singer, venue and type.
+ * @return The value.
+ */
+static StrId getFieldText( const Show* show, int field ) {
+	return field == 0 ? show->singer : field == 1 ? show->venue : show->type;
+}
+
+/**
+ * @brief Collect the distinct field values as terms, with the shows of each term in date order.
+ *
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+static int buildTerms() {
+	int numShows = getShowCount();
+	int* showTerms = malloc( sizeof( int ) * ( (size_t)numShows * SEARCH_FIELDS + 1 ) );
+	IntMap termIndex = { 0 };
+	int result = showTerms != NULL ? 0 : -1;
+	for( int position = 0; result == 0 && position < numShows; position++ ) {
+		const Show* show = getShowByDateOrder( position );
+		for( int field = 0; result == 0 && field < SEARCH_FIELDS; field++ ) {
+			StrId text = getFieldText( show, field );
+			uint64_t key = (uint64_t)field << 32 | text;
+			int term;
+			if( !intMapGet( &termIndex, key, &term ) ) {
+				term = searchTerms.count;
+				SearchTerm* added = tableAppend( &searchTerms );
+				if( added == NULL || intMapPut( &termIndex, key, term ) != 0 ) {
+					result = -1;
+					break;
+				}
+				added->text = text;
+				added->field = 1 << field;
+			}
+			( (SearchTerm*)tableAt( &searchTerms, term ) )->numShows++;
+			showTerms[position * SEARCH_FIELDS + field] = term;
+		}
+	}
+	intMapFree( &termIndex );
+	int offset = 0;
+	for( int term = 0; result == 0 && term < searchTerms.count; term++ ) {
+		SearchTerm* entry = tableAt( &searchTerms, term );
+		entry->firstShow = offset;
+		offset += entry->numShows;
+		entry->numShows = 0;
+	}
+	termShows = result == 0 ? malloc( sizeof( int ) * ( (size_t)offset + 1 ) ) : NULL;
+	if( termShows == NULL ) {
+		result = -1;
+	}
+	// positions are visited in ascending order, so every term lists its shows in date order
+	for( int i = 0; result == 0 && i < numShows * SEARCH_FIELDS; i++ ) {
+		SearchTerm* entry = tableAt( &searchTerms, showTerms[i] );
+		termShows[entry->firstShow + entry->numShows++] = i / SEARCH_FIELDS;
+	}
+	free( showTerms );
+	return result;
+}
+
+/**
+ * @brief Count or list the terms of every gram.
+ *
+ * @param counts Number of terms per gram, extended for new grams while counting, or the next free slot of each gram
+ *               in gramTerms while listing.
+ * @param lastTerms Last term added to each gram, so that a gram occurring twice in a term lists it once.
+ * @param listing false to count, true to fill gramTerms.
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+static int collectGrams( Table* counts, Table* lastTerms, bool listing ) {
+	for( int term = 0; term < searchTerms.count; term++ ) {
+		const char* text = getString( ( (const SearchTerm*)tableAt( &searchTerms, term ) )->text );
+		size_t length = strlen( text );
+		for( size_t start = 0; start < length; start++ ) {
+			for( size_t n = 1; n <= SEARCH_GRAM_LENGTH && start + n <= length; n++ ) {
+				uint64_t key = gramKey( text + start, n );
+				int gram;
+				if( !intMapGet( &gramIndex, key, &gram ) ) {
+					if( listing ) {
+						return -1;
+					}
+					int* count = tableAppend( counts );
+					int* last = tableAppend( lastTerms );
+					if( count == NULL || last == NULL || intMapPut( &gramIndex, key, numGrams ) != 0 ) {
+						return -1;
+					}
+					*last = -1;
+					gram = numGrams++;
+				}
+				int* last = tableAt( lastTerms, gram );
+				if( *last == term ) {
+					continue;
+				}
+				*last = term;
+				int* count = tableAt( counts, gram );
+				if( listing ) {
+					gramTerms[( *count )++] = term;
+				} else {
+					( *count )++;
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief Build the search index over the singer, venue and type of every show in the catalog.
+ *
+ * Every distinct value of a field is a term with the date order positions of its shows. Every substring of up to
+ * SEARCH_GRAM_LENGTH characters of a term, in lower case, is a gram with the terms that contain it. Called by the
+ * catalog whenever it is loaded, after its date index is built.
+ *
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+int buildSearchIndex() {
+	freeSearchIndex();
+	Table counts;
+	Table lastTerms;
+	tableInit( &counts, sizeof( int ) );
+	tableInit( &lastTerms, sizeof( int ) );
+	int result = buildTerms() == 0 && collectGrams( &counts, &lastTerms, false ) == 0 ? 0 : -1;
+	gramStarts = result == 0 ? malloc( sizeof( int ) * ( (size_t)numGrams + 1 ) ) : NULL;
+	if( gramStarts != NULL ) {
+		int offset = 0;
+		for( int gram = 0; gram < numGrams; gram++ ) {
+			int* count = tableAt( &counts, gram );
+			int* last = tableAt( &lastTerms, gram );
+			gramStarts[gram] = offset;
+			offset += *count;
+			*count = gramStarts[gram];
+			*last = -1;
+		}
+		gramStarts[numGrams] = offset;
+		gramTerms = malloc( sizeof( int ) * ( (size_t)offset + 1 ) );
+	}
+	if( gramTerms == NULL || collectGrams( &counts, &lastTerms, true ) != 0 ) {
+		result = -1;
+	}
+	tableFree( &counts );
+	tableFree( &lastTerms );
+	if( result != 0 ) {
+		freeSearchIndex();
+	}
+	return result;
+}
+
+/**
+ * @brief Release the memory held by the search index.
+ */
+void freeSearchIndex() {
+	tableFree( &searchTerms );
+	intMapFree( &gramIndex );
+	free( termShows );
+	free( gramStarts );
+	free( gramTerms );
+	termShows = NULL;
+	gramStarts = NULL;
+	gramTerms = NULL;
+	numGrams = 0;
+}
+
+/**
+ * @brief Check whether a term contains a query.
+ *
+ * @param text The term.
+ * @param query The query, in lower case.
+ * @param length Length of the query.
+ * @param mode SEARCH_SUBSTRING to match anywhere, or SEARCH_PREFIX to match only at the start of a word.
+ * @return true if the query occurs in the term.
+ */
+static bool matchesTerm( const char* text, const char* query, size_t length, SearchMode mode ) {
+	for( size_t i = 0; text[i] != '\0'; i++ ) {
+		if( mode == SEARCH_PREFIX && i > 0 && isWordCharacter( text[i - 1] ) ) {
+			continue;
+		}
+		size_t j = 0;
+		while( j < length && text[i + j] != '\0' && foldCase( text[i + j] ) == query[j] ) {
+			j++;
+		}
+		if( j == length ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Find the grams of a query with the fewest terms.
+ *
+ * @param query The query.
+ * @param length Length of the query, at least 1.
+ * @param gram Pointer to store the gram whose terms are the candidates.
+ * @return true if every gram of the query is in the index.
+ */
+static bool findRarestGram( const char* query, size_t length, int* gram ) {
+	if( length <= SEARCH_GRAM_LENGTH ) {
+		return intMapGet( &gramIndex, gramKey( query, length ), gram );
+	}
+	int best = -1;
+	for( size_t start = 0; start + SEARCH_GRAM_LENGTH <= length; start++ ) {
+		int candidate;
+		if( !intMapGet( &gramIndex, gramKey( query + start, SEARCH_GRAM_LENGTH ), &candidate ) ) {
+			return false;
+		}
+		if( best < 0 || gramStarts[candidate + 1] - gramStarts[candidate] < gramStarts[best + 1] - gramStarts[best] ) {
+			best = candidate;
+		}
+	}
+	*gram = best;
+	return true;
+}
+
+/**
+ * @brief Find the shows whose singer, venue or type contains a query, in date order.
+ *
+ * Matching ignores the case of ASCII letters. A query of up to SEARCH_GRAM_LENGTH characters is looked up as one
+ * gram; a longer one is checked only against the terms that contain all of its grams.
+ *
+ * @param query The query.
+ * @param fields The fields to search, a combination of SEARCH_SINGER, SEARCH_VENUE and SEARCH_TYPE.
+ * @param mode SEARCH_SUBSTRING to match anywhere, or SEARCH_PREFIX to match only at the start of a word.
+ * @param from Date order position of the first show to return, such as the first upcoming show.
+ * @param positions Array to store the date order positions of the matching shows in.
+ * @param maxResults Size of the array.
+ * @return The number of matching shows from that position on, which may exceed maxResults, or -1 if memory could
+ *         not be allocated.
+ */
+int searchShows( const char* query, int fields, SearchMode mode, int from, int positions[], int maxResults ) {
+	int numShows = getShowCount();
+	size_t length = strlen( query );
+	if( from < 0 ) {
+		from = 0;
+	}
+	if( length == 0 ) {
+		for( int position = from; position < numShows && position - from < maxResults; position++ ) {
+			positions[position - from] = position;
+		}
+		return numShows > from ? numShows - from : 0;
+	}
+	int gram;
+	if( gramStarts == NULL || !findRarestGram( query, length, &gram ) ) {
+		return 0;
+	}
+	char* folded = malloc( length + 1 );
+	Bitmap matches;
+	if( folded == NULL || bitmapInit( &matches, numShows ) != 0 ) {
+		free( folded );
+		return -1;
+	}
+	for( size_t i = 0; i <= length; i++ ) {
+		folded[i] = foldCase( query[i] );
+	}
+	// a short query is a gram itself, so every term of that gram contains it
+	bool check = length > SEARCH_GRAM_LENGTH || mode == SEARCH_PREFIX;
+	for( int i = gramStarts[gram]; i < gramStarts[gram + 1]; i++ ) {
+		const SearchTerm* term = tableAt( &searchTerms, gramTerms[i] );
+		if( ( term->field & fields ) == 0 || ( check && !matchesTerm( getString( term->text ), folded, length, mode ) ) ) {
+			continue;
+		}
+		const int* shows = termShows + term->firstShow;
+		for( int j = term->numShows - 1; j >= 0 && shows[j] >= from; j-- ) {
+			bitmapSet( &matches, shows[j] );
+		}
+	}
+	int count = 0;
+	for( int position = bitmapNextSet( &matches, from ); position >= 0;
+			position = bitmapNextSet( &matches, position + 1 ) ) {
+		if( count < maxResults ) {
+			positions[count] = position;
+		}
+		count++;
+	}
+	bitmapFree( &matches );
+	free( folded );
+	return count;
+}
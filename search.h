@@ -0,0 +1,57 @@
+/**
+ * @file include/search.h
+ */
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <stdbool.h>
+
+#define SEARCH_SINGER 1
+#define SEARCH_VENUE 2
+#define SEARCH_TYPE 4
+#define SEARCH_ALL_FIELDS ( SEARCH_SINGER | SEARCH_VENUE | SEARCH_TYPE )
+#define SEARCH_GRAM_LENGTH 3
+
+/**
+ * @brief How a query has to occur in a field.
+ */
+typedef enum {
+	SEARCH_SUBSTRING,
+	SEARCH_PREFIX
+} SearchMode;
+
+/**
+ * @brief Build the search index over the singer, venue and type of every show in the catalog.
+ *
+ * Every distinct value of a field is a term with the date order positions of its shows. Every substring of up to
+ * SEARCH_GRAM_LENGTH characters of a term, in lower case, is a gram with the terms that contain it. Called by the
+ * catalog whenever it is loaded, after its date index is built.
+ *
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+int buildSearchIndex();
+
+/**
+ * @brief Release the memory held by the search index.
+ */
+void freeSearchIndex();
+
+/**
+ * @brief Find the shows whose singer, venue or type contains a query, in date order.
+ *
+ * Matching ignores the case of ASCII letters. A query of up to SEARCH_GRAM_LENGTH characters is looked up as one
+ * gram; a longer one is checked only against the terms that contain all of its grams.
+ *
+ * @param query The query.
+ * @param fields The fields to search, a combination of SEARCH_SINGER, SEARCH_VENUE and SEARCH_TYPE.
+ * @param mode SEARCH_SUBSTRING to match anywhere, or SEARCH_PREFIX to match only at the start of a word.
+ * @param from Date order position of the first show to return, such as the first upcoming show.
+ * @param positions Array to store the date order positions of the matching shows in.
+ * @param maxResults Size of the array.
+ * @return The number of matching shows from that position on, which may exceed maxResults, or -1 if memory could
+ *         not be allocated.
+ */
+int searchShows( const char* query, int fields, SearchMode mode, int from, int positions[], int maxResults );
+
+#endif // SEARCH_H
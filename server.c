@@ -0,0 +1,282 @@
+/**
+ * @file src/server.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "../include/server.h"
+#include "../include/commands.h"
+#include "../include/tickets.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+
+/**
+ * @brief Serve booking commands over a Unix-domain socket until SIGINT or SIGTERM.
+ *
+ * Each connection sends one command per line, in the format of runCommand(), and receives its result. A connection
+ * must log in before it can book, and then acts only for that user; see runCommandStream(). The socket is only
+ * accessible to the owner of the process. Connections are handed to a pool of worker threads; bookings lock only
+ * the show they touch, so bookings of different shows run in parallel. The shows and tickets must be loaded before
+ * the call.
+ *
+ * @param socketPath Path of the socket to listen on.
+ * @param numWorkers Number of worker threads, or 0 for one per processor.
+ * @return 0 after a clean shutdown, -1 if the server could not start.
+ */
+int runServer( const char* socketPath, int numWorkers ) {
+	printf( "Server mode is not supported on Windows.\n" );
+	return -1;
+}
+
+#else
+
+#include <signal.h>
+#include <time.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#define MAX_WORKERS 256
+#define QUEUE_CAPACITY 1024
+#define MAINTENANCE_INTERVAL 1
+
+/**
+ * @brief Accepted connections waiting for a worker, and the connection each worker is serving.
+ */
+typedef struct {
+	int fds[QUEUE_CAPACITY];
+	int head;
+	int count;
+	int activeFds[MAX_WORKERS];
+	bool stopping;
+	pthread_mutex_t lock;
+	pthread_cond_t ready;
+	pthread_cond_t stopped;
+} ConnectionQueue;
+
+static ConnectionQueue queue = { .lock = PTHREAD_MUTEX_INITIALIZER, .ready = PTHREAD_COND_INITIALIZER,
+								 .stopped = PTHREAD_COND_INITIALIZER };
+static volatile sig_atomic_t stopRequested = 0;
+
+/**
+ * @brief Signal handler that asks the accept loop to stop.
+ *
+ * @param signalNumber The signal number.
+ */
+static void requestStop( int signalNumber ) {
+	(void)signalNumber;
+	stopRequested = 1;
+}
+
+/**
+ * @brief Run the commands sent over a connection until the client disconnects or sends "quit".
+ *
+ * @param fd The connection, closed by the caller.
+ */
+static void serveConnection( int fd ) {
+	int inFd = dup( fd );
+	int outFd = dup( fd );
+	FILE* in = inFd >= 0 ? fdopen( inFd, "r" ) : NULL;
+	FILE* out = outFd >= 0 ? fdopen( outFd, "w" ) : NULL;
+	if( in != NULL && out != NULL ) {
+		runCommandStream( in, out, true );
+	}
+	if( in != NULL ) {
+		fclose( in );
+	} else if( inFd >= 0 ) {
+		close( inFd );
+	}
+	if( out != NULL ) {
+		fclose( out );
+	} else if( outFd >= 0 ) {
+		close( outFd );
+	}
+}
+
+/**
+ * @brief Worker thread: serve queued connections until the server stops.
+ *
+ * @param argument The worker number.
+ * @return NULL.
+ */
+static void* runWorker( void* argument ) {
+	int worker = (int)(intptr_t)argument;
+	while( true ) {
+		pthread_mutex_lock( &queue.lock );
+		while( queue.count == 0 && !queue.stopping ) {
+			pthread_cond_wait( &queue.ready, &queue.lock );
+		}
+		if( queue.stopping ) {
+			pthread_mutex_unlock( &queue.lock );
+			break;
+		}
+		int fd = queue.fds[queue.head];
+		queue.head = ( queue.head + 1 ) % QUEUE_CAPACITY;
+		queue.count--;
+		queue.activeFds[worker] = fd;
+		pthread_mutex_unlock( &queue.lock );
+		serveConnection( fd );
+		pthread_mutex_lock( &queue.lock );
+		queue.activeFds[worker] = -1;
+		pthread_mutex_unlock( &queue.lock );
+		close( fd );
+	}
+	return NULL;
+}
+
+/**
+ * @brief Maintenance thread: compact the ticket store whenever it is due, every MAINTENANCE_INTERVAL seconds, until
+ * the server stops.
+ *
+ * Compaction takes the store lock exclusively, so bookings wait for it, but no booking has to run it.
+ *
+ * @param argument Unused.
+ * @return NULL.
+ */
+static void* runMaintenance( void* argument ) {
+	(void)argument;
+	pthread_mutex_lock( &queue.lock );
+	while( !queue.stopping ) {
+		pthread_mutex_unlock( &queue.lock );
+		compactTicketsWhenDue( false );
+		struct timespec deadline;
+		clock_gettime( CLOCK_REALTIME, &deadline );
+		deadline.tv_sec += MAINTENANCE_INTERVAL;
+		pthread_mutex_lock( &queue.lock );
+		if( !queue.stopping ) {
+			pthread_cond_timedwait( &queue.stopped, &queue.lock, &deadline );
+		}
+	}
+	pthread_mutex_unlock( &queue.lock );
+	return NULL;
+}
+
+/**
+ * @brief Create the listening socket, readable and writable by the owner only.
+ *
+ * @param socketPath Path of the socket.
+ * @return The socket, or -1 on failure.
+ */
+static int openListener( const char* socketPath ) {
+	struct sockaddr_un address;
+	memset( &address, 0, sizeof( address ) );
+	address.sun_family = AF_UNIX;
+	if( strlen( socketPath ) >= sizeof( address.sun_path ) ) {
+		return -1;
+	}
+	strcpy( address.sun_path, socketPath );
+	int listener = socket( AF_UNIX, SOCK_STREAM, 0 );
+	if( listener < 0 ) {
+		return -1;
+	}
+	unlink( socketPath );
+	// the socket file is created with the permissions of the mask, so no other user can connect even briefly
+	mode_t previousMask = umask( 0077 );
+	int bound = bind( listener, (struct sockaddr*)&address, sizeof( address ) );
+	umask( previousMask );
+	if( bound != 0 || chmod( socketPath, 0600 ) != 0 || listen( listener, SOMAXCONN ) != 0 ) {
+		close( listener );
+		return -1;
+	}
+	return listener;
+}
+
+/**
+ * @brief Serve booking commands over a Unix-domain socket until SIGINT or SIGTERM.
+ *
+ * Each connection sends one command per line, in the format of runCommand(), and receives its result. A connection
+ * must log in before it can book, and then acts only for that user; see runCommandStream(). The socket is only
+ * accessible to the owner of the process. Connections are handed to a pool of worker threads; bookings lock only
+ * the show they touch, so bookings of different shows run in parallel. The shows and tickets must be loaded before
+ * the call.
+ *
+ * @param socketPath Path of the socket to listen on.
+ * @param numWorkers Number of worker threads, or 0 for one per processor.
+ * @return 0 after a clean shutdown, -1 if the server could not start.
+ */
+int runServer( const char* socketPath, int numWorkers ) {
+	if( numWorkers <= 0 ) {
+		numWorkers = (int)sysconf( _SC_NPROCESSORS_ONLN );
+	}
+	if( numWorkers < 1 ) {
+		numWorkers = 1;
+	} else if( numWorkers > MAX_WORKERS ) {
+		numWorkers = MAX_WORKERS;
+	}
+	int listener = openListener( socketPath );
+	if( listener < 0 ) {
+		printf( "Cannot listen on %s\n", socketPath );
+		return -1;
+	}
+	struct sigaction action;
+	memset( &action, 0, sizeof( action ) );
+	action.sa_handler = requestStop;
+	sigaction( SIGINT, &action, NULL );
+	sigaction( SIGTERM, &action, NULL );
+	signal( SIGPIPE, SIG_IGN );
+	sigset_t stopSignals, previous;
+	sigemptyset( &stopSignals );
+	sigaddset( &stopSignals, SIGINT );
+	sigaddset( &stopSignals, SIGTERM );
+	pthread_sigmask( SIG_BLOCK, &stopSignals, &previous );
+	pthread_t workers[MAX_WORKERS];
+	int started = 0;
+	for( ; started < numWorkers; started++ ) {
+		queue.activeFds[started] = -1;
+		if( pthread_create( &workers[started], NULL, runWorker, (void*)(intptr_t)started ) != 0 ) {
+			break;
+		}
+	}
+	pthread_t maintenance;
+	bool maintaining = started > 0 && pthread_create( &maintenance, NULL, runMaintenance, NULL ) == 0;
+	pthread_sigmask( SIG_SETMASK, &previous, NULL );
+	printf( "Listening on %s with %d worker(s)\n", socketPath, started );
+	fflush( stdout );
+	while( !stopRequested && started > 0 ) {
+		int fd = accept( listener, NULL, NULL );
+		if( fd < 0 ) {
+			continue;
+		}
+		pthread_mutex_lock( &queue.lock );
+		if( queue.count == QUEUE_CAPACITY ) {
+			pthread_mutex_unlock( &queue.lock );
+			close( fd );
+			continue;
+		}
+		queue.fds[( queue.head + queue.count ) % QUEUE_CAPACITY] = fd;
+		queue.count++;
+		pthread_cond_signal( &queue.ready );
+		pthread_mutex_unlock( &queue.lock );
+	}
+	pthread_mutex_lock( &queue.lock );
+	queue.stopping = true;
+	for( int i = 0; i < started; i++ ) {
+		if( queue.activeFds[i] >= 0 ) {
+			shutdown( queue.activeFds[i], SHUT_RDWR );
+		}
+	}
+	for( ; queue.count > 0; queue.count-- ) {
+		close( queue.fds[queue.head] );
+		queue.head = ( queue.head + 1 ) % QUEUE_CAPACITY;
+	}
+	pthread_cond_broadcast( &queue.ready );
+	pthread_cond_broadcast( &queue.stopped );
+	pthread_mutex_unlock( &queue.lock );
+	for( int i = 0; i < started; i++ ) {
+		pthread_join( workers[i], NULL );
+	}
+	if( maintaining ) {
+		pthread_join( maintenance, NULL );
+	}
+	close( listener );
+	unlink( socketPath );
+	printf( "Server stopped\n" );
+	return 0;
+}
+
+#endif
@@ -0,0 +1,25 @@
+/**
+ * @file include/server.h
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#define SERVER_SOCKET "data/ticket.sock"
+
+/**
+ * @brief Serve booking commands over a Unix-domain socket until SIGINT or SIGTERM.
+ *
+ * Each connection sends one command per line, in the format of runCommand(), and receives its result. A connection
+ * must log in before it can book, and then acts only for that user; see runCommandStream(). The socket is only
+ * accessible to the owner of the process. Connections are handed to a pool of worker threads; bookings lock only
+ * the show they touch, so bookings of different shows run in parallel. The shows and tickets must be loaded before
+ * the call.
+ *
+ * @param socketPath Path of the socket to listen on.
+ * @param numWorkers Number of worker threads, or 0 for one per processor.
+ * @return 0 after a clean shutdown, -1 if the server could not start.
+ */
+int runServer( const char* socketPath, int numWorkers );
+
+#endif // SERVER_H
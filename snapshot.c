@@ -0,0 +1,359 @@
+/**
+ * @file src/snapshot.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "../include/snapshot.h"
+#include "../include/stats.h"
+
+#define HEAP_INITIAL_CAPACITY 4096
+
+/**
+ * @brief Read the size and modification time of a file.
+ *
+ * @param filename The name of the file.
+ * @param header Header to store the size and time in.
+ * @return 0 on success, -1 if the file does not exist.
+ */
+static int readSourceStamp( const char* filename, SnapshotHeader* header ) {
+	struct stat info;
+	if( stat( filename, &info ) != 0 ) {
+		return -1;
+	}
+	header->sourceSize = (int64_t)info.st_size;
+	header->sourceMtimeSec = (int64_t)info.st_mtime;
+	#if defined(_WIN32) || defined(_WIN64)
+	header->sourceMtimeNsec = 0;
+	#elif defined(__APPLE__)
+	header->sourceMtimeNsec = (int64_t)info.st_mtimespec.tv_nsec;
+	#else
+	header->sourceMtimeNsec = (int64_t)info.st_mtim.tv_nsec;
+	#endif
+	return 0;
+}
+
+/**
+ * @brief Round a size up to a multiple of 8.
+ *
+ * @param size The size.
+ * @return The rounded size.
+ */
+static uint64_t alignTo8( uint64_t size ) {
+	return ( size + 7 ) & ~(uint64_t)7;
+}
+
+/**
+ * @brief Derive the snapshot file name of a text database by replacing its extension with ".bin".
+ *
+ * @param filename The name of the text database.
+ * @param snapshotName Buffer to store the snapshot file name.
+ * @param size Size of the buffer.
+ */
+void getSnapshotFilename( const char* filename, char* snapshotName, size_t size ) {
+	const char* dot = strrchr( filename, '.' );
+	const char* slash = strrchr( filename, '/' );
+	int length = ( dot != NULL && ( slash == NULL || dot > slash ) ) ? (int)( dot - filename ) : (int)strlen( filename );
+	snprintf( snapshotName, size, "%.*s.bin", length, filename );
+}
+
+/**
+ * @brief Map a snapshot and check that it is current.
+ *
+ * @param snapshot The snapshot to open.
+ * @param filename The name of the snapshot file.
+ * @param sourceFilename The name of the text database the snapshot must match.
+ * @param recordSize Expected size of a row.
+ * @return 0 on success, -1 if the snapshot is missing, malformed or older than the text database.
+ */
+int openSnapshot( Snapshot* snapshot, const char* filename, const char* sourceFilename, uint32_t recordSize ) {
+	if( openDataFile( &snapshot->file, filename ) != 0 ) {
+		return -1;
+	}
+	const SnapshotHeader* header = (const SnapshotHeader*)snapshot->file.data;
+	SnapshotHeader source;
+	if( snapshot->file.size < sizeof( SnapshotHeader ) || memcmp( header->magic, SNAPSHOT_MAGIC, sizeof( header->magic ) ) != 0 ||
+			header->version != SNAPSHOT_VERSION || header->byteOrder != SNAPSHOT_BYTE_ORDER ||
+			header->recordSize != recordSize || readSourceStamp( sourceFilename, &source ) != 0 ||
+			header->sourceSize != source.sourceSize || header->sourceMtimeSec != source.sourceMtimeSec ||
+			header->sourceMtimeNsec != source.sourceMtimeNsec ) {
+		closeDataFile( &snapshot->file );
+		return -1;
+	}
+	uint64_t rowsSize = alignTo8( header->rowCount * recordSize );
+	if( header->rowCount > ( snapshot->file.size - sizeof( SnapshotHeader ) ) / ( recordSize > 0 ? recordSize : 1 ) ||
+			sizeof( SnapshotHeader ) + rowsSize + header->heapSize != snapshot->file.size ) {
+		closeDataFile( &snapshot->file );
+		return -1;
+	}
+	snapshot->header = header;
+	snapshot->rows = snapshot->file.data + sizeof( SnapshotHeader );
+	snapshot->heap = snapshot->rows + rowsSize;
+	memset( &snapshot->loadedStrings, 0, sizeof( snapshot->loadedStrings ) );
+	return 0;
+}
+
+/**
+ * @brief Get a row of a snapshot.
+ *
+ * @param snapshot The snapshot.
+ * @param index Position of the row.
+ * @return Pointer to the row inside the mapping.
+ */
+const void* getSnapshotRow( const Snapshot* snapshot, uint64_t index ) {
+	return snapshot->rows + index * snapshot->header->recordSize;
+}
+
+/**
+ * @brief Get a string from the heap of a snapshot.
+ *
+ * @param snapshot The snapshot.
+ * @param offset Heap offset of the string.
+ * @param length Pointer to store the length of the string.
+ * @return Pointer to the characters inside the mapping, or NULL if the offset is invalid.
+ */
+const char* getSnapshotString( const Snapshot* snapshot, uint32_t offset, size_t* length ) {
+	if( offset % 4 != 0 || (uint64_t)offset + sizeof( uint32_t ) > snapshot->header->heapSize ) {
+		return NULL;
+	}
+	uint32_t stored = *(const uint32_t*)( snapshot->heap + offset );
+	if( (uint64_t)offset + sizeof( uint32_t ) + stored >= snapshot->header->heapSize ) {
+		return NULL;
+	}
+	*length = stored;
+	return snapshot->heap + offset + sizeof( uint32_t );
+}
+
+/**
+ * @brief Copy a string from the heap of a snapshot into the string pool.
+ *
+ * Shared strings are interned once per snapshot no matter how many rows refer to them; unique strings are
+ * stored directly.
+ *
+ * @param snapshot The snapshot.
+ * @param offset Heap offset of the string.
+ * @param shared Whether the string is shared between rows.
+ * @param id Pointer to store the handle of the string.
+ * @return true if the offset was valid.
+ */
+bool loadSnapshotString( Snapshot* snapshot, uint32_t offset, bool shared, StrId* id ) {
+	int cached;
+	if( shared && intMapGet( &snapshot->loadedStrings, offset, &cached ) ) {
+		*id = (StrId)(uint32_t)cached;
+		return true;
+	}
+	size_t length;
+	const char* text = getSnapshotString( snapshot, offset, &length );
+	if( text == NULL ) {
+		return false;
+	}
+	if( !shared ) {
+		*id = storeString( text, length );
+		return true;
+	}
+	*id = internString( text, length );
+	intMapPut( &snapshot->loadedStrings, offset, (int)(uint32_t)*id );
+	return true;
+}
+
+/**
+ * @brief Get an array of 64-bit words from the heap of a snapshot.
+ *
+ * @param snapshot The snapshot.
+ * @param offset Heap offset of the words.
+ * @param count Number of words.
+ * @return Pointer to the words inside the mapping, or NULL if the range is invalid.
+ */
+const uint64_t* getSnapshotWords( const Snapshot* snapshot, uint32_t offset, size_t count ) {
+	if( offset % 8 != 0 || (uint64_t)offset + count * sizeof( uint64_t ) > snapshot->header->heapSize ) {
+		return NULL;
+	}
+	return (const uint64_t*)( snapshot->heap + offset );
+}
+
+/**
+ * @brief Unmap a snapshot.
+ *
+ * @param snapshot The snapshot.
+ */
+void closeSnapshot( Snapshot* snapshot ) {
+	closeDataFile( &snapshot->file );
+	intMapFree( &snapshot->loadedStrings );
+	snapshot->header = NULL;
+	snapshot->rows = NULL;
+	snapshot->heap = NULL;
+}
+
+/**
+ * @brief Reserve space at the end of the heap being written.
+ *
+ * @param writer The writer.
+ * @param alignment Alignment of the space, a power of two.
+ * @param size Number of bytes.
+ * @param offset Pointer to store the heap offset of the space.
+ * @return Pointer to the zeroed space, or NULL if memory could not be allocated.
+ */
+static char* reserveHeap( SnapshotWriter* writer, size_t alignment, size_t size, uint32_t* offset ) {
+	size_t start = ( writer->heapSize + alignment - 1 ) & ~( alignment - 1 );
+	if( start + size > UINT32_MAX ) {
+		writer->failed = true;
+		return NULL;
+	}
+	if( start + size > writer->heapCapacity ) {
+		size_t capacity = writer->heapCapacity > 0 ? writer->heapCapacity : HEAP_INITIAL_CAPACITY;
+		while( capacity < start + size ) {
+			capacity *= 2;
+		}
+		char* grown = realloc( writer->heap, capacity );
+		if( grown == NULL ) {
+			writer->failed = true;
+			return NULL;
+		}
+		writer->heap = grown;
+		writer->heapCapacity = capacity;
+	}
+	memset( writer->heap + writer->heapSize, 0, start + size - writer->heapSize );
+	writer->heapSize = start + size;
+	*offset = (uint32_t)start;
+	return writer->heap + start;
+}
+
+/**
+ * @brief Start writing a snapshot to a temporary file next to its final name.
+ *
+ * @param writer The writer.
+ * @param filename The name of the snapshot file.
+ * @param recordSize Size of a row.
+ * @return 0 on success, -1 if the file could not be created.
+ */
+int beginSnapshot( SnapshotWriter* writer, const char* filename, uint32_t recordSize ) {
+	memset( writer, 0, sizeof( *writer ) );
+	strncpy( writer->filename, filename, sizeof( writer->filename ) - 1 );
+	snprintf( writer->tempFilename, sizeof( writer->tempFilename ), "%s.tmp", filename );
+	writer->recordSize = recordSize;
+	writer->file = fopen( writer->tempFilename, "wb" );
+	if( writer->file == NULL ) {
+		return -1;
+	}
+	countFileOpen();
+	SnapshotHeader header = { 0 };
+	uint32_t emptyOffset;
+	if( fwrite( &header, sizeof( header ), 1, writer->file ) != 1 ||
+			reserveHeap( writer, 8, sizeof( uint32_t ) + 1, &emptyOffset ) == NULL ) {
+		fclose( writer->file );
+		remove( writer->tempFilename );
+		free( writer->heap );
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief Append a row to a snapshot.
+ *
+ * @param writer The writer.
+ * @param row The row, recordSize bytes.
+ */
+void writeSnapshotRow( SnapshotWriter* writer, const void* row ) {
+	if( fwrite( row, writer->recordSize, 1, writer->file ) != 1 ) {
+		writer->failed = true;
+	}
+	writer->rowCount++;
+}
+
+/**
+ * @brief Add a pooled string to the heap of a snapshot.
+ *
+ * @param writer The writer.
+ * @param id Handle of the string.
+ * @return Heap offset of the string.
+ */
+uint32_t addSnapshotString( SnapshotWriter* writer, StrId id ) {
+	int existing;
+	if( id == EMPTY_STRING ) {
+		return 0;
+	}
+	if( intMapGet( &writer->heapStrings, id, &existing ) ) {
+		return (uint32_t)existing;
+	}
+	const char* text = getString( id );
+	size_t length = strlen( text );
+	uint32_t offset;
+	char* entry = reserveHeap( writer, sizeof( uint32_t ), sizeof( uint32_t ) + length + 1, &offset );
+	if( entry == NULL ) {
+		return 0;
+	}
+	uint32_t stored = (uint32_t)length;
+	memcpy( entry, &stored, sizeof( stored ) );
+	memcpy( entry + sizeof( stored ), text, length );
+	if( offset <= INT32_MAX && intMapPut( &writer->heapStrings, id, (int)offset ) != 0 ) {
+		writer->failed = true;
+	}
+	return offset;
+}
+
+/**
+ * @brief Add an array of 64-bit words to the heap of a snapshot.
+ *
+ * @param writer The writer.
+ * @param words The words.
+ * @param count Number of words.
+ * @return Heap offset of the words.
+ */
+uint32_t addSnapshotWords( SnapshotWriter* writer, const uint64_t* words, size_t count ) {
+	uint32_t offset;
+	char* entry = reserveHeap( writer, sizeof( uint64_t ), count * sizeof( uint64_t ), &offset );
+	if( entry == NULL ) {
+		return 0;
+	}
+	if( count > 0 ) {
+		memcpy( entry, words, count * sizeof( uint64_t ) );
+	}
+	return offset;
+}
+
+/**
+ * @brief Finish a snapshot and move it into place.
+ *
+ * @param writer The writer, released by the call.
+ * @param sourceFilename The name of the text database the snapshot was taken against.
+ * @param journalOffset Length of the journal the snapshot reflects.
+ * @param journalRecords Number of records in that part of the journal.
+ * @return 0 on success, -1 if the snapshot could not be written.
+ */
+int endSnapshot( SnapshotWriter* writer, const char* sourceFilename, uint64_t journalOffset, uint64_t journalRecords ) {
+	SnapshotHeader header = { 0 };
+	memcpy( header.magic, SNAPSHOT_MAGIC, sizeof( SNAPSHOT_MAGIC ) );
+	header.version = SNAPSHOT_VERSION;
+	header.byteOrder = SNAPSHOT_BYTE_ORDER;
+	header.recordSize = writer->recordSize;
+	header.rowCount = writer->rowCount;
+	header.heapSize = alignTo8( writer->heapSize );
+	header.journalOffset = journalOffset;
+	header.journalRecords = journalRecords;
+	uint64_t padding = alignTo8( writer->rowCount * writer->recordSize ) - writer->rowCount * writer->recordSize;
+	uint32_t unused;
+	if( readSourceStamp( sourceFilename, &header ) != 0 || reserveHeap( writer, 8, 0, &unused ) == NULL ) {
+		writer->failed = true;
+	}
+	const uint64_t zero = 0;
+	if( writer->failed || fwrite( &zero, 1, padding, writer->file ) != padding ||
+			fwrite( writer->heap, 1, writer->heapSize, writer->file ) != writer->heapSize ||
+			fseek( writer->file, 0, SEEK_SET ) != 0 || fwrite( &header, sizeof( header ), 1, writer->file ) != 1 ) {
+		writer->failed = true;
+	}
+	countBytesWritten( sizeof( header ) + writer->rowCount * writer->recordSize + padding + writer->heapSize );
+	if( fclose( writer->file ) != 0 ) {
+		writer->failed = true;
+	}
+	free( writer->heap );
+	intMapFree( &writer->heapStrings );
+	writer->heap = NULL;
+	if( writer->failed || replaceFile( writer->tempFilename, writer->filename ) != 0 ) {
+		remove( writer->tempFilename );
+		return -1;
+	}
+	return 0;
+}
@@ -0,0 +1,189 @@
+/**
+ * @file include/snapshot.h
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "utilities.h"
+#include "datafile.h"
+#include "intmap.h"
+
+#define SNAPSHOT_MAGIC "TKTSNAP"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+
+/**
+ * @brief Header at the start of a snapshot file.
+ *
+ * A snapshot holds one table as fixed-width rows followed by a heap of strings and seat maps that rows refer to
+ * by offset. It records the size and modification time of the text database it was taken against, and for
+ * journaled tables how much of the journal it already reflects.
+ */
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint32_t recordSize;
+	uint32_t reserved;
+	uint64_t rowCount;
+	uint64_t heapSize;
+	int64_t sourceSize;
+	int64_t sourceMtimeSec;
+	int64_t sourceMtimeNsec;
+	uint64_t journalOffset;
+	uint64_t journalRecords;
+} SnapshotHeader;
+
+/**
+ * @brief A snapshot file mapped into memory for reading.
+ */
+typedef struct {
+	DataFile file;
+	const SnapshotHeader* header;
+	const char* rows;
+	const char* heap;
+	IntMap loadedStrings;
+} Snapshot;
+
+/**
+ * @brief A snapshot file being written.
+ *
+ * Rows are streamed to a temporary file; the heap is built in memory, sharing one copy of each pooled string,
+ * and appended when the snapshot is finished.
+ */
+typedef struct {
+	FILE* file;
+	char filename[MAX_LENGTH];
+	char tempFilename[MAX_LENGTH + 4];
+	uint32_t recordSize;
+	uint64_t rowCount;
+	char* heap;
+	size_t heapSize;
+	size_t heapCapacity;
+	IntMap heapStrings;
+	bool failed;
+} SnapshotWriter;
+
+/**
+ * @brief Derive the snapshot file name of a text database by replacing its extension with ".bin".
+ *
+ * @param filename The name of the text database.
+ * @param snapshotName Buffer to store the snapshot file name.
+ * @param size Size of the buffer.
+ */
+void getSnapshotFilename( const char* filename, char* snapshotName, size_t size );
+
+/**
+ * @brief Map a snapshot and check that it is current.
+ *
+ * @param snapshot The snapshot to open.
+ * @param filename The name of the snapshot file.
+ * @param sourceFilename The name of the text database the snapshot must match.
+ * @param recordSize Expected size of a row.
+ * @return 0 on success, -1 if the snapshot is missing, malformed or older than the text database.
+ */
+int openSnapshot( Snapshot* snapshot, const char* filename, const char* sourceFilename, uint32_t recordSize );
+
+/**
+ * @brief Get a row of a snapshot.
+ *
+ * @param snapshot The snapshot.
+ * @param index Position of the row.
+ * @return Pointer to the row inside the mapping.
+ */
+const void* getSnapshotRow( const Snapshot* snapshot, uint64_t index );
+
+/**
+ * @brief Get a string from the heap of a snapshot.
+ *
+ * @param snapshot The snapshot.
+ * @param offset Heap offset of the string.
+ * @param length Pointer to store the length of the string.
+ * @return Pointer to the characters inside the mapping, or NULL if the offset is invalid.
+ */
+const char* getSnapshotString( const Snapshot* snapshot, uint32_t offset, size_t* length );
+
+/**
+ * @brief Copy a string from the heap of a snapshot into the string pool.
+ *
+ * Shared strings are interned once per snapshot no matter how many rows refer to them; unique strings are
+ * stored directly.
+ *
+ * @param snapshot The snapshot.
+ * @param offset Heap offset of the string.
+ * @param shared Whether the string is shared between rows.
+ * @param id Pointer to store the handle of the string.
+ * @return true if the offset was valid.
+ */
+bool loadSnapshotString( Snapshot* snapshot, uint32_t offset, bool shared, StrId* id );
+
+/**
+ * @brief Get an array of 64-bit words from the heap of a snapshot.
+ *
+ * @param snapshot The snapshot.
+ * @param offset Heap offset of the words.
+ * @param count Number of words.
+ * @return Pointer to the words inside the mapping, or NULL if the range is invalid.
+ */
+const uint64_t* getSnapshotWords( const Snapshot* snapshot, uint32_t offset, size_t count );
+
+/**
+ * @brief Unmap a snapshot.
+ *
+ * @param snapshot The snapshot.
+ */
+void closeSnapshot( Snapshot* snapshot );
+
+/**
+ * @brief Start writing a snapshot to a temporary file next to its final name.
+ *
+ * @param writer The writer.
+ * @param filename The name of the snapshot file.
+ * @param recordSize Size of a row.
+ * @return 0 on success, -1 if the file could not be created.
+ */
+int beginSnapshot( SnapshotWriter* writer, const char* filename, uint32_t recordSize );
+
+/**
+ * @brief Append a row to a snapshot.
+ *
+ * @param writer The writer.
+ * @param row The row, recordSize bytes.
+ */
+void writeSnapshotRow( SnapshotWriter* writer, const void* row );
+
+/**
+ * @brief Add a pooled string to the heap of a snapshot.
+ *
+ * @param writer The writer.
+ * @param id Handle of the string.
+ * @return Heap offset of the string.
+ */
+uint32_t addSnapshotString( SnapshotWriter* writer, StrId id );
+
+/**
+ * @brief Add an array of 64-bit words to the heap of a snapshot.
+ *
+ * @param writer The writer.
+ * @param words The words.
+ * @param count Number of words.
+ * @return Heap offset of the words.
+ */
+uint32_t addSnapshotWords( SnapshotWriter* writer, const uint64_t* words, size_t count );
+
+/**
+ * @brief Finish a snapshot and move it into place.
+ *
+ * @param writer The writer, released by the call.
+ * @param sourceFilename The name of the text database the snapshot was taken against.
+ * @param journalOffset Length of the journal the snapshot reflects.
+ * @param journalRecords Number of records in that part of the journal.
+ * @return 0 on success, -1 if the snapshot could not be written.
+ */
+int endSnapshot( SnapshotWriter* writer, const char* sourceFilename, uint64_t journalOffset, uint64_t journalRecords );
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,292 @@
+/**
+ * @file src/stats.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <fcntl.h>
+#include "../include/stats.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+
+#include <windows.h>
+#include <io.h>
+
+#define STATS_THREAD_LOCAL __declspec( thread )
+#define writeFd _write
+#define openFd( filename ) _open( filename, _O_WRONLY | _O_CREAT | _O_APPEND, 0644 )
+#define closeFd _close
+
+#else
+
+#include <unistd.h>
+#include <signal.h>
+
+#define STATS_THREAD_LOCAL __thread
+#define writeFd write
+#define openFd( filename ) open( filename, O_WRONLY | O_CREAT | O_APPEND, 0644 )
+#define closeFd close
+
+#endif
+
+/**
+ * @brief Counters of one entry point.
+ *
+ * Bucket 0 of the latency histogram counts calls under 1 µs; bucket b counts calls from 2^(b-1) to 2^b µs.
+ */
+typedef struct {
+	uint64_t calls;
+	uint64_t totalNanos;
+	uint64_t maxNanos;
+	uint64_t bytesRead;
+	uint64_t bytesWritten;
+	uint64_t fileOpens;
+	uint64_t buckets[STATS_BUCKETS];
+} OperationStats;
+
+static const char* operationNames[STAT_OPERATIONS] = {
+	"other", "view-shows", "buy", "cancel", "list-tickets", "login", "register", "load", "save", "journal", "report"
+};
+
+static OperationStats stats[STAT_OPERATIONS];
+static STATS_THREAD_LOCAL StatOperation currentOperation = STAT_OTHER;
+static char statsFilename[4096] = "";
+static bool statsEnabled = false;
+
+/**
+ * @brief Add to a counter shared by all threads.
+ *
+ * @param counter The counter.
+ * @param value Amount to add.
+ */
+static void addCounter( uint64_t* counter, uint64_t value ) {
+	#if defined(__GNUC__) || defined(__clang__)
+	__atomic_fetch_add( counter, value, __ATOMIC_RELAXED );
+	#elif defined(_WIN32) || defined(_WIN64)
+	InterlockedExchangeAdd64( (volatile LONG64*)counter, (LONG64)value );
+	#else
+	*counter += value;
+	#endif
+}
+
+/**
+ * @brief Raise a maximum shared by all threads.
+ *
+ * @param maximum The maximum.
+ * @param value Candidate value.
+ */
+static void raiseMaximum( uint64_t* maximum, uint64_t value ) {
+	#if defined(__GNUC__) || defined(__clang__)
+	uint64_t seen = __atomic_load_n( maximum, __ATOMIC_RELAXED );
+	while( value > seen && !__atomic_compare_exchange_n( maximum, &seen, value, true, __ATOMIC_RELAXED,
+			__ATOMIC_RELAXED ) ) {
+	}
+	#elif defined(_WIN32) || defined(_WIN64)
+	LONG64 seen = *(volatile LONG64*)maximum;
+	while( (uint64_t)seen < value ) {
+		LONG64 previous = InterlockedCompareExchange64( (volatile LONG64*)maximum, (LONG64)value, seen );
+		if( previous == seen ) {
+			break;
+		}
+		seen = previous;
+	}
+	#else
+	if( value > *maximum ) {
+		*maximum = value;
+	}
+	#endif
+}
+
+/**
+ * @brief Read a monotonic clock.
+ *
+ * @return Nanoseconds since an arbitrary point.
+ */
+static uint64_t nowNanos() {
+	#if defined(_WIN32) || defined(_WIN64)
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter( &counter );
+	QueryPerformanceFrequency( &frequency );
+	return (uint64_t)( (double)counter.QuadPart * 1e9 / (double)frequency.QuadPart );
+	#else
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+	#endif
+}
+
+/**
+ * @brief Start timing a call of an entry point.
+ *
+ * @param timer The timer.
+ * @param operation The entry point.
+ */
+void startTimer( StatTimer* timer, StatOperation operation ) {
+	timer->operation = operation;
+	timer->outer = currentOperation;
+	currentOperation = operation;
+	timer->start = nowNanos();
+}
+
+/**
+ * @brief Stop a timer and record the call in the counters and latency histogram of its entry point.
+ *
+ * @param timer The timer.
+ */
+void stopTimer( StatTimer* timer ) {
+	uint64_t elapsed = nowNanos() - timer->start;
+	OperationStats* entry = &stats[timer->operation];
+	int bucket = 0;
+	for( uint64_t micros = elapsed / 1000; micros > 0 && bucket < STATS_BUCKETS - 1; micros >>= 1 ) {
+		bucket++;
+	}
+	addCounter( &entry->calls, 1 );
+	addCounter( &entry->totalNanos, elapsed );
+	addCounter( &entry->buckets[bucket], 1 );
+	raiseMaximum( &entry->maxNanos, elapsed );
+	currentOperation = timer->outer;
+}
+
+/**
+ * @brief Count a file opened by the running entry point.
+ */
+void countFileOpen() {
+	addCounter( &stats[currentOperation].fileOpens, 1 );
+}
+
+/**
+ * @brief Count bytes read by the running entry point.
+ *
+ * @param bytes Number of bytes.
+ */
+void countBytesRead( uint64_t bytes ) {
+	addCounter( &stats[currentOperation].bytesRead, bytes );
+}
+
+/**
+ * @brief Count bytes written by the running entry point.
+ *
+ * @param bytes Number of bytes.
+ */
+void countBytesWritten( uint64_t bytes ) {
+	addCounter( &stats[currentOperation].bytesWritten, bytes );
+}
+
+/**
+ * @brief Estimate a latency percentile from a histogram.
+ *
+ * @param entry Counters of the entry point.
+ * @param calls Number of calls counted in the histogram.
+ * @param percent The percentile, from 1 to 100.
+ * @return Upper bound of the bucket holding the percentile, in microseconds.
+ */
+static uint64_t getPercentile( const OperationStats* entry, uint64_t calls, int percent ) {
+	uint64_t rank = ( calls * (uint64_t)percent + 99 ) / 100;
+	uint64_t seen = 0;
+	for( int b = 0; b < STATS_BUCKETS; b++ ) {
+		seen += entry->buckets[b];
+		if( seen >= rank ) {
+			return (uint64_t)1 << b;
+		}
+	}
+	return (uint64_t)1 << ( STATS_BUCKETS - 1 );
+}
+
+/**
+ * @brief Write the counters and histograms of every entry point.
+ *
+ * Only formats integers into a stack buffer and calls write(), so it may run from a signal handler. Counters are
+ * read without stopping other threads; a dump taken while calls are running may be off by those calls.
+ *
+ * @param fd File descriptor to write to.
+ */
+void dumpStats( int fd ) {
+	char line[256];
+	int length = snprintf( line, sizeof( line ), "%-13s %10s %12s %10s %10s %10s %10s %14s %14s %8s\n",
+			"operation", "calls", "total_ms", "mean_us", "p50_us", "p99_us", "max_us", "bytes_read",
+			"bytes_written", "opens" );
+	writeFd( fd, line, length );
+	for( int i = 0; i < STAT_OPERATIONS; i++ ) {
+		const OperationStats* entry = &stats[i];
+		uint64_t calls = entry->calls;
+		if( calls == 0 && entry->fileOpens == 0 && entry->bytesRead == 0 && entry->bytesWritten == 0 ) {
+			continue;
+		}
+		length = snprintf( line, sizeof( line ),
+				"%-13s %10llu %12llu %10llu %10llu %10llu %10llu %14llu %14llu %8llu\n", operationNames[i],
+				(unsigned long long)calls, (unsigned long long)( entry->totalNanos / 1000000 ),
+				(unsigned long long)( calls > 0 ? entry->totalNanos / calls / 1000 : 0 ),
+				(unsigned long long)( calls > 0 ? getPercentile( entry, calls, 50 ) : 0 ),
+				(unsigned long long)( calls > 0 ? getPercentile( entry, calls, 99 ) : 0 ),
+				(unsigned long long)( entry->maxNanos / 1000 ), (unsigned long long)entry->bytesRead,
+				(unsigned long long)entry->bytesWritten, (unsigned long long)entry->fileOpens );
+		writeFd( fd, line, length );
+	}
+	for( int i = 0; i < STAT_OPERATIONS; i++ ) {
+		const OperationStats* entry = &stats[i];
+		if( entry->calls == 0 ) {
+			continue;
+		}
+		length = snprintf( line, sizeof( line ), "%s latency histogram (us <= count):", operationNames[i] );
+		for( int b = 0; b < STATS_BUCKETS && length < (int)sizeof( line ) - 32; b++ ) {
+			if( entry->buckets[b] > 0 ) {
+				length += snprintf( line + length, sizeof( line ) - length, " %llu:%llu",
+						(unsigned long long)1 << b, (unsigned long long)entry->buckets[b] );
+			}
+		}
+		line[length++] = '\n';
+		writeFd( fd, line, length );
+	}
+}
+
+/**
+ * @brief Dump the stats to the configured destination.
+ */
+static void writeStats() {
+	if( strcmp( statsFilename, "stderr" ) == 0 ) {
+		dumpStats( 2 );
+		return;
+	}
+	int fd = openFd( statsFilename );
+	if( fd < 0 ) {
+		return;
+	}
+	dumpStats( fd );
+	closeFd( fd );
+}
+
+#if !defined(_WIN32) && !defined(_WIN64)
+/**
+ * @brief Dump the stats when SIGUSR1 arrives, without stopping the program.
+ *
+ * @param signalNumber The signal number.
+ */
+static void dumpOnSignal( int signalNumber ) {
+	(void)signalNumber;
+	writeStats();
+}
+#endif
+
+/**
+ * @brief Dump the stats when the program exits and, where supported, on SIGUSR1.
+ *
+ * @param destination "stderr", or the name of a file the stats are appended to; NULL or empty disables the dump.
+ */
+void initStats( const char* destination ) {
+	if( destination == NULL || destination[0] == '\0' || statsEnabled ) {
+		return;
+	}
+	strncpy( statsFilename, destination, sizeof( statsFilename ) - 1 );
+	statsEnabled = true;
+	atexit( writeStats );
+	#if !defined(_WIN32) && !defined(_WIN64)
+	struct sigaction action;
+	memset( &action, 0, sizeof( action ) );
+	action.sa_handler = dumpOnSignal;
+	action.sa_flags = SA_RESTART;
+	sigaction( SIGUSR1, &action, NULL );
+	#endif
+}
@@ -0,0 +1,89 @@
+/**
+ * @file include/stats.h
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+
+#define STATS_BUCKETS 32
+
+/**
+ * @brief Instrumented entry points.
+ */
+typedef enum {
+	STAT_OTHER,
+	STAT_VIEW_SHOWS,
+	STAT_BUY,
+	STAT_CANCEL,
+	STAT_LIST_TICKETS,
+	STAT_LOGIN,
+	STAT_REGISTER,
+	STAT_LOAD,
+	STAT_SAVE,
+	STAT_JOURNAL,
+	STAT_REPORT,
+	STAT_OPERATIONS
+} StatOperation;
+
+/**
+ * @brief A running measurement of one call of an entry point.
+ *
+ * Timers nest: I/O is counted against the innermost running timer of the thread.
+ */
+typedef struct {
+	StatOperation operation;
+	StatOperation outer;
+	uint64_t start;
+} StatTimer;
+
+/**
+ * @brief Start timing a call of an entry point.
+ *
+ * @param timer The timer.
+ * @param operation The entry point.
+ */
+void startTimer( StatTimer* timer, StatOperation operation );
+
+/**
+ * @brief Stop a timer and record the call in the counters and latency histogram of its entry point.
+ *
+ * @param timer The timer.
+ */
+void stopTimer( StatTimer* timer );
+
+/**
+ * @brief Count a file opened by the running entry point.
+ */
+void countFileOpen();
+
+/**
+ * @brief Count bytes read by the running entry point.
+ *
+ * @param bytes Number of bytes.
+ */
+void countBytesRead( uint64_t bytes );
+
+/**
+ * @brief Count bytes written by the running entry point.
+ *
+ * @param bytes Number of bytes.
+ */
+void countBytesWritten( uint64_t bytes );
+
+/**
+ * @brief Write the counters and histograms of every entry point.
+ *
+ * @param fd File descriptor to write to.
+ */
+void dumpStats( int fd );
+
+/**
+ * @brief Dump the stats when the program exits and, where supported, on SIGUSR1.
+ *
+ * @param destination "stderr", or the name of a file the stats are appended to; NULL or empty disables the dump.
+ */
+void initStats( const char* destination );
+
+#endif // STATS_H
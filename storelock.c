@@ -0,0 +1,79 @@
+/**
+ * @file src/storelock.c
+ */
+
+#include "../include/storelock.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+
+#include <windows.h>
+
+static SRWLOCK storeLock = SRWLOCK_INIT;
+
+/**
+ * @brief Take the store lock exclusively, to change shows and tickets.
+ *
+ * When a show lock is needed too, it is taken first.
+ */
+void lockStore() {
+	AcquireSRWLockExclusive( &storeLock );
+}
+
+/**
+ * @brief Release the store lock taken by lockStore().
+ */
+void unlockStore() {
+	ReleaseSRWLockExclusive( &storeLock );
+}
+
+/**
+ * @brief Take the store lock for reading shows and tickets while other threads may be booking.
+ */
+void lockStoreForReading() {
+	AcquireSRWLockShared( &storeLock );
+}
+
+/**
+ * @brief Release the store lock taken by lockStoreForReading().
+ */
+void unlockStoreForReading() {
+	ReleaseSRWLockShared( &storeLock );
+}
+
+#else
+
+#include <pthread.h>
+
+static pthread_rwlock_t storeLock = PTHREAD_RWLOCK_INITIALIZER;
+
+/**
+ * @brief Take the store lock exclusively, to change shows and tickets.
+ *
+ * When a show lock is needed too, it is taken first.
+ */
+void lockStore() {
+	pthread_rwlock_wrlock( &storeLock );
+}
+
+/**
+ * @brief Release the store lock taken by lockStore().
+ */
+void unlockStore() {
+	pthread_rwlock_unlock( &storeLock );
+}
+
+/**
+ * @brief Take the store lock for reading shows and tickets while other threads may be booking.
+ */
+void lockStoreForReading() {
+	pthread_rwlock_rdlock( &storeLock );
+}
+
+/**
+ * @brief Release the store lock taken by lockStoreForReading().
+ */
+void unlockStoreForReading() {
+	pthread_rwlock_unlock( &storeLock );
+}
+
+#endif
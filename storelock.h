@@ -0,0 +1,30 @@
+/**
+ * @file include/storelock.h
+ */
+
+#ifndef STORELOCK_H
+#define STORELOCK_H
+
+/**
+ * @brief Take the store lock exclusively, to change shows and tickets.
+ *
+ * When a show lock is needed too, it is taken first.
+ */
+void lockStore();
+
+/**
+ * @brief Release the store lock taken by lockStore().
+ */
+void unlockStore();
+
+/**
+ * @brief Take the store lock for reading shows and tickets while other threads may be booking.
+ */
+void lockStoreForReading();
+
+/**
+ * @brief Release the store lock taken by lockStoreForReading().
+ */
+void unlockStoreForReading();
+
+#endif // STORELOCK_H
@@ -0,0 +1,179 @@
+/**
+ * @file src/strpool.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "../include/strpool.h"
+#include "../include/arena.h"
+
+#define INITIAL_INTERN_CAPACITY 1024
+
+static Arena pool;
+static bool poolReady = false;
+static StrId* internSlots = NULL;
+static uint32_t* internHashes = NULL;
+static size_t internCapacity = 0;
+static size_t numInterned = 0;
+
+/**
+ * @brief Prepare the pool on first use; the first string stored is "" so that EMPTY_STRING resolves to it.
+ *
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+static int preparePool() {
+	if( poolReady ) {
+		return 0;
+	}
+	arenaInit( &pool );
+	uint32_t ref;
+	char* empty = arenaAllocRef( &pool, 1, &ref );
+	if( empty == NULL ) {
+		return -1;
+	}
+	empty[0] = '\0';
+	poolReady = true;
+	return 0;
+}
+
+/**
+ * @brief FNV-1a hash of a string.
+ *
+ * @param text The characters of the string.
+ * @param length Number of characters.
+ * @return The hash.
+ */
+static uint32_t hashString( const char* text, size_t length ) {
+	uint32_t hash = 2166136261u;
+	for( size_t i = 0; i < length; i++ ) {
+		hash ^= (unsigned char)text[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/**
+ * @brief Double the intern table and re-insert every interned handle.
+ *
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+static int growInternTable() {
+	size_t newCapacity = internCapacity > 0 ? internCapacity * 2 : INITIAL_INTERN_CAPACITY;
+	StrId* slots = calloc( newCapacity, sizeof( StrId ) );
+	uint32_t* hashes = calloc( newCapacity, sizeof( uint32_t ) );
+	if( slots == NULL || hashes == NULL ) {
+		free( slots );
+		free( hashes );
+		return -1;
+	}
+	for( size_t i = 0; i < internCapacity; i++ ) {
+		if( internSlots[i] == 0 ) {
+			continue;
+		}
+		size_t slot = internHashes[i] & ( newCapacity - 1 );
+		while( slots[slot] != 0 ) {
+			slot = ( slot + 1 ) & ( newCapacity - 1 );
+		}
+		slots[slot] = internSlots[i];
+		hashes[slot] = internHashes[i];
+	}
+	free( internSlots );
+	free( internHashes );
+	internSlots = slots;
+	internHashes = hashes;
+	internCapacity = newCapacity;
+	return 0;
+}
+
+/**
+ * @brief Store a string in the pool, reusing the existing copy if the same string was interned before.
+ *
+ * Use for columns whose values repeat, such as venues, types and payment methods.
+ *
+ * @param text The characters of the string.
+ * @param length Number of characters.
+ * @return Handle of the string.
+ */
+StrId internString( const char* text, size_t length ) {
+	if( length == 0 ) {
+		return EMPTY_STRING;
+	}
+	if( ( numInterned + 1 ) * 2 > internCapacity && growInternTable() != 0 ) {
+		return storeString( text, length );
+	}
+	uint32_t hash = hashString( text, length );
+	size_t slot = hash & ( internCapacity - 1 );
+	while( internSlots[slot] != 0 ) {
+		if( internHashes[slot] == hash ) {
+			const char* existing = getString( internSlots[slot] );
+			if( strncmp( existing, text, length ) == 0 && existing[length] == '\0' ) {
+				return internSlots[slot];
+			}
+		}
+		slot = ( slot + 1 ) & ( internCapacity - 1 );
+	}
+	StrId id = storeString( text, length );
+	if( id != EMPTY_STRING ) {
+		internSlots[slot] = id;
+		internHashes[slot] = hash;
+		numInterned++;
+	}
+	return id;
+}
+
+/**
+ * @brief Store a string in the pool without looking for an existing copy.
+ *
+ * Use for columns whose values are unique, such as ticket numbers.
+ *
+ * @param text The characters of the string.
+ * @param length Number of characters.
+ * @return Handle of the string.
+ */
+StrId storeString( const char* text, size_t length ) {
+	if( length == 0 || preparePool() != 0 ) {
+		return EMPTY_STRING;
+	}
+	if( length >= ARENA_CHUNK_SIZE ) {
+		length = ARENA_CHUNK_SIZE - 1;
+	}
+	uint32_t ref;
+	char* copy = arenaAllocRef( &pool, length + 1, &ref );
+	if( copy == NULL ) {
+		return EMPTY_STRING;
+	}
+	memcpy( copy, text, length );
+	copy[length] = '\0';
+	return ref;
+}
+
+/**
+ * @brief Get the characters of a pooled string.
+ *
+ * @param id Handle of the string.
+ * @return The null-terminated string.
+ */
+const char* getString( StrId id ) {
+	if( !poolReady ) {
+		return "";
+	}
+	return arenaDeref( &pool, id );
+}
+
+/**
+ * @brief Release every pooled string at once.
+ */
+void freeStrings() {
+	if( poolReady ) {
+		arenaFree( &pool );
+		poolReady = false;
+	}
+	free( internSlots );
+	free( internHashes );
+	internSlots = NULL;
+	internHashes = NULL;
+	internCapacity = 0;
+	numInterned = 0;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file include/strpool.h
+ */
+
+#ifndef STRPOOL_H
+#define STRPOOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Handle of a string stored in the string pool.
+ *
+ * Handles are 4 bytes and stay valid until freeStrings(). The handle EMPTY_STRING always refers to "".
+ */
+typedef uint32_t StrId;
+
+#define EMPTY_STRING 0
+
+/**
+ * @brief Store a string in the pool, reusing the existing copy if the same string was interned before.
+ *
+ * Use for columns whose values repeat, such as venues, types and payment methods.
+ *
+ * @param text The characters of the string.
+ * @param length Number of characters.
+ * @return Handle of the string.
+ */
+StrId internString( const char* text, size_t length );
+
+/**
+ * @brief Store a string in the pool without looking for an existing copy.
+ *
+ * Use for columns whose values are unique, such as ticket numbers.
+ *
+ * @param text The characters of the string.
+ * @param length Number of characters.
+ * @return Handle of the string.
+ */
+StrId storeString( const char* text, size_t length );
+
+/**
+ * @brief Get the characters of a pooled string.
+ *
+ * @param id Handle of the string.
+ * @return The null-terminated string.
+ */
+const char* getString( StrId id );
+
+/**
+ * @brief Release every pooled string at once.
+ */
+void freeStrings();
+
+#endif // STRPOOL_H
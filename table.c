@@ -0,0 +1,95 @@
+/**
+ * @file src/table.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/table.h"
+
+#define INITIAL_SEGMENT_CAPACITY 16
+
+/**
+ * @brief Double the segment directory of a table.
+ *
+ * The old directory stays in the arena, so a reader that still holds it sees valid segments.
+ *
+ * @param table The table.
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+static int growDirectory( Table* table ) {
+	int newCapacity = table->segmentCapacity > 0 ? table->segmentCapacity * 2 : INITIAL_SEGMENT_CAPACITY;
+	char** segments = arenaAlloc( &table->arena, sizeof( char* ) * newCapacity );
+	if( segments == NULL ) {
+		return -1;
+	}
+	if( table->numSegments > 0 ) {
+		memcpy( segments, table->segments, sizeof( char* ) * table->numSegments );
+	}
+	table->segments = segments;
+	table->segmentCapacity = newCapacity;
+	return 0;
+}
+
+/**
+ * @brief Initialize an empty table.
+ *
+ * @param table The table.
+ * @param itemSize Size of one record in bytes.
+ */
+void tableInit( Table* table, size_t itemSize ) {
+	arenaInit( &table->arena );
+	table->segments = NULL;
+	table->numSegments = 0;
+	table->segmentCapacity = 0;
+	table->itemSize = itemSize;
+	table->count = 0;
+}
+
+/**
+ * @brief Append a zero-filled record to a table.
+ *
+ * @param table The table.
+ * @return Pointer to the new record, or NULL if memory could not be allocated.
+ */
+void* tableAppend( Table* table ) {
+	int segment = table->count >> TABLE_SEGMENT_BITS;
+	if( segment == table->numSegments ) {
+		if( table->numSegments == table->segmentCapacity && growDirectory( table ) != 0 ) {
+			return NULL;
+		}
+		char* items = arenaAlloc( &table->arena, table->itemSize * TABLE_SEGMENT_ITEMS );
+		if( items == NULL ) {
+			return NULL;
+		}
+		table->segments[table->numSegments++] = items;
+	}
+	char* item = table->segments[segment] + table->itemSize * ( table->count & ( TABLE_SEGMENT_ITEMS - 1 ) );
+	memset( item, 0, table->itemSize );
+	table->count++;
+	return item;
+}
+
+/**
+ * @brief Get a record by its position.
+ *
+ * @param table The table.
+ * @param index Position of the record.
+ * @return Pointer to the record, or NULL if the index is out of range.
+ */
+void* tableAt( const Table* table, int index ) {
+	if( index < 0 || index >= table->count ) {
+		return NULL;
+	}
+	return table->segments[index >> TABLE_SEGMENT_BITS] + table->itemSize * ( index & ( TABLE_SEGMENT_ITEMS - 1 ) );
+}
+
+/**
+ * @brief Release every record of a table at once.
+ *
+ * @param table The table, left empty and ready for reuse.
+ */
+void tableFree( Table* table ) {
+	arenaFree( &table->arena );
+	tableInit( table, table->itemSize );
+}
@@ -0,0 +1,62 @@
+/**
+ * @file include/table.h
+ */
+
+#ifndef TABLE_H
+#define TABLE_H
+
+#include <stddef.h>
+#include "arena.h"
+
+#define TABLE_SEGMENT_BITS 10
+#define TABLE_SEGMENT_ITEMS ( 1 << TABLE_SEGMENT_BITS )
+
+/**
+ * @brief Growable table of fixed-size records backed by an arena.
+ *
+ * Records live in segments of TABLE_SEGMENT_ITEMS records each. Appending never moves existing records, so
+ * pointers returned by tableAt() stay valid until tableFree(), and every append is O(1). All memory of a table is
+ * released at once by tableFree().
+ */
+typedef struct {
+	Arena arena;
+	char** segments;
+	int numSegments;
+	int segmentCapacity;
+	size_t itemSize;
+	int count;
+} Table;
+
+/**
+ * @brief Initialize an empty table.
+ *
+ * @param table The table.
+ * @param itemSize Size of one record in bytes.
+ */
+void tableInit( Table* table, size_t itemSize );
+
+/**
+ * @brief Append a zero-filled record to a table.
+ *
+ * @param table The table.
+ * @return Pointer to the new record, or NULL if memory could not be allocated.
+ */
+void* tableAppend( Table* table );
+
+/**
+ * @brief Get a record by its position.
+ *
+ * @param table The table.
+ * @param index Position of the record.
+ * @return Pointer to the record, or NULL if the index is out of range.
+ */
+void* tableAt( const Table* table, int index );
+
+/**
+ * @brief Release every record of a table at once.
+ *
+ * @param table The table, left empty and ready for reuse.
+ */
+void tableFree( Table* table );
+
+#endif // TABLE_H
@@ -0,0 +1,1429 @@
+/**
+ * @file src/tickets.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "../include/tickets.h"
+#include "../include/catalog.h"
+#include "../include/table.h"
+#include "../include/intmap.h"
+#include "../include/datafile.h"
+#include "../include/snapshot.h"
+#include "../include/stats.h"
+#include "../include/journal.h"
+#include "../include/storelock.h"
+
+#include <errno.h>
+#include <sys/stat.h>
+
+#if defined(_WIN32) || defined(_WIN64)
+	#include <windows.h>
+	#include <io.h>
+	#include <fcntl.h>
+	#include <direct.h>
+	#define makeDirectory( path ) _mkdir( path )
+	#define TICKETS_THREAD_LOCAL __declspec( thread )
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#define makeDirectory( path ) mkdir( path, 0755 )
+	#define TICKETS_THREAD_LOCAL __thread
+#endif
+
+#define COMPACT_MIN_RECORDS 1024
+#define MAX_PENDING_STATUSES 16
+#define MANIFEST_NAME "manifest.txt"
+#define MANIFEST_HEADER "file|first_show|last_show|tickets\n"
+
+#define TICKETS_HEADER "id|ticket_number|user_id|show_id|seat_number|payment_method|payment_account|transaction_number|status\n"
+#define TICKET_FORMAT "%d|%s|%d|%d|%d|%s|%s|%s|%d\n"
+#define PURCHASE_RECORD_LENGTH ( MAX_LENGTH * 5 )
+
+/**
+ * @brief Tickets of one user, linked through nextUserTickets.
+ */
+typedef struct {
+	int first;
+	int last;
+	int count;
+} UserTickets;
+
+static Table storeTickets = { .itemSize = sizeof( Ticket ) };
+static Table nextUserTickets = { .itemSize = sizeof( int ) };
+static Table userTickets = { .itemSize = sizeof( UserTickets ) };
+static Table statusOffsets = { .itemSize = sizeof( int64_t ) };
+static Table showIdColumn = { .itemSize = sizeof( int32_t ) };
+static Table statusColumn = { .itemSize = sizeof( uint8_t ) };
+static Table methodColumn = { .itemSize = sizeof( uint8_t ) };
+static StrId paymentMethods[MAX_PAYMENT_METHODS];
+static int numPaymentMethods = 0;
+static bool otherPaymentMethods = false;
+static IntMap userIndex;
+static IntMap ticketIdIndex;
+static IntMap ticketNumberIndex;
+static int nextTicketId = 0;
+static char ticketsFilename[MAX_LENGTH] = "";
+static char ticketsJournalFilename[MAX_LENGTH] = "";
+static bool journalOpen = false;
+static int journalRecords = 0;
+static uint64_t journalLength = 0;
+static bool snapshotCurrent = false;
+static bool snapshotMatchesDatabase = false;
+static bool inPlaceUpdates = false;
+static bool compactionDue = false;
+static Table segmentFds = { .itemSize = sizeof( int ) };
+static char segmentDirectory[MAX_LENGTH] = "";
+static char manifestFilename[MAX_LENGTH + 16] = "";
+// tickets whose status the calling thread changed and still has to write to their segments; see commitTickets()
+static TICKETS_THREAD_LOCAL int pendingStatuses[MAX_PENDING_STATUSES];
+static TICKETS_THREAD_LOCAL int numPendingStatuses = 0;
+
+/**
+ * @brief Row of a ticket in the ticket snapshot; strings are heap offsets.
+ */
+typedef struct {
+	int32_t id;
+	int32_t userId;
+	int32_t showId;
+	int32_t seatNumber;
+	int32_t status;
+	uint32_t ticketNumber;
+	uint32_t paymentMethod;
+	uint32_t paymentAccount;
+	uint32_t transactionNumber;
+	uint32_t reserved;
+	int64_t statusOffset;
+} TicketRecord;
+
+/**
+ * @brief Parse the fields of a ticket row in the tickets database format.
+ *
+ * @param fields The nine fields of the row.
+ * @param ticket The ticket to fill in.
+ * @return true if all fields were valid.
+ */
+static bool parseTicket( const StrView fields[], Ticket* ticket ) {
+	if( !parseViewInt( fields[0], &( ticket->id ) ) || !parseViewInt( fields[2], &( ticket->userId ) ) ||
+			!parseViewInt( fields[3], &( ticket->showId ) ) || !parseViewInt( fields[4], &( ticket->seatNumber ) ) ||
+			!parseViewInt( fields[8], &( ticket->status ) ) ) {
+		return false;
+	}
+	ticket->ticketNumber = storeString( fields[1].text, fields[1].length );
+	ticket->paymentMethod = internString( fields[5].text, fields[5].length );
+	ticket->paymentAccount = internString( fields[6].text, fields[6].length );
+	ticket->transactionNumber = internString( fields[7].text, fields[7].length );
+	return true;
+}
+
+/**
+ * @brief Mark the seat of a ticket as booked or free in the catalog.
+ *
+ * @param ticket The ticket.
+ */
+static void applySeat( const Ticket* ticket ) {
+	Show* show = getShowById( ticket->showId );
+	if( show == NULL ) {
+		return;
+	}
+	setSeatBooked( show, ticket->seatNumber, ticket->status != 0 );
+}
+
+/**
+ * @brief Find the position of a ticket by its ID.
+ *
+ * @param ticketId The ID of the ticket.
+ * @return The position, or -1 if no ticket has that ID.
+ */
+static int findTicket( int ticketId ) {
+	int index;
+	if( !intMapGet( &ticketIdIndex, (uint64_t)(uint32_t)ticketId, &index ) ) {
+		return -1;
+	}
+	return index;
+}
+
+/**
+ * @brief Compute the index key of a ticket number.
+ *
+ * Ticket numbers of up to 12 letters and digits (such as AAA00000A) are packed in base 37 into a key below 2^63
+ * that identifies them exactly; letters are case-insensitive. Any other string is hashed into a key with the top
+ * bit set and the lowest bit clear, which can neither equal a packed key nor INTMAP_EMPTY_KEY; a match on such a
+ * key must be confirmed against the stored ticket number.
+ *
+ * @param ticketNumber The ticket number.
+ * @param exact Pointer to store whether the key identifies the ticket number exactly.
+ * @return The key.
+ */
+static uint64_t ticketNumberKey( const char* ticketNumber, bool* exact ) {
+	uint64_t key = 0;
+	size_t length = 0;
+	*exact = true;
+	for( ; ticketNumber[length] != '\0'; length++ ) {
+		char c = ticketNumber[length];
+		int digit;
+		if( c >= '0' && c <= '9' ) {
+			digit = 1 + ( c - '0' );
+		} else if( c >= 'A' && c <= 'Z' ) {
+			digit = 11 + ( c - 'A' );
+		} else if( c >= 'a' && c <= 'z' ) {
+			digit = 11 + ( c - 'a' );
+		} else {
+			*exact = false;
+			break;
+		}
+		if( length >= 12 ) {
+			*exact = false;
+			break;
+		}
+		key = key * 37 + digit;
+	}
+	if( *exact ) {
+		return key;
+	}
+	key = 14695981039346656037ULL;
+	for( size_t i = 0; ticketNumber[i] != '\0'; i++ ) {
+		key ^= (unsigned char)ticketNumber[i];
+		key *= 1099511628211ULL;
+	}
+	return ( key | ( 1ULL << 63 ) ) & ~1ULL;
+}
+
+/**
+ * @brief Link the ticket at a position to the end of its user's ticket list.
+ *
+ * @param index Position of the ticket.
+ * @param userId The ID of the user who bought it.
+ * @return 0 on success, -1 if memory could not be allocated, in which case the lists are left unchanged.
+ */
+static int linkUserTicket( int index, int userId ) {
+	int* next = tableAppend( &nextUserTickets );
+	if( next == NULL ) {
+		return -1;
+	}
+	*next = -1;
+	int listIndex;
+	if( intMapGet( &userIndex, (uint64_t)(uint32_t)userId, &listIndex ) ) {
+		UserTickets* list = tableAt( &userTickets, listIndex );
+		*(int*)tableAt( &nextUserTickets, list->last ) = index;
+		list->last = index;
+		list->count++;
+		return 0;
+	}
+	UserTickets* list = tableAppend( &userTickets );
+	if( list == NULL || intMapPut( &userIndex, (uint64_t)(uint32_t)userId, userTickets.count - 1 ) != 0 ) {
+		if( list != NULL ) {
+			userTickets.count--;
+		}
+		nextUserTickets.count--;
+		return -1;
+	}
+	list->first = index;
+	list->last = index;
+	list->count = 1;
+	return 0;
+}
+
+/**
+ * @brief Get the code of a payment method, assigning the next code to a method not seen before.
+ *
+ * @param method The payment method.
+ * @return The code; methods beyond the first MAX_PAYMENT_METHODS - 1 share the last code.
+ */
+static uint8_t getPaymentMethodCode( StrId method ) {
+	const char* name = getString( method );
+	for( int code = 0; code < numPaymentMethods; code++ ) {
+		if( paymentMethods[code] == method || strcmp( getString( paymentMethods[code] ), name ) == 0 ) {
+			return (uint8_t)code;
+		}
+	}
+	if( numPaymentMethods < MAX_PAYMENT_METHODS - 1 ) {
+		paymentMethods[numPaymentMethods] = method;
+		return (uint8_t)numPaymentMethods++;
+	}
+	otherPaymentMethods = true;
+	return MAX_PAYMENT_METHODS - 1;
+}
+
+/**
+ * @brief Cut the ticket table and its columns back to a number of tickets.
+ *
+ * @param count Number of tickets to keep.
+ */
+static void truncateColumns( int count ) {
+	storeTickets.count = count;
+	statusOffsets.count = count;
+	showIdColumn.count = count;
+	statusColumn.count = count;
+	methodColumn.count = count;
+}
+
+/**
+ * @brief Append a ticket to the store without journaling it.
+ *
+ * Room in the indexes is reserved before anything is appended, so a ticket is either added to every table and index
+ * or, if memory runs out, to none of them.
+ *
+ * @param ticket The ticket.
+ * @param statusOffset Offset of the status digit of its row in the tickets database, or -1 if it has no row there.
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+static int insertTicket( const Ticket* ticket, int64_t statusOffset ) {
+	if( intMapReserve( &ticketIdIndex, ticketIdIndex.count + 1 ) != 0 ||
+			intMapReserve( &ticketNumberIndex, ticketNumberIndex.count + 1 ) != 0 ) {
+		return -1;
+	}
+	int index = storeTickets.count;
+	Ticket* stored = tableAppend( &storeTickets );
+	int64_t* offset = tableAppend( &statusOffsets );
+	int32_t* showId = tableAppend( &showIdColumn );
+	uint8_t* status = tableAppend( &statusColumn );
+	uint8_t* method = tableAppend( &methodColumn );
+	if( stored == NULL || offset == NULL || showId == NULL || status == NULL || method == NULL ||
+			linkUserTicket( index, ticket->userId ) != 0 ) {
+		truncateColumns( index );
+		return -1;
+	}
+	*stored = *ticket;
+	*offset = statusOffset;
+	*showId = ticket->showId;
+	*status = (uint8_t)ticket->status;
+	*method = getPaymentMethodCode( ticket->paymentMethod );
+	bool exact;
+	intMapPut( &ticketIdIndex, (uint64_t)(uint32_t)ticket->id, index );
+	intMapPut( &ticketNumberIndex, ticketNumberKey( getString( ticket->ticketNumber ), &exact ), index );
+	if( ticket->id >= nextTicketId ) {
+		nextTicketId = ticket->id + 1;
+	}
+	return 0;
+}
+
+/**
+ * @brief Take a ticket off the end of its user's ticket list.
+ *
+ * @param index Position of the ticket, the last one in the store.
+ * @param userId The ID of the user who bought it.
+ */
+static void unlinkUserTicket( int index, int userId ) {
+	int listIndex;
+	if( !intMapGet( &userIndex, (uint64_t)(uint32_t)userId, &listIndex ) ) {
+		return;
+	}
+	UserTickets* list = tableAt( &userTickets, listIndex );
+	if( list->count == 1 ) {
+		// lists are appended with their first ticket, so the list of the last ticket alone is the last list
+		intMapRemove( &userIndex, (uint64_t)(uint32_t)userId );
+		userTickets.count--;
+	} else {
+		int previous = list->first;
+		while( getNextUserTicket( previous ) != index ) {
+			previous = getNextUserTicket( previous );
+		}
+		*(int*)tableAt( &nextUserTickets, previous ) = -1;
+		list->last = previous;
+		list->count--;
+	}
+	nextUserTickets.count--;
+}
+
+/**
+ * @brief Take the last ticket added by addTickets() out of the store again and free its seat.
+ */
+static void removeLastTicket() {
+	int index = storeTickets.count - 1;
+	Ticket* ticket = tableAt( &storeTickets, index );
+	if( ticket == NULL ) {
+		return;
+	}
+	bool exact;
+	uint64_t key = ticketNumberKey( getString( ticket->ticketNumber ), &exact );
+	int found;
+	if( intMapGet( &ticketNumberIndex, key, &found ) && found == index ) {
+		intMapRemove( &ticketNumberIndex, key );
+	}
+	intMapRemove( &ticketIdIndex, (uint64_t)(uint32_t)ticket->id );
+	unlinkUserTicket( index, ticket->userId );
+	ticket->status = 0;
+	applySeat( ticket );
+	nextTicketId = ticket->id;
+	truncateColumns( index );
+}
+
+/**
+ * @brief Get the offset of the status digit of a ticket in the tickets database.
+ *
+ * @param index Position of the ticket.
+ * @return The offset, or -1 if the ticket has no row in the database.
+ */
+static int64_t getStatusOffset( int index ) {
+	const int64_t* offset = tableAt( &statusOffsets, index );
+	return offset != NULL ? *offset : -1;
+}
+
+/**
+ * @brief Change the status of a ticket in the store and in its column.
+ *
+ * @param index Position of the ticket.
+ * @param status The new status.
+ */
+static void storeStatus( int index, int status ) {
+	Ticket* ticket = tableAt( &storeTickets, index );
+	uint8_t* column = tableAt( &statusColumn, index );
+	if( ticket != NULL && column != NULL ) {
+		ticket->status = status;
+		*column = (uint8_t)status;
+	}
+}
+
+/**
+ * @brief Mark the row of a ticket in its segment file as out of date.
+ *
+ * The ticket's status is no longer updated in place, since a journal record about it would override the update on
+ * replay, and the next compaction rewrites its segment.
+ *
+ * @param index Position of the ticket.
+ */
+static void detachTicket( int index ) {
+	int64_t* offset = tableAt( &statusOffsets, index );
+	if( offset != NULL ) {
+		*offset = -1;
+	}
+}
+
+/**
+ * @brief Apply the records of the journal to the store.
+ *
+ * Records are applied in order and are idempotent, so a journal that survived a crash during compaction can be
+ * replayed on top of the compacted databases, or on top of snapshots that already reflect part of the journal.
+ * A torn record at the end of the journal is ignored. A ticket of the database that the journal refers to is
+ * detached from its segment, so its status is no longer updated in place until the next compaction.
+ *
+ * @param file The journal, positioned at the first record to apply.
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+static int replayJournal( DataFile* file ) {
+	StrView fields[10];
+	int numFields;
+	while( ( numFields = nextDataRow( file, fields, 10 ) ) >= 0 && file->rowTerminated ) {
+		journalRecords++;
+		if( fields[0].length != 1 ) {
+			continue;
+		}
+		if( fields[0].text[0] == 'P' && numFields == 10 ) {
+			Ticket ticket;
+			if( !parseTicket( fields + 1, &ticket ) ) {
+				continue;
+			}
+			int index = findTicket( ticket.id );
+			if( index < 0 ) {
+				if( insertTicket( &ticket, -1 ) != 0 ) {
+					return -1;
+				}
+				index = storeTickets.count - 1;
+			} else {
+				detachTicket( index );
+			}
+			applySeat( tableAt( &storeTickets, index ) );
+		} else if( fields[0].text[0] == 'S' && numFields == 3 ) {
+			int ticketId, status;
+			if( !parseViewInt( fields[1], &ticketId ) || !parseViewInt( fields[2], &status ) ) {
+				continue;
+			}
+			int index = findTicket( ticketId );
+			Ticket* ticket = tableAt( &storeTickets, index );
+			if( ticket != NULL ) {
+				detachTicket( index );
+				storeStatus( index, status );
+				applySeat( ticket );
+			}
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief Queue records for the journal.
+ *
+ * The records reach the disk with the next group commit; see commitTickets(). Once the journal outgrows the tickets
+ * database the store is marked for compaction, which keeps replay time bounded; compactTicketsWhenDue() runs it
+ * outside the booking path.
+ *
+ * @param record The records, each including its trailing newline.
+ * @param records Number of records.
+ * @return 0 on success, -1 if the journal could not be opened.
+ */
+static int appendJournal( const char* record, int records ) {
+	if( !journalOpen ) {
+		journalOpen = openJournal( ticketsJournalFilename, false ) == 0;
+	}
+	size_t length = strlen( record );
+	if( !journalOpen || appendJournalRecord( record, length ) != 0 ) {
+		return -1;
+	}
+	journalRecords += records;
+	journalLength += length;
+	snapshotCurrent = false;
+	if( journalRecords > COMPACT_MIN_RECORDS && journalRecords > storeTickets.count ) {
+		compactionDue = true;
+	}
+	return 0;
+}
+
+/**
+ * @brief Load the ticket store from its snapshot.
+ *
+ * The snapshot is only used when the catalog was loaded from a snapshot of the same point in the journal, so that
+ * replaying the rest of the journal brings both up to date together.
+ *
+ * @param journalSize Current length of the journal.
+ * @return The number of loaded tickets, or -1 if the snapshot is missing, stale or damaged.
+ */
+static int loadTicketsFromSnapshot( uint64_t journalSize ) {
+	char snapshotName[MAX_LENGTH];
+	getSnapshotFilename( ticketsFilename, snapshotName, sizeof( snapshotName ) );
+	Snapshot snapshot;
+	uint64_t catalogOffset;
+	if( !getCatalogSnapshotOffset( &catalogOffset ) ||
+			openSnapshot( &snapshot, snapshotName, manifestFilename, sizeof( TicketRecord ) ) != 0 ) {
+		return -1;
+	}
+	bool valid = snapshot.header->journalOffset == catalogOffset && snapshot.header->journalOffset <= journalSize &&
+				 intMapReserve( &ticketIdIndex, snapshot.header->rowCount ) == 0 &&
+				 intMapReserve( &ticketNumberIndex, snapshot.header->rowCount ) == 0;
+	for( uint64_t i = 0; valid && i < snapshot.header->rowCount; i++ ) {
+		const TicketRecord* record = getSnapshotRow( &snapshot, i );
+		Ticket ticket;
+		ticket.id = record->id;
+		ticket.userId = record->userId;
+		ticket.showId = record->showId;
+		ticket.seatNumber = record->seatNumber;
+		ticket.status = record->status;
+		valid = loadSnapshotString( &snapshot, record->ticketNumber, false, &ticket.ticketNumber ) &&
+				loadSnapshotString( &snapshot, record->paymentMethod, true, &ticket.paymentMethod ) &&
+				loadSnapshotString( &snapshot, record->paymentAccount, true, &ticket.paymentAccount ) &&
+				loadSnapshotString( &snapshot, record->transactionNumber, true, &ticket.transactionNumber ) &&
+				insertTicket( &ticket, record->statusOffset ) == 0;
+	}
+	journalLength = snapshot.header->journalOffset;
+	journalRecords = (int)snapshot.header->journalRecords;
+	closeSnapshot( &snapshot );
+	if( !valid ) {
+		freeTickets();
+		return -1;
+	}
+	snapshotMatchesDatabase = true;
+	return storeTickets.count;
+}
+
+/**
+ * @brief Write the catalog and the ticket store to their binary snapshots.
+ *
+ * @return 0 on success, -1 if a snapshot could not be written.
+ */
+static int writeSnapshots() {
+	char snapshotName[MAX_LENGTH];
+	getSnapshotFilename( ticketsFilename, snapshotName, sizeof( snapshotName ) );
+	SnapshotWriter writer;
+	if( saveShowsSnapshot( journalLength ) != 0 || beginSnapshot( &writer, snapshotName, sizeof( TicketRecord ) ) != 0 ) {
+		return -1;
+	}
+	for( int i = 0; i < storeTickets.count; i++ ) {
+		const Ticket* ticket = tableAt( &storeTickets, i );
+		TicketRecord record;
+		record.id = ticket->id;
+		record.userId = ticket->userId;
+		record.showId = ticket->showId;
+		record.seatNumber = ticket->seatNumber;
+		record.status = ticket->status;
+		record.ticketNumber = addSnapshotString( &writer, ticket->ticketNumber );
+		record.paymentMethod = addSnapshotString( &writer, ticket->paymentMethod );
+		record.paymentAccount = addSnapshotString( &writer, ticket->paymentAccount );
+		record.transactionNumber = addSnapshotString( &writer, ticket->transactionNumber );
+		record.reserved = 0;
+		record.statusOffset = getStatusOffset( i );
+		writeSnapshotRow( &writer, &record );
+	}
+	if( endSnapshot( &writer, manifestFilename, journalLength, journalRecords ) != 0 ) {
+		return -1;
+	}
+	snapshotCurrent = true;
+	snapshotMatchesDatabase = true;
+	return 0;
+}
+
+/**
+ * @brief Derive the segment directory and manifest names from the name of the tickets database.
+ *
+ * @param filename The name of the tickets database, such as "data/tickets.txt" for the directory "data/tickets".
+ */
+static void setSegmentPaths( const char* filename ) {
+	size_t length = strlen( filename );
+	if( length > 4 && strcmp( filename + length - 4, ".txt" ) == 0 ) {
+		length -= 4;
+	}
+	snprintf( segmentDirectory, sizeof( segmentDirectory ), "%.*s", (int)length, filename );
+	snprintf( manifestFilename, sizeof( manifestFilename ), "%s/" MANIFEST_NAME, segmentDirectory );
+}
+
+/**
+ * @brief Get the segment that holds the tickets of a show.
+ *
+ * @param showId The ID of the show.
+ * @return The segment number.
+ */
+static int getSegment( int showId ) {
+	return showId >= 0 ? showId / SHOWS_PER_SEGMENT : 0;
+}
+
+/**
+ * @brief Get the name of a segment file.
+ *
+ * @param segment The segment number.
+ * @param name Buffer to store the name in.
+ * @param size Size of the buffer.
+ * @param withDirectory true to prefix the segment directory.
+ */
+static void getSegmentFilename( int segment, char* name, size_t size, bool withDirectory ) {
+	snprintf( name, size, "%s%sshows-%d-%d.txt", withDirectory ? segmentDirectory : "", withDirectory ? "/" : "",
+			  segment * SHOWS_PER_SEGMENT, segment * SHOWS_PER_SEGMENT + SHOWS_PER_SEGMENT - 1 );
+}
+
+/**
+ * @brief Position in a segment file while segments are merged.
+ */
+typedef struct {
+	DataFile file;
+	Ticket ticket;
+	int64_t statusOffset;
+} SegmentCursor;
+
+/**
+ * @brief Read the next ticket of a segment file.
+ *
+ * @param cursor The cursor.
+ * @return true if a ticket was read, false at the end of the file.
+ */
+static bool advanceCursor( SegmentCursor* cursor ) {
+	StrView fields[9];
+	int numFields;
+	while( ( numFields = nextDataRow( &cursor->file, fields, 9 ) ) >= 0 ) {
+		if( numFields == 9 && parseTicket( fields, &cursor->ticket ) ) {
+			cursor->statusOffset = fields[8].length == 1 ? (int64_t)( fields[8].text - cursor->file.data ) : -1;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Restore the heap order of merge cursors below a position.
+ *
+ * @param cursors The cursors.
+ * @param heap Cursor numbers ordered as a min-heap on the ID of their current ticket.
+ * @param count Number of cursors in the heap.
+ * @param position Position to sift down from.
+ */
+static void siftCursor( const Table* cursors, int heap[], int count, int position ) {
+	for( ;; ) {
+		int smallest = position;
+		for( int child = 2 * position + 1; child <= 2 * position + 2 && child < count; child++ ) {
+			const SegmentCursor* a = tableAt( cursors, heap[child] );
+			const SegmentCursor* b = tableAt( cursors, heap[smallest] );
+			if( a->ticket.id < b->ticket.id ) {
+				smallest = child;
+			}
+		}
+		if( smallest == position ) {
+			return;
+		}
+		int swap = heap[position];
+		heap[position] = heap[smallest];
+		heap[smallest] = swap;
+		position = smallest;
+	}
+}
+
+/**
+ * @brief Load the segment files listed in the manifest into the store.
+ *
+ * Each segment is sorted by ticket ID, so the segments are merged to insert the tickets in purchase order.
+ *
+ * @return 0 on success, -1 if the manifest or a segment could not be read.
+ */
+static int loadSegments() {
+	DataFile manifest;
+	if( openDataFile( &manifest, manifestFilename ) != 0 ) {
+		return -1;
+	}
+	Table cursors;
+	tableInit( &cursors, sizeof( SegmentCursor ) );
+	int result = 0;
+	StrView fields[4];
+	int numFields;
+	nextDataRow( &manifest, fields, 4 );
+	while( result == 0 && ( numFields = nextDataRow( &manifest, fields, 4 ) ) >= 0 ) {
+		if( numFields != 4 ) {
+			continue;
+		}
+		char name[MAX_LENGTH * 2];
+		snprintf( name, sizeof( name ), "%s/%.*s", segmentDirectory, (int)fields[0].length, fields[0].text );
+		SegmentCursor* cursor = tableAppend( &cursors );
+		if( cursor == NULL || openDataFile( &cursor->file, name ) != 0 ) {
+			if( cursor != NULL ) {
+				cursors.count--;
+			}
+			result = -1;
+		}
+	}
+	closeDataFile( &manifest );
+	int* heap = malloc( sizeof( int ) * ( cursors.count + 1 ) );
+	int count = 0;
+	for( int i = 0; heap != NULL && result == 0 && i < cursors.count; i++ ) {
+		if( advanceCursor( tableAt( &cursors, i ) ) ) {
+			heap[count++] = i;
+		}
+	}
+	for( int i = count / 2 - 1; i >= 0; i-- ) {
+		siftCursor( &cursors, heap, count, i );
+	}
+	while( heap != NULL && result == 0 && count > 0 ) {
+		SegmentCursor* cursor = tableAt( &cursors, heap[0] );
+		if( insertTicket( &cursor->ticket, cursor->statusOffset ) != 0 ) {
+			result = -1;
+		} else if( !advanceCursor( cursor ) ) {
+			heap[0] = heap[--count];
+		}
+		siftCursor( &cursors, heap, count, 0 );
+	}
+	for( int i = 0; i < cursors.count; i++ ) {
+		closeDataFile( &( (SegmentCursor*)tableAt( &cursors, i ) )->file );
+	}
+	tableFree( &cursors );
+	free( heap );
+	return heap != NULL ? result : -1;
+}
+
+/**
+ * @brief Load the tickets of a tickets database from before it was split into segments.
+ *
+ * @param filename The name of the tickets database file.
+ * @return 0 on success, -1 if the file could not be read or memory could not be allocated.
+ */
+static int loadSingleDatabase( const char* filename ) {
+	DataFile file;
+	if( openDataFile( &file, filename ) != 0 ) {
+		return -1;
+	}
+	int result = 0;
+	StrView fields[9];
+	int numFields;
+	nextDataRow( &file, fields, 9 );
+	while( result == 0 && ( numFields = nextDataRow( &file, fields, 9 ) ) >= 0 ) {
+		Ticket ticket;
+		if( numFields == 9 && parseTicket( fields, &ticket ) && insertTicket( &ticket, -1 ) != 0 ) {
+			result = -1;
+		}
+	}
+	closeDataFile( &file );
+	return result;
+}
+
+/**
+ * @brief Load all tickets into the resident ticket store and replay the journal.
+ *
+ * The tickets database holds the state as of the last compaction, split into one segment file per range of
+ * SHOWS_PER_SEGMENT shows and listed by a manifest; every purchase and status change since then is a record in the
+ * journal. Replaying the journal also re-applies its seat changes to the catalog, so the catalog must be loaded
+ * first. When the catalog and ticket snapshots are current they are mapped instead of parsing the segments, and
+ * only the journal records written after them are replayed. A single-file database from before segments existed
+ * is split into segments and removed.
+ *
+ * @param filename The name of the tickets database file; the segments live in the directory of the same name
+ *                 without the ".txt" extension.
+ * @param journalFilename The name of the ticket journal file.
+ * @return The number of loaded tickets, or -1 if the tickets database or journal could not be read.
+ */
+int loadTicketsFromFile( const char* filename, const char* journalFilename ) {
+	freeTickets();
+	strncpy( ticketsFilename, filename, sizeof( ticketsFilename ) - 1 );
+	strncpy( ticketsJournalFilename, journalFilename, sizeof( ticketsJournalFilename ) - 1 );
+	setSegmentPaths( filename );
+	StatTimer timer;
+	startTimer( &timer, STAT_LOAD );
+	DataFile journalFile;
+	bool haveJournal = openDataFile( &journalFile, ticketsJournalFilename ) == 0;
+	bool split = false;
+	if( loadTicketsFromSnapshot( haveJournal ? journalFile.size : 0 ) >= 0 ) {
+		snapshotCurrent = !haveJournal || journalFile.size == journalLength;
+	} else {
+		if( loadSegments() != 0 ) {
+			freeTickets();
+			if( loadSingleDatabase( filename ) != 0 ) {
+				freeTickets();
+				if( haveJournal ) {
+					closeDataFile( &journalFile );
+				}
+				stopTimer( &timer );
+				return -1;
+			}
+			split = true;
+		}
+		// statuses are updated in place, while the seats in the shows database are only rewritten by compaction
+		for( int i = 0; i < storeTickets.count; i++ ) {
+			applySeat( tableAt( &storeTickets, i ) );
+		}
+	}
+	inPlaceUpdates = true;
+	if( haveJournal ) {
+		journalFile.position = journalLength;
+		int replayed = replayJournal( &journalFile );
+		journalLength = journalFile.size;
+		closeDataFile( &journalFile );
+		if( replayed != 0 ) {
+			freeTickets();
+			stopTimer( &timer );
+			return -1;
+		}
+	}
+	if( split && compactTickets() == 0 ) {
+		remove( filename );
+	}
+	stopTimer( &timer );
+	return storeTickets.count;
+}
+
+/**
+ * @brief Close the segment files opened for status updates.
+ */
+static void closeSegments() {
+	for( int i = 0; i < segmentFds.count; i++ ) {
+		int fd = *(int*)tableAt( &segmentFds, i );
+		if( fd >= 0 ) {
+			#if defined(_WIN32) || defined(_WIN64)
+			_close( fd );
+			#else
+			close( fd );
+			#endif
+		}
+	}
+	tableFree( &segmentFds );
+}
+
+/**
+ * @brief Open a segment file for status updates, or reuse the descriptor opened before.
+ *
+ * @param segment The segment number.
+ * @return The file descriptor, or -1 if the file could not be opened.
+ */
+static int openSegment( int segment ) {
+	while( segmentFds.count <= segment ) {
+		int* fd = tableAppend( &segmentFds );
+		if( fd == NULL ) {
+			return -1;
+		}
+		*fd = -1;
+	}
+	int* fd = tableAt( &segmentFds, segment );
+	if( *fd < 0 ) {
+		char name[MAX_LENGTH * 2];
+		getSegmentFilename( segment, name, sizeof( name ), true );
+		#if defined(_WIN32) || defined(_WIN64)
+		*fd = _open( name, _O_WRONLY | _O_BINARY );
+		#else
+		*fd = open( name, O_WRONLY );
+		#endif
+		if( *fd >= 0 ) {
+			countFileOpen();
+		}
+	}
+	return *fd;
+}
+
+/**
+ * @brief Remove the ticket snapshot before the first status is written in place, since it no longer matches the
+ * segments.
+ */
+static void retireDatabaseSnapshot() {
+	if( snapshotMatchesDatabase ) {
+		char snapshotName[MAX_LENGTH];
+		getSnapshotFilename( ticketsFilename, snapshotName, sizeof( snapshotName ) );
+		remove( snapshotName );
+		snapshotMatchesDatabase = false;
+	}
+	snapshotCurrent = false;
+}
+
+/**
+ * @brief Overwrite one byte of a file at an offset without moving a shared file position.
+ *
+ * @param fd The file descriptor.
+ * @param offset The offset.
+ * @param digit The byte.
+ * @return true if the byte was written.
+ */
+static bool writeByteAt( int fd, int64_t offset, char digit ) {
+	#if defined(_WIN32) || defined(_WIN64)
+	OVERLAPPED position = { 0 };
+	position.Offset = (DWORD)offset;
+	position.OffsetHigh = (DWORD)( (uint64_t)offset >> 32 );
+	DWORD written = 0;
+	return WriteFile( (HANDLE)_get_osfhandle( fd ), &digit, 1, &written, &position ) && written == 1;
+	#else
+	return pwrite( fd, &digit, 1, (off_t)offset ) == 1;
+	#endif
+}
+
+/**
+ * @brief Write the current status digits of the tickets queued by the calling thread to their segments.
+ *
+ * Called with the store lock held for reading, so the statuses cannot change meanwhile and the last write to a digit
+ * always carries the latest status. A ticket detached from its segment in the meantime is skipped, since its status
+ * went to the journal. Written tickets are removed from the queue; the ones that could not be written stay in it.
+ *
+ * @param fds Array of MAX_PENDING_STATUSES entries to store duplicates of the written segment descriptors in.
+ * @param numFds Pointer to store the number of descriptors in.
+ */
+static void writePendingStatuses( int fds[], int* numFds ) {
+	int failed = 0;
+	*numFds = 0;
+	for( int i = 0; i < numPendingStatuses; i++ ) {
+		int index = pendingStatuses[i];
+		const Ticket* ticket = tableAt( &storeTickets, index );
+		int64_t offset = getStatusOffset( index );
+		if( ticket == NULL || offset < 0 ) {
+			continue;
+		}
+		int segment = getSegment( ticket->showId );
+		const int* fd = tableAt( &segmentFds, segment );
+		if( fd == NULL || *fd < 0 || !writeByteAt( *fd, offset, (char)( '0' + ticket->status ) ) ) {
+			pendingStatuses[failed++] = index;
+			continue;
+		}
+		countBytesWritten( 1 );
+		// a duplicate stays valid for the sync even if a compaction closes the segment after the lock is released
+		#if defined(_WIN32) || defined(_WIN64)
+		int copy = _dup( *fd );
+		#else
+		int copy = dup( *fd );
+		#endif
+		if( copy < 0 ) {
+			pendingStatuses[failed++] = index;
+		} else {
+			fds[( *numFds )++] = copy;
+		}
+	}
+	numPendingStatuses = failed;
+}
+
+/**
+ * @brief Sync and close the segment descriptors written by writePendingStatuses().
+ *
+ * @param fds The descriptors.
+ * @param numFds Number of descriptors.
+ * @return 0 on success, -1 if a segment could not be synced.
+ */
+static int syncPendingStatuses( const int fds[], int numFds ) {
+	int result = 0;
+	for( int i = 0; i < numFds; i++ ) {
+		#if defined(_WIN32) || defined(_WIN64)
+		if( _commit( fds[i] ) != 0 ) {
+			result = -1;
+		}
+		_close( fds[i] );
+		#else
+		if( fsync( fds[i] ) != 0 ) {
+			result = -1;
+		}
+		close( fds[i] );
+		#endif
+	}
+	return result;
+}
+
+/**
+ * @brief Send the statuses that could not be written in place to the journal instead.
+ *
+ * Called with the exclusive store lock held. A database that cannot be written is left alone from then on, until
+ * the next compaction replaces its segments.
+ *
+ * @return 0 on success, -1 if a record could not be queued.
+ */
+static int journalPendingStatuses() {
+	int result = 0;
+	inPlaceUpdates = false;
+	for( int i = 0; i < numPendingStatuses; i++ ) {
+		int index = pendingStatuses[i];
+		const Ticket* ticket = tableAt( &storeTickets, index );
+		if( ticket == NULL || getStatusOffset( index ) < 0 ) {
+			continue;
+		}
+		detachTicket( index );
+		char record[64];
+		snprintf( record, sizeof( record ), "S|%d|%d\n", ticket->id, ticket->status );
+		if( appendJournal( record, 1 ) != 0 ) {
+			result = -1;
+		}
+	}
+	numPendingStatuses = 0;
+	return result;
+}
+
+/**
+ * @brief Rewrite one segment file from memory.
+ *
+ * @param segment The segment number.
+ * @param tickets Positions of the tickets of the segment, in store order.
+ * @param count Number of tickets.
+ * @return 0 on success, -1 if the file could not be written.
+ */
+static int writeSegment( int segment, const int tickets[], int count ) {
+	char filename[MAX_LENGTH * 2];
+	char tempFilename[MAX_LENGTH * 2 + 4];
+	getSegmentFilename( segment, filename, sizeof( filename ), true );
+	snprintf( tempFilename, sizeof( tempFilename ), "%s.tmp", filename );
+	int64_t* offsets = malloc( sizeof( int64_t ) * ( count + 1 ) );
+	FILE* file = offsets != NULL ? fopen( tempFilename, "w" ) : NULL;
+	if( file == NULL ) {
+		free( offsets );
+		return -1;
+	}
+	countFileOpen();
+	int64_t offset = fprintf( file, TICKETS_HEADER );
+	for( int i = 0; i < count; i++ ) {
+		const Ticket* ticket = tableAt( &storeTickets, tickets[i] );
+		int length = fprintf( file, TICKET_FORMAT, ticket->id, getString( ticket->ticketNumber ), ticket->userId,
+							  ticket->showId, ticket->seatNumber, getString( ticket->paymentMethod ),
+							  getString( ticket->paymentAccount ), getString( ticket->transactionNumber ),
+							  ticket->status );
+		offsets[i] = ticket->status >= 0 && ticket->status <= 9 ? offset + length - 2 : -1;
+		offset += length;
+	}
+	countBytesWritten( offset );
+	bool written = syncFile( file ) == 0;
+	if( fclose( file ) != 0 || !written || replaceFile( tempFilename, filename ) != 0 ) {
+		free( offsets );
+		return -1;
+	}
+	// the offsets only describe the new file once it has replaced the old one
+	for( int i = 0; i < count; i++ ) {
+		*(int64_t*)tableAt( &statusOffsets, tickets[i] ) = offsets[i];
+	}
+	free( offsets );
+	return 0;
+}
+
+/**
+ * @brief Write the manifest listing every segment file.
+ *
+ * @param starts Position in the segment order of the first ticket of every segment, followed by the ticket count.
+ * @param numSegments Number of segments.
+ * @return 0 on success, -1 if the manifest could not be written.
+ */
+static int writeManifest( const int starts[], int numSegments ) {
+	char tempFilename[MAX_LENGTH + 20];
+	snprintf( tempFilename, sizeof( tempFilename ), "%s.tmp", manifestFilename );
+	FILE* file = fopen( tempFilename, "w" );
+	if( file == NULL ) {
+		return -1;
+	}
+	countFileOpen();
+	fprintf( file, MANIFEST_HEADER );
+	for( int segment = 0; segment < numSegments; segment++ ) {
+		if( starts[segment + 1] > starts[segment] ) {
+			char name[MAX_LENGTH];
+			getSegmentFilename( segment, name, sizeof( name ), false );
+			fprintf( file, "%s|%d|%d|%d\n", name, segment * SHOWS_PER_SEGMENT,
+					 segment * SHOWS_PER_SEGMENT + SHOWS_PER_SEGMENT - 1, starts[segment + 1] - starts[segment] );
+		}
+	}
+	countBytesWritten( ftell( file ) );
+	bool written = syncFile( file ) == 0;
+	return fclose( file ) == 0 && written ? replaceFile( tempFilename, manifestFilename ) : -1;
+}
+
+/**
+ * @brief Rewrite the changed tickets segments and the shows database from memory, empty the journal and refresh the
+ * snapshots.
+ *
+ * Only segments holding a ticket that is missing from its file, or whose status there is out of date, are
+ * rewritten, so a busy show does not make compaction rewrite the tickets of every other show. Called with the
+ * exclusive store lock held, or while no other thread uses the store.
+ *
+ * @return 0 on success, -1 if a database could not be written.
+ */
+int compactTickets() {
+	StatTimer timer;
+	startTimer( &timer, STAT_SAVE );
+	// offsets change as segments are replaced, so nothing is updated in place until all of them are written
+	inPlaceUpdates = false;
+	closeSegments();
+	int numSegments = 0;
+	for( int i = 0; i < storeTickets.count; i++ ) {
+		int segment = getSegment( ( (const Ticket*)tableAt( &storeTickets, i ) )->showId );
+		if( segment >= numSegments ) {
+			numSegments = segment + 1;
+		}
+	}
+	int* starts = calloc( numSegments + 2, sizeof( int ) );
+	int* next = malloc( sizeof( int ) * ( numSegments + 1 ) );
+	int* order = malloc( sizeof( int ) * ( storeTickets.count + 1 ) );
+	bool* stale = calloc( numSegments + 1, sizeof( bool ) );
+	int result = starts != NULL && next != NULL && order != NULL && stale != NULL ? 0 : -1;
+	for( int i = 0; result == 0 && i < storeTickets.count; i++ ) {
+		int segment = getSegment( ( (const Ticket*)tableAt( &storeTickets, i ) )->showId );
+		starts[segment + 1]++;
+		stale[segment] = stale[segment] || getStatusOffset( i ) < 0;
+	}
+	for( int segment = 0; result == 0 && segment < numSegments; segment++ ) {
+		starts[segment + 1] += starts[segment];
+		next[segment] = starts[segment];
+	}
+	for( int i = 0; result == 0 && i < storeTickets.count; i++ ) {
+		order[next[getSegment( ( (const Ticket*)tableAt( &storeTickets, i ) )->showId )]++] = i;
+	}
+	if( result == 0 && makeDirectory( segmentDirectory ) != 0 && errno != EEXIST ) {
+		result = -1;
+	}
+	for( int segment = 0; result == 0 && segment < numSegments; segment++ ) {
+		if( stale[segment] ) {
+			result = writeSegment( segment, order + starts[segment], starts[segment + 1] - starts[segment] );
+		}
+	}
+	if( result == 0 ) {
+		result = writeManifest( starts, numSegments );
+	}
+	free( starts );
+	free( next );
+	free( order );
+	free( stale );
+	if( result != 0 || saveShowsToFile() != 0 ) {
+		stopTimer( &timer );
+		return -1;
+	}
+	journalOpen = openJournal( ticketsJournalFilename, true ) == 0;
+	journalRecords = 0;
+	journalLength = 0;
+	if( !journalOpen ) {
+		stopTimer( &timer );
+		return -1;
+	}
+	compactionDue = false;
+	inPlaceUpdates = true;
+	writeSnapshots();
+	stopTimer( &timer );
+	return 0;
+}
+
+/**
+ * @brief Compact the store under the exclusive store lock if the journal has outgrown the tickets database.
+ *
+ * Called without any lock held: by the daemon's maintenance thread, between batch commands and menu actions, and by
+ * the compact command.
+ *
+ * @param force true to compact even if the journal is still short.
+ * @return 1 if the store was compacted, 0 if compaction was not due, -1 if a database could not be written.
+ */
+int compactTicketsWhenDue( bool force ) {
+	lockStore();
+	int result = 0;
+	if( force || compactionDue ) {
+		result = compactTickets() == 0 ? 1 : -1;
+	}
+	unlockStore();
+	return result;
+}
+
+/**
+ * @brief Write the binary snapshots of the catalog and the ticket store unless they are already current.
+ *
+ * Called on shutdown so that the next startup can map the snapshots and only replay journal records written after
+ * this point.
+ *
+ * @return 0 on success, -1 if a snapshot could not be written.
+ */
+int saveTicketSnapshots() {
+	uint64_t catalogOffset;
+	if( snapshotCurrent && getCatalogSnapshotOffset( &catalogOffset ) && catalogOffset == journalLength ) {
+		return 0;
+	}
+	StatTimer timer;
+	startTimer( &timer, STAT_SAVE );
+	int result = flushJournal() == 0 ? writeSnapshots() : -1;
+	stopTimer( &timer );
+	return result;
+}
+
+/**
+ * @brief Wait until the journal records and in-place status changes of the calling thread are on disk.
+ *
+ * Records of concurrent purchases and status changes are written and synced together. Status digits are written
+ * under the store lock held for reading and synced after it is released, so callers must release their locks
+ * before committing.
+ *
+ * @return 0 on success, -1 if the journal or a segment could not be written.
+ */
+int commitTickets() {
+	int result = 0;
+	if( numPendingStatuses > 0 ) {
+		int fds[MAX_PENDING_STATUSES];
+		int numFds;
+		lockStoreForReading();
+		writePendingStatuses( fds, &numFds );
+		unlockStoreForReading();
+		result = syncPendingStatuses( fds, numFds );
+		if( numPendingStatuses > 0 ) {
+			lockStore();
+			if( journalPendingStatuses() != 0 ) {
+				result = -1;
+			}
+			unlockStore();
+		}
+	}
+	return commitJournal() == 0 ? result : -1;
+}
+
+/**
+ * @brief Flush and close the journal and release the memory held by the ticket store.
+ */
+void freeTickets() {
+	if( journalOpen ) {
+		closeJournal();
+		journalOpen = false;
+	}
+	closeSegments();
+	tableFree( &statusOffsets );
+	tableFree( &showIdColumn );
+	tableFree( &statusColumn );
+	tableFree( &methodColumn );
+	numPaymentMethods = 0;
+	otherPaymentMethods = false;
+	tableFree( &storeTickets );
+	tableFree( &nextUserTickets );
+	tableFree( &userTickets );
+	intMapFree( &userIndex );
+	intMapFree( &ticketIdIndex );
+	intMapFree( &ticketNumberIndex );
+	nextTicketId = 0;
+	journalRecords = 0;
+	journalLength = 0;
+	snapshotCurrent = false;
+	snapshotMatchesDatabase = false;
+	inPlaceUpdates = false;
+	compactionDue = false;
+}
+
+/**
+ * @brief Get the number of tickets in the store.
+ *
+ * @return The number of tickets.
+ */
+int getTicketCount() {
+	return storeTickets.count;
+}
+
+/**
+ * @brief Get a ticket by its position in the store.
+ *
+ * @param index Position of the ticket, from 0 to getTicketCount() - 1.
+ * @return Pointer to the ticket, or NULL if the index is out of range.
+ */
+const Ticket* getTicketByIndex( int index ) {
+	return tableAt( &storeTickets, index );
+}
+
+/**
+ * @brief Get one block of the ticket store as columns, for reports that scan every ticket.
+ *
+ * Blocks hold TABLE_SEGMENT_ITEMS tickets in store order, the last one possibly fewer, and each column of a block
+ * is a contiguous array. Callers that may run alongside bookings hold the store lock for reading.
+ *
+ * @param block Number of the block, from 0.
+ * @param columns Pointer to store the columns of the block.
+ * @return Number of tickets in the block, or 0 past the last block.
+ */
+int getTicketColumns( int block, TicketColumns* columns ) {
+	if( block < 0 || block >= ( storeTickets.count + TABLE_SEGMENT_ITEMS - 1 ) / TABLE_SEGMENT_ITEMS ) {
+		return 0;
+	}
+	int first = block * TABLE_SEGMENT_ITEMS;
+	columns->showIds = tableAt( &showIdColumn, first );
+	columns->statuses = tableAt( &statusColumn, first );
+	columns->methods = tableAt( &methodColumn, first );
+	int count = storeTickets.count - first;
+	return count < TABLE_SEGMENT_ITEMS ? count : TABLE_SEGMENT_ITEMS;
+}
+
+/**
+ * @brief Get the number of payment method codes in use.
+ *
+ * @return One more than the largest code in the method column.
+ */
+int getPaymentMethodCount() {
+	return otherPaymentMethods ? MAX_PAYMENT_METHODS : numPaymentMethods;
+}
+
+/**
+ * @brief Get the name of a payment method code.
+ *
+ * @param code The code, from 0 to getPaymentMethodCount() - 1.
+ * @return The name of the method, "other" for the code shared by methods beyond the first MAX_PAYMENT_METHODS - 1,
+ *         or NULL if the code is not in use.
+ */
+const char* getPaymentMethodName( int code ) {
+	if( code >= 0 && code < numPaymentMethods ) {
+		return getString( paymentMethods[code] );
+	}
+	return code == MAX_PAYMENT_METHODS - 1 && otherPaymentMethods ? "other" : NULL;
+}
+
+/**
+ * @brief Get a ticket by its ID.
+ *
+ * @param ticketId The ID of the ticket.
+ * @return Pointer to the ticket, or NULL if no ticket has that ID.
+ */
+const Ticket* getTicketById( int ticketId ) {
+	return tableAt( &storeTickets, findTicket( ticketId ) );
+}
+
+/**
+ * @brief Get a ticket by its ticket number.
+ *
+ * @param ticketNumber The ticket number, such as "OSV53521Z"; letters are case-insensitive.
+ * @return Pointer to the ticket, or NULL if no ticket has that number.
+ */
+const Ticket* getTicketByNumber( const char* ticketNumber ) {
+	bool exact;
+	int index;
+	if( !intMapGet( &ticketNumberIndex, ticketNumberKey( ticketNumber, &exact ), &index ) ) {
+		return NULL;
+	}
+	const Ticket* ticket = tableAt( &storeTickets, index );
+	if( !exact && strcmp( getString( ticket->ticketNumber ), ticketNumber ) != 0 ) {
+		return NULL;
+	}
+	return ticket;
+}
+
+/**
+ * @brief Get the number of tickets bought by a user.
+ *
+ * @param userId The ID of the user.
+ * @return The number of tickets.
+ */
+int getUserTicketCount( int userId ) {
+	int listIndex;
+	if( !intMapGet( &userIndex, (uint64_t)(uint32_t)userId, &listIndex ) ) {
+		return 0;
+	}
+	return ( (const UserTickets*)tableAt( &userTickets, listIndex ) )->count;
+}
+
+/**
+ * @brief Get the position of the first ticket bought by a user.
+ *
+ * Together with getNextUserTicket() this walks only the tickets of that user, in purchase order.
+ *
+ * @param userId The ID of the user.
+ * @return Position of the ticket for getTicketByIndex(), or -1 if the user has no tickets.
+ */
+int getFirstUserTicket( int userId ) {
+	int listIndex;
+	if( !intMapGet( &userIndex, (uint64_t)(uint32_t)userId, &listIndex ) ) {
+		return -1;
+	}
+	return ( (const UserTickets*)tableAt( &userTickets, listIndex ) )->first;
+}
+
+/**
+ * @brief Get the position of the next ticket bought by the same user.
+ *
+ * @param index Position of the current ticket.
+ * @return Position of the next ticket, or -1 if there is none.
+ */
+int getNextUserTicket( int index ) {
+	const int* next = tableAt( &nextUserTickets, index );
+	return next != NULL ? *next : -1;
+}
+
+/**
+ * @brief Add the purchased tickets of one booking to the store.
+ *
+ * Called with the exclusive store lock held. Assigns the ticket IDs, books the seats in the catalog and queues the
+ * purchase records for the journal in one piece; commitTickets() waits until they are on disk. If a ticket cannot be
+ * stored or journaled, the tickets added before it are taken out again and their seats freed, so a booking is
+ * stored whole or not at all.
+ *
+ * @param tickets The tickets to add; their id fields are filled in.
+ * @param count Number of tickets.
+ * @return 0 on success, -1 if the tickets could not be stored.
+ */
+int addTickets( Ticket tickets[], int count ) {
+	if( count < 1 ) {
+		return 0;
+	}
+	char* records = calloc( count, PURCHASE_RECORD_LENGTH );
+	size_t length = 0;
+	int added = 0;
+	for( ; records != NULL && added < count; added++ ) {
+		Ticket* ticket = &tickets[added];
+		ticket->id = nextTicketId;
+		if( insertTicket( ticket, -1 ) != 0 ) {
+			break;
+		}
+		applySeat( ticket );
+		snprintf( records + length, PURCHASE_RECORD_LENGTH, "P|" TICKET_FORMAT, ticket->id,
+				  getString( ticket->ticketNumber ), ticket->userId, ticket->showId, ticket->seatNumber,
+				  getString( ticket->paymentMethod ), getString( ticket->paymentAccount ),
+				  getString( ticket->transactionNumber ), ticket->status );
+		length += strlen( records + length );
+	}
+	int result = added == count && appendJournal( records, count ) == 0 ? 0 : -1;
+	if( result != 0 ) {
+		while( added-- > 0 ) {
+			removeLastTicket();
+		}
+	}
+	free( records );
+	return result;
+}
+
+/**
+ * @brief Change the status of a ticket.
+ *
+ * Books or releases the seat in the catalog. Called with the exclusive store lock held, and only changes memory: a
+ * ticket that has a row in a segment of the tickets database is queued for commitTickets() to overwrite its status
+ * digit there and sync it after the lock is released, so only the segment of its show is touched and the cost does
+ * not depend on the size of the database; any other ticket gets a status record queued for the journal, which
+ * commitTickets() waits for.
+ *
+ * @param ticketId The ID of the ticket.
+ * @param status The new status, 1 for active and 0 for canceled.
+ * @return 0 on success, -1 if no ticket has that ID.
+ */
+int setTicketStatus( int ticketId, int status ) {
+	int index = findTicket( ticketId );
+	Ticket* ticket = tableAt( &storeTickets, index );
+	if( ticket == NULL ) {
+		return -1;
+	}
+	storeStatus( index, status );
+	applySeat( ticket );
+	int64_t offset = getStatusOffset( index );
+	if( inPlaceUpdates && offset >= 0 && status >= 0 && status <= 9 && numPendingStatuses < MAX_PENDING_STATUSES ) {
+		// the segment is opened here so that commitTickets() only has to read the descriptor table
+		if( openSegment( getSegment( ticket->showId ) ) >= 0 ) {
+			retireDatabaseSnapshot();
+			pendingStatuses[numPendingStatuses++] = index;
+			return 0;
+		}
+		// a database that cannot be written is left alone and the change goes to the journal instead
+		inPlaceUpdates = false;
+	}
+	detachTicket( index );
+	char record[64];
+	snprintf( record, sizeof( record ), "S|%d|%d\n", ticketId, status );
+	return appendJournal( record, 1 );
+}
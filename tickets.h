@@ -0,0 +1,205 @@
+/**
+ * @file include/tickets.h
+ */
+
+#ifndef TICKETS_H
+#define TICKETS_H
+
+#include <stdint.h>
+#include "utilities.h"
+
+#define SHOWS_PER_SEGMENT 64
+#define MAX_PAYMENT_METHODS 64
+
+/**
+ * @brief The fields of a block of tickets that reports aggregate over, one array per field.
+ *
+ * Payment methods are small codes; read their names with getPaymentMethodName().
+ */
+typedef struct {
+	const int32_t* showIds;
+	const uint8_t* statuses;
+	const uint8_t* methods;
+} TicketColumns;
+
+/**
+ * @brief Load all tickets into the resident ticket store and replay the journal.
+ *
+ * The tickets database holds the state as of the last compaction, split into one segment file per range of
+ * SHOWS_PER_SEGMENT shows and listed by a manifest; every purchase and status change since then is a record in the
+ * journal. Replaying the journal also re-applies its seat changes to the catalog, so the catalog must be loaded
+ * first. When the catalog and ticket snapshots are current they are mapped instead of parsing the segments, and
+ * only the journal records written after them are replayed. A single-file database from before segments existed
+ * is split into segments and removed.
+ *
+ * @param filename The name of the tickets database file; the segments live in the directory of the same name
+ *                 without the ".txt" extension.
+ * @param journalFilename The name of the ticket journal file.
+ * @return The number of loaded tickets, or -1 if the tickets database or journal could not be read.
+ */
+int loadTicketsFromFile( const char* filename, const char* journalFilename );
+
+/**
+ * @brief Rewrite the changed tickets segments and the shows database from memory, empty the journal and refresh the
+ * snapshots.
+ *
+ * Only segments holding a ticket that is missing from its file, or whose status there is out of date, are
+ * rewritten, so a busy show does not make compaction rewrite the tickets of every other show. Called with the
+ * exclusive store lock held, or while no other thread uses the store.
+ *
+ * @return 0 on success, -1 if a database could not be written.
+ */
+int compactTickets();
+
+/**
+ * @brief Compact the store under the exclusive store lock if the journal has outgrown the tickets database.
+ *
+ * Called without any lock held: by the daemon's maintenance thread, between batch commands and menu actions, and by
+ * the compact command.
+ *
+ * @param force true to compact even if the journal is still short.
+ * @return 1 if the store was compacted, 0 if compaction was not due, -1 if a database could not be written.
+ */
+int compactTicketsWhenDue( bool force );
+
+/**
+ * @brief Write the binary snapshots of the catalog and the ticket store unless they are already current.
+ *
+ * Called on shutdown so that the next startup can map the snapshots and only replay journal records written after
+ * this point.
+ *
+ * @return 0 on success, -1 if a snapshot could not be written.
+ */
+int saveTicketSnapshots();
+
+/**
+ * @brief Wait until the journal records and in-place status changes of the calling thread are on disk.
+ *
+ * Records of concurrent purchases and status changes are written and synced together. Status digits are written
+ * under the store lock held for reading and synced after it is released, so callers must release their locks
+ * before committing.
+ *
+ * @return 0 on success, -1 if the journal or a segment could not be written.
+ */
+int commitTickets();
+
+/**
+ * @brief Flush and close the journal and release the memory held by the ticket store.
+ */
+void freeTickets();
+
+/**
+ * @brief Get the number of tickets in the store.
+ *
+ * @return The number of tickets.
+ */
+int getTicketCount();
+
+/**
+ * @brief Get a ticket by its position in the store.
+ *
+ * @param index Position of the ticket, from 0 to getTicketCount() - 1.
+ * @return Pointer to the ticket, or NULL if the index is out of range.
+ */
+const Ticket* getTicketByIndex( int index );
+
+/**
+ * @brief Get one block of the ticket store as columns, for reports that scan every ticket.
+ *
+ * Blocks hold TABLE_SEGMENT_ITEMS tickets in store order, the last one possibly fewer, and each column of a block
+ * is a contiguous array. Callers that may run alongside bookings hold the store lock for reading.
+ *
+ * @param block Number of the block, from 0.
+ * @param columns Pointer to store the columns of the block.
+ * @return Number of tickets in the block, or 0 past the last block.
+ */
+int getTicketColumns( int block, TicketColumns* columns );
+
+/**
+ * @brief Get the number of payment method codes in use.
+ *
+ * @return One more than the largest code in the method column.
+ */
+int getPaymentMethodCount();
+
+/**
+ * @brief Get the name of a payment method code.
+ *
+ * @param code The code, from 0 to getPaymentMethodCount() - 1.
+ * @return The name of the method, "other" for the code shared by methods beyond the first MAX_PAYMENT_METHODS - 1,
+ *         or NULL if the code is not in use.
+ */
+const char* getPaymentMethodName( int code );
+
+/**
+ * @brief Get a ticket by its ID.
+ *
+ * @param ticketId The ID of the ticket.
+ * @return Pointer to the ticket, or NULL if no ticket has that ID.
+ */
+const Ticket* getTicketById( int ticketId );
+
+/**
+ * @brief Get a ticket by its ticket number.
+ *
+ * @param ticketNumber The ticket number, such as "OSV53521Z"; letters are case-insensitive.
+ * @return Pointer to the ticket, or NULL if no ticket has that number.
+ */
+const Ticket* getTicketByNumber( const char* ticketNumber );
+
+/**
+ * @brief Get the number of tickets bought by a user.
+ *
+ * @param userId The ID of the user.
+ * @return The number of tickets.
+ */
+int getUserTicketCount( int userId );
+
+/**
+ * @brief Get the position of the first ticket bought by a user.
+ *
+ * Together with getNextUserTicket() this walks only the tickets of that user, in purchase order.
+ *
+ * @param userId The ID of the user.
+ * @return Position of the ticket for getTicketByIndex(), or -1 if the user has no tickets.
+ */
+int getFirstUserTicket( int userId );
+
+/**
+ * @brief Get the position of the next ticket bought by the same user.
+ *
+ * @param index Position of the current ticket.
+ * @return Position of the next ticket, or -1 if there is none.
+ */
+int getNextUserTicket( int index );
+
+/**
+ * @brief Add the purchased tickets of one booking to the store.
+ *
+ * Called with the exclusive store lock held. Assigns the ticket IDs, books the seats in the catalog and queues the
+ * purchase records for the journal in one piece; commitTickets() waits until they are on disk. If a ticket cannot be
+ * stored or journaled, the tickets added before it are taken out again and their seats freed, so a booking is
+ * stored whole or not at all.
+ *
+ * @param tickets The tickets to add; their id fields are filled in.
+ * @param count Number of tickets.
+ * @return 0 on success, -1 if the tickets could not be stored.
+ */
+int addTickets( Ticket tickets[], int count );
+
+/**
+ * @brief Change the status of a ticket.
+ *
+ * Books or releases the seat in the catalog. Called with the exclusive store lock held, and only changes memory: a
+ * ticket that has a row in a segment of the tickets database is queued for commitTickets() to overwrite its status
+ * digit there and sync it after the lock is released, so only the segment of its show is touched and the cost does
+ * not depend on the size of the database; any other ticket gets a status record queued for the journal, which
+ * commitTickets() waits for.
+ *
+ * @param ticketId The ID of the ticket.
+ * @param status The new status, 1 for active and 0 for canceled.
+ * @return 0 on success, -1 if no ticket has that ID.
+ */
+int setTicketStatus( int ticketId, int status );
+
+#endif // TICKETS_H
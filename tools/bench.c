@@ -0,0 +1,347 @@
+/**
+ * @file tools/bench.c
+ *
+ * Benchmark of the core operations against a dataset written by gendata. Each operation is timed call by call
+ * and reported as p50/p99 latency and throughput. Purchases and cancellations are journaled into the dataset.
+ * The seat allocator is measured on a synthetic 50,000-seat show that is 95% full.
+ *
+ * Usage: bench <root> [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/utilities.h"
+#include "../include/catalog.h"
+#include "../include/tickets.h"
+#include "../include/booking.h"
+#include "../include/login.h"
+#include "../include/ids.h"
+#include "../include/report.h"
+#include "../include/search.h"
+#include "../include/facets.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+	#include <windows.h>
+	#include <io.h>
+	#include <direct.h>
+	#define NULL_DEVICE "NUL"
+	#define changeDirectory( path ) _chdir( path )
+	#define duplicateOutput() _fdopen( _dup( 1 ), "w" )
+#else
+	#include <unistd.h>
+	#define NULL_DEVICE "/dev/null"
+	#define changeDirectory( path ) chdir( path )
+	#define duplicateOutput() fdopen( dup( 1 ), "w" )
+#endif
+
+#define SHOWS_DATABASE "data/shows.txt"
+#define TICKETS_DATABASE "data/tickets.txt"
+#define TICKETS_JOURNAL "data/tickets.journal"
+#define ALLOCATOR_SEATS 50000
+
+/**
+ * @brief Read a monotonic clock.
+ *
+ * @return The time in microseconds.
+ */
+static double nowMicros() {
+	#if defined(_WIN32) || defined(_WIN64)
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter( &counter );
+	QueryPerformanceFrequency( &frequency );
+	return (double)counter.QuadPart * 1e6 / (double)frequency.QuadPart;
+	#else
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return (double)now.tv_sec * 1e6 + (double)now.tv_nsec / 1e3;
+	#endif
+}
+
+/**
+ * @brief Order samples for qsort().
+ */
+static int compareSamples( const void* a, const void* b ) {
+	double x = *(const double*)a, y = *(const double*)b;
+	return ( x > y ) - ( x < y );
+}
+
+/**
+ * @brief Print the latency percentiles and throughput of an operation.
+ *
+ * @param report Stream to print to.
+ * @param name Name of the operation.
+ * @param samples Latency of each call in microseconds; sorted by the call.
+ * @param count Number of samples.
+ */
+static void printResult( FILE* report, const char* name, double* samples, int count ) {
+	if( count == 0 ) {
+		fprintf( report, "%-22s %8d %12s %12s %12s\n", name, 0, "-", "-", "-" );
+		return;
+	}
+	double total = 0;
+	for( int i = 0; i < count; i++ ) {
+		total += samples[i];
+	}
+	qsort( samples, count, sizeof( double ), compareSamples );
+	fprintf( report, "%-22s %8d %12.2f %12.2f %12.0f\n", name, count, samples[count / 2],
+			 samples[(int)( (long)count * 99 / 100 )], total > 0 ? count / ( total / 1e6 ) : 0 );
+	fflush( report );
+}
+
+/**
+ * @brief Find adjacent free seats by testing seat after seat, as a baseline for findAdjacentSeats().
+ *
+ * @param show The show.
+ * @param count Number of adjacent seats.
+ * @return The first seat of the run, or -1 if there is none.
+ */
+static int scanAdjacentSeats( const Show* show, int count ) {
+	int length = 0;
+	for( int seat = 1; seat <= show->seats; seat++ ) {
+		length = bitmapTest( &show->booked, seat ) ? 0 : length + 1;
+		if( length == count ) {
+			return seat - count + 1;
+		}
+	}
+	return -1;
+}
+
+/**
+ * @brief Time the seat allocator on a large show that is nearly sold out.
+ *
+ * Seats are booked in blocks of random size with free gaps of one to three seats between them, the way a venue
+ * fills up with groups, until about 95% of the seats are taken. Requests for two or three seats then succeed
+ * somewhere in the map, while requests for four or more have to scan all of it and fail.
+ *
+ * @param report Stream to print to.
+ * @param samples Buffer for iterations samples.
+ * @param iterations Number of calls per measurement.
+ */
+static void benchSeatAllocator( FILE* report, double* samples, int iterations ) {
+	Show show = { 0 };
+	show.seats = ALLOCATOR_SEATS;
+	if( bitmapInit( &show.booked, show.seats + 1 ) != 0 ) {
+		return;
+	}
+	for( int seat = 1; seat <= show.seats; ) {
+		int taken = 1 + rand() % 76;
+		for( int i = 0; i < taken && seat <= show.seats; i++ ) {
+			bitmapSet( &show.booked, seat++ );
+		}
+		seat += 1 + rand() % 3;
+	}
+	show.available = show.seats - bitmapCount( &show.booked );
+	fprintf( report, "\nseat allocator: %d seats, %.1f%% booked\n", show.seats,
+			 100.0 * ( show.seats - show.available ) / show.seats );
+	static const struct {
+		const char* name;
+		int count;
+		int seatsPerRow;
+		bool bestFit;
+		bool baseline;
+	} cases[] = {
+		{ "seat-by-seat n=4", 4, 0, false, true },
+		{ "first fit n=2", 2, 0, false, false },
+		{ "first fit n=4", 4, 0, false, false },
+		{ "first fit n=8", 8, 0, false, false },
+		{ "best fit n=2", 2, 0, true, false },
+		{ "best fit n=4", 4, 0, true, false },
+		{ "best fit n=8", 8, 0, true, false },
+		{ "best fit n=4 rows=100", 4, 100, true, false }
+	};
+	for( size_t c = 0; c < sizeof( cases ) / sizeof( cases[0] ); c++ ) {
+		for( int i = 0; i < iterations; i++ ) {
+			double begin = nowMicros();
+			if( cases[c].baseline ) {
+				scanAdjacentSeats( &show, cases[c].count );
+			} else {
+				findAdjacentSeats( &show, cases[c].count, cases[c].seatsPerRow, cases[c].bestFit );
+			}
+			samples[i] = nowMicros() - begin;
+		}
+		printResult( report, cases[c].name, samples, iterations );
+	}
+	bitmapFree( &show.booked );
+}
+
+/**
+ * @brief Pick a random show that has a free seat.
+ *
+ * @param seat Pointer to store the free seat.
+ * @return The show, or NULL if none was found.
+ */
+static Show* pickShowWithFreeSeat( int* seat ) {
+	for( int attempt = 0; attempt < 100; attempt++ ) {
+		Show* show = getShowByIndex( rand() % getShowCount() );
+		*seat = bitmapNextClear( &show->booked, 1 );
+		if( *seat > 0 ) {
+			return show;
+		}
+	}
+	return NULL;
+}
+
+int main( int argc, char* argv[] ) {
+	if( argc < 2 ) {
+		printf( "Usage: %s <root> [iterations]\n", argv[0] );
+		return 1;
+	}
+	int iterations = argc > 2 ? atoi( argv[2] ) : 1000;
+	if( iterations < 1 || changeDirectory( argv[1] ) != 0 ) {
+		printf( "Cannot use %s\n", argv[1] );
+		return 1;
+	}
+	srand( 1 );
+	FILE* report = duplicateOutput();
+	if( report == NULL || freopen( NULL_DEVICE, "w", stdout ) == NULL || freopen( NULL_DEVICE, "r", stdin ) == NULL ) {
+		return 1;
+	}
+	double* samples = malloc( sizeof( double ) * iterations );
+	int* boughtTickets = malloc( sizeof( int ) * iterations );
+	if( samples == NULL || boughtTickets == NULL ) {
+		return 1;
+	}
+
+	double start = nowMicros();
+	int numShows = loadShowsFromFile( SHOWS_DATABASE );
+	double showsLoaded = nowMicros();
+	int numTickets = loadTicketsFromFile( TICKETS_DATABASE, TICKETS_JOURNAL );
+	double ticketsLoaded = nowMicros();
+	Table users;
+	tableInit( &users, sizeof( User ) );
+	int numUsers = loadUsersFromFile( &users );
+	double usersLoaded = nowMicros();
+	if( numShows <= 0 || numTickets < 0 || numUsers <= 0 ) {
+		fprintf( report, "Cannot load the dataset under %s\n", argv[1] );
+		return 1;
+	}
+	fprintf( report, "dataset: %d shows, %d tickets, %d users\n", numShows, numTickets, numUsers );
+	fprintf( report, "load: shows %.1f ms, tickets %.1f ms, users %.1f ms\n\n", ( showsLoaded - start ) / 1e3,
+			 ( ticketsLoaded - showsLoaded ) / 1e3, ( usersLoaded - ticketsLoaded ) / 1e3 );
+	fprintf( report, "%-22s %8s %12s %12s %12s\n", "operation", "count", "p50 us", "p99 us", "ops/s" );
+
+	int viewIterations = iterations / 10 > 0 ? iterations / 10 : 1;
+	for( int i = 0; i < viewIterations; i++ ) {
+		double begin = nowMicros();
+		viewUpcomingShows( 0, true, false, false );
+		samples[i] = nowMicros() - begin;
+	}
+	printResult( report, "viewUpcomingShows", samples, viewIterations );
+
+	int* positions = malloc( sizeof( int ) * numShows );
+	if( positions == NULL ) {
+		return 1;
+	}
+	for( int i = 0; i < iterations; i++ ) {
+		char query[5];
+		snprintf( query, sizeof( query ), "%s", getString( getShowByIndex( rand() % numShows )->singer ) );
+		double begin = nowMicros();
+		searchShows( query, SEARCH_ALL_FIELDS, SEARCH_SUBSTRING, 0, positions, numShows );
+		samples[i] = nowMicros() - begin;
+	}
+	printResult( report, "searchShows", samples, iterations );
+	for( int i = 0; i < iterations; i++ ) {
+		const Show* show = getShowByIndex( rand() % numShows );
+		ShowFilter filter;
+		initShowFilter( &filter );
+		filter.genre = getString( show->type );
+		filter.venue = getString( show->venue );
+		filter.minPrice = show->price - 20;
+		filter.maxPrice = show->price + 20;
+		filter.fromDay = show->day - 365;
+		filter.toDay = show->day + 365;
+		filter.minFreeSeats = 1 + rand() % 100;
+		double begin = nowMicros();
+		filterShows( &filter, positions, numShows );
+		samples[i] = nowMicros() - begin;
+	}
+	printResult( report, "filterShows", samples, iterations );
+	free( positions );
+
+	int bought = 0;
+	for( int i = 0; i < iterations; i++ ) {
+		int seat;
+		Show* show = pickShowWithFreeSeat( &seat );
+		if( show == NULL ) {
+			break;
+		}
+		BookedTicket ticket;
+		char transactionNumber[TRANSACTION_NUMBER_LENGTH];
+		double begin = nowMicros();
+		int result = bookSeats( rand() % numUsers, show->id, &seat, 1, "bKash", "01700000000", &ticket, transactionNumber );
+		samples[bought] = nowMicros() - begin;
+		if( result == BOOKING_OK ) {
+			boughtTickets[bought++] = ticket.ticketId;
+		}
+	}
+	printResult( report, "buyTicket", samples, bought );
+
+	for( int i = 0; i < iterations; i++ ) {
+		char ticketNumber[TICKET_NUMBER_LENGTH];
+		double begin = nowMicros();
+		nextTicketNumber( ticketNumber, sizeof( ticketNumber ) );
+		samples[i] = nowMicros() - begin;
+	}
+	printResult( report, "nextTicketNumber", samples, iterations );
+
+	for( int i = 0; i < bought; i++ ) {
+		double begin = nowMicros();
+		updateTicketStatus( boughtTickets[i], 0 );
+		samples[i] = nowMicros() - begin;
+	}
+	printResult( report, "updateTicketStatus", samples, bought );
+
+	int cancelled = 0;
+	for( int i = 0; i < iterations; i++ ) {
+		const Ticket* ticket = getTicketByIndex( rand() % numTickets );
+		if( ticket->status == 0 ) {
+			continue;
+		}
+		int ticketId = ticket->id;
+		double begin = nowMicros();
+		updateTicketStatus( ticketId, 0 );
+		samples[cancelled++] = nowMicros() - begin;
+		updateTicketStatus( ticketId, 1 );
+	}
+	printResult( report, "cancelStoredTicket", samples, cancelled );
+
+	for( int i = 0; i < iterations; i++ ) {
+		double begin = nowMicros();
+		showTicketsByUserId( rand() % numUsers, true, false, false, false );
+		samples[i] = nowMicros() - begin;
+	}
+	printResult( report, "showTicketsByUserId", samples, iterations );
+
+	for( int i = 0; i < iterations; i++ ) {
+		const User* user = tableAt( &users, rand() % numUsers );
+		char username[MAX_LENGTH], password[MAX_LENGTH];
+		snprintf( username, sizeof( username ), "%s", getString( user->username ) );
+		snprintf( password, sizeof( password ), "%s", getString( user->password ) );
+		double begin = nowMicros();
+		authenticateUser( &users, username, password );
+		samples[i] = nowMicros() - begin;
+	}
+	printResult( report, "loginUser", samples, iterations );
+
+	for( int threads = 1; threads >= 0; threads-- ) {
+		for( int i = 0; i < viewIterations; i++ ) {
+			SalesReport sales;
+			double begin = nowMicros();
+			buildSalesReport( &sales, threads );
+			samples[i] = nowMicros() - begin;
+			freeSalesReport( &sales );
+		}
+		printResult( report, threads == 1 ? "salesReport 1 thread" : "salesReport", samples, viewIterations );
+	}
+
+	benchSeatAllocator( report, samples, iterations );
+
+	freeTickets();
+	tableFree( &users );
+	free( samples );
+	free( boughtTickets );
+	fclose( report );
+	return 0;
+}
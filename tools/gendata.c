@@ -0,0 +1,179 @@
+/**
+ * @file tools/gendata.c
+ *
+ * Synthetic dataset generator. Writes data/shows.txt, data/tickets.txt and data/users.txt under a root directory
+ * in the formats the application loads, with seat maps that agree with the generated tickets.
+ *
+ * Usage: gendata <root> [shows] [tickets] [users] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "../include/bitmap.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+	#include <direct.h>
+	#define makeDirectory( path ) _mkdir( path )
+#else
+	#define makeDirectory( path ) mkdir( path, 0755 )
+#endif
+
+#define MAX_PATH_LENGTH 1024
+#define MIN_SEATS 100
+#define MAX_SEATS 5000
+#define CANCELED_PERCENT 5
+
+static const char* singers[] = { "Arnob", "Momtaz", "James", "Ayub Bachchu", "Habib Wahid", "Arijit Singh",
+								 "Tahsan", "Milon Mahmood", "Runa Laila", "Shreya Ghoshal" };
+static const char* venues[] = { "Shilpakala Academy", "Jatiya Rabindra Sangeet Sammelan", "Bangabandhu National Stadium",
+								"International Convention City Bashundhara (ICCB)", "Army Stadium", "Chhayanaut Auditorium" };
+static const char* types[] = { "Folk", "Rock", "Pop", "Bollywood", "Classical", "Band" };
+static const char* paymentMethods[] = { "bKash", "Nagad", "Rocket" };
+
+#define COUNT_OF( array ) ( (int)( sizeof( array ) / sizeof( ( array )[0] ) ) )
+
+/**
+ * @brief Random number from 0 to bound - 1, wide enough for millions of rows.
+ *
+ * @param bound The exclusive upper bound.
+ * @return The number.
+ */
+static long randomBelow( long bound ) {
+	unsigned long value = ( (unsigned long)rand() << 30 ) ^ ( (unsigned long)rand() << 15 ) ^ (unsigned long)rand();
+	return (long)( value % (unsigned long)bound );
+}
+
+/**
+ * @brief Format a ticket number in the AAA00000A pattern, unique for every ticket ID.
+ *
+ * @param ticketId The ticket ID.
+ * @param ticketNumber Buffer of at least 10 characters.
+ */
+static void formatTicketNumber( long ticketId, char* ticketNumber ) {
+	long last = ticketId % 26;
+	ticketId /= 26;
+	long digits = ticketId % 100000;
+	ticketId /= 100000;
+	snprintf( ticketNumber, 10, "%c%c%c%05ld%c", (char)( 'A' + ( ticketId / 676 ) % 26 ), (char)( 'A' + ( ticketId / 26 ) % 26 ),
+			  (char)( 'A' + ticketId % 26 ), digits, (char)( 'A' + last ) );
+}
+
+/**
+ * @brief Open an output file under the data directory.
+ *
+ * @param root The root directory.
+ * @param name The file name.
+ * @return The file, or NULL if it could not be created.
+ */
+static FILE* openOutput( const char* root, const char* name ) {
+	char path[MAX_PATH_LENGTH];
+	snprintf( path, sizeof( path ), "%s/data/%s", root, name );
+	FILE* file = fopen( path, "w" );
+	if( file == NULL ) {
+		printf( "Cannot write %s\n", path );
+	}
+	return file;
+}
+
+int main( int argc, char* argv[] ) {
+	if( argc < 2 ) {
+		printf( "Usage: %s <root> [shows] [tickets] [users] [seed]\n", argv[0] );
+		return 1;
+	}
+	const char* root = argv[1];
+	long numShows = argc > 2 ? atol( argv[2] ) : 10000;
+	long numTickets = argc > 3 ? atol( argv[3] ) : 1000000;
+	long numUsers = argc > 4 ? atol( argv[4] ) : 100000;
+	srand( argc > 5 ? (unsigned)atol( argv[5] ) : 1 );
+	if( numShows < 1 || numUsers < 1 || numTickets < 0 ) {
+		printf( "Counts must be positive.\n" );
+		return 1;
+	}
+	char path[MAX_PATH_LENGTH];
+	makeDirectory( root );
+	snprintf( path, sizeof( path ), "%s/data", root );
+	makeDirectory( path );
+
+	int* seats = malloc( sizeof( int ) * numShows );
+	int* nextSeat = calloc( numShows, sizeof( int ) );
+	Bitmap* booked = calloc( numShows, sizeof( Bitmap ) );
+	if( seats == NULL || nextSeat == NULL || booked == NULL ) {
+		printf( "Out of memory.\n" );
+		return 1;
+	}
+	long capacity = 0;
+	for( long i = 0; i < numShows; i++ ) {
+		seats[i] = MIN_SEATS + (int)randomBelow( MAX_SEATS - MIN_SEATS + 1 );
+		capacity += seats[i];
+		if( bitmapInit( &booked[i], seats[i] + 1 ) != 0 ) {
+			printf( "Out of memory.\n" );
+			return 1;
+		}
+	}
+	if( numTickets > capacity ) {
+		printf( "Only %ld seats in %ld shows; generating %ld tickets.\n", capacity, numShows, capacity );
+		numTickets = capacity;
+	}
+
+	FILE* file = openOutput( root, "users.txt" );
+	if( file == NULL ) {
+		return 1;
+	}
+	fprintf( file, "id|username|password\n" );
+	for( long i = 0; i < numUsers; i++ ) {
+		fprintf( file, "%ld|user%ld|pass%ld\n", i, i, i );
+	}
+	fclose( file );
+
+	file = openOutput( root, "tickets.txt" );
+	if( file == NULL ) {
+		return 1;
+	}
+	fprintf( file, "id|ticket_number|user_id|show_id|seat_number|payment_method|payment_account|transaction_number|status\n" );
+	long show = 0;
+	for( long i = 0; i < numTickets; i++ ) {
+		show = randomBelow( numShows );
+		while( nextSeat[show] >= seats[show] ) {
+			show = ( show + 1 ) % numShows;
+		}
+		int seat = ++nextSeat[show];
+		int status = randomBelow( 100 ) < CANCELED_PERCENT ? 0 : 1;
+		if( status ) {
+			bitmapSet( &booked[show], seat );
+		}
+		char ticketNumber[10];
+		formatTicketNumber( i, ticketNumber );
+		fprintf( file, "%ld|%s|%ld|%ld|%d|%s|01%09ld|T%08ld|%d\n", i, ticketNumber, randomBelow( numUsers ), show, seat,
+				 paymentMethods[randomBelow( COUNT_OF( paymentMethods ) )], randomBelow( 1000000000 ), i / 2, status );
+	}
+	fclose( file );
+	// without a manifest the application splits the new tickets.txt into segments instead of loading old ones
+	snprintf( path, sizeof( path ), "%s/data/tickets/manifest.txt", root );
+	remove( path );
+
+	file = openOutput( root, "shows.txt" );
+	if( file == NULL ) {
+		return 1;
+	}
+	time_t now = time( NULL );
+	int year = localtime( &now )->tm_year + 1900;
+	fprintf( file, "id|singer|date|venue|type|price|seats|booked\n" );
+	for( long i = 0; i < numShows; i++ ) {
+		fprintf( file, "%ld|%s|%02d,%02d,%d|%s|%s|%d|%d|", i, singers[randomBelow( COUNT_OF( singers ) )],
+				 1 + (int)randomBelow( 28 ), 1 + (int)randomBelow( 12 ), year - 1 + (int)randomBelow( 4 ),
+				 venues[randomBelow( COUNT_OF( venues ) )], types[randomBelow( COUNT_OF( types ) )],
+				 50 + 5 * (int)randomBelow( 60 ), seats[i] );
+		bitmapWriteList( &booked[i], file );
+		fputc( '\n', file );
+		bitmapFree( &booked[i] );
+	}
+	fclose( file );
+	printf( "Wrote %ld shows, %ld tickets and %ld users to %s/data\n", numShows, numTickets, numUsers, root );
+	free( seats );
+	free( nextSeat );
+	free( booked );
+	return 0;
+}
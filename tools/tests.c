@@ -0,0 +1,444 @@
+/**
+ * @file tools/tests.c
+ *
+ * Regression tests of the seat lists, journal replay, hold expiry and show filtering and search. Writes a small
+ * dataset into a new directory, runs every check against it and prints the checks that fail.
+ *
+ * Usage: tests <new directory> [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "../include/bitmap.h"
+#include "../include/catalog.h"
+#include "../include/tickets.h"
+#include "../include/booking.h"
+#include "../include/holds.h"
+#include "../include/ids.h"
+#include "../include/search.h"
+#include "../include/facets.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+	#include <windows.h>
+	#include <io.h>
+	#include <direct.h>
+	#define NULL_DEVICE "NUL"
+	#define makeDirectory( path ) _mkdir( path )
+	#define changeDirectory( path ) _chdir( path )
+	#define duplicateOutput() _fdopen( _dup( 1 ), "w" )
+	#define sleepSeconds( seconds ) Sleep( ( seconds ) * 1000 )
+#else
+	#include <unistd.h>
+	#define NULL_DEVICE "/dev/null"
+	#define makeDirectory( path ) mkdir( path, 0755 )
+	#define changeDirectory( path ) chdir( path )
+	#define duplicateOutput() fdopen( dup( 1 ), "w" )
+	#define sleepSeconds( seconds ) sleep( seconds )
+#endif
+
+#define SHOWS_DATABASE "data/shows.txt"
+#define TICKETS_DATABASE "data/tickets.txt"
+#define TICKETS_JOURNAL "data/tickets.journal"
+#define ID_SEQUENCES "data/ids.seq"
+#define TEST_SHOWS 240
+#define RANDOM_CHECKS 2000
+
+#define CHECK( condition ) check( condition, #condition, __LINE__ )
+
+static const char* singers[] = { "Arnob", "Momtaz", "James", "Ayub Bachchu", "Habib Wahid", "Arijit Singh",
+								 "Tahsan", "Milon Mahmood", "R\xC3\xBAna Laila", "Shreya Ghoshal" };
+static const char* venues[] = { "Shilpakala Academy", "Jatiya Rabindra Sangeet Sammelan", "Bangabandhu National Stadium",
+								"International Convention City Bashundhara (ICCB)", "Army Stadium", "Chhayanaut Auditorium" };
+static const char* types[] = { "Folk", "Rock", "Pop", "Bollywood", "Classical", "Band" };
+
+#define COUNT_OF( array ) ( (int)( sizeof( array ) / sizeof( ( array )[0] ) ) )
+
+static FILE* report;
+static int failures = 0;
+
+/**
+ * @brief Report a check that failed.
+ *
+ * @param passed Result of the check.
+ * @param condition Text of the checked condition.
+ * @param line Line of the check.
+ */
+static void check( bool passed, const char* condition, int line ) {
+	if( !passed ) {
+		fprintf( report, "tests.c:%d: failed: %s\n", line, condition );
+		failures++;
+	}
+}
+
+/**
+ * @brief Lower-case an ASCII letter, leaving every other byte as it is.
+ *
+ * @param c The character.
+ * @return The folded character.
+ */
+static char foldCase( char c ) {
+	return c >= 'A' && c <= 'Z' ? (char)( c - 'A' + 'a' ) : c;
+}
+
+/**
+ * @brief Compare two strings, ignoring the case of ASCII letters.
+ *
+ * @return true if they are equal.
+ */
+static bool equalsFolded( const char* a, const char* b ) {
+	for( ; *a != '\0' && foldCase( *a ) == foldCase( *b ); a++, b++ ) {
+	}
+	return *a == '\0' && *b == '\0';
+}
+
+/**
+ * @brief Check whether a field contains a query the way searchShows() matches it, one character at a time.
+ *
+ * @param text The field.
+ * @param query The query.
+ * @param mode SEARCH_SUBSTRING to match anywhere, or SEARCH_PREFIX to match only at the start of a word.
+ * @return true if the field matches.
+ */
+static bool containsQuery( const char* text, const char* query, SearchMode mode ) {
+	size_t length = strlen( query );
+	for( size_t i = 0; text[i] != '\0'; i++ ) {
+		unsigned char previous = i > 0 ? (unsigned char)text[i - 1] : ' ';
+		bool wordCharacter = ( previous >= 'a' && previous <= 'z' ) || ( previous >= 'A' && previous <= 'Z' ) ||
+							 ( previous >= '0' && previous <= '9' ) || previous >= 0x80;
+		if( mode == SEARCH_PREFIX && wordCharacter ) {
+			continue;
+		}
+		size_t j = 0;
+		while( j < length && text[i + j] != '\0' && foldCase( text[i + j] ) == foldCase( query[j] ) ) {
+			j++;
+		}
+		if( j == length ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Write the dataset the tests run against.
+ *
+ * @return 0 on success, -1 if a file could not be written.
+ */
+static int writeDataset() {
+	FILE* shows = fopen( SHOWS_DATABASE, "w" );
+	FILE* tickets = fopen( TICKETS_DATABASE, "w" );
+	FILE* users = fopen( "data/users.txt", "w" );
+	if( shows == NULL || tickets == NULL || users == NULL ) {
+		return -1;
+	}
+	fprintf( shows, "id|singer|date|type|price|seats|booked\n" );
+	for( int i = 0; i < TEST_SHOWS; i++ ) {
+		int seats = 20 + ( i * 13 ) % 40;
+		fprintf( shows, "%d|%s|%02d,%02d,%d|%s|%s|%d|%d|%s\n", i, singers[i % COUNT_OF( singers )], 1 + ( i * 7 ) % 28,
+				 1 + ( i * 5 ) % 12, 2097 + i % 3, venues[( i / 3 ) % COUNT_OF( venues )],
+				 types[( i * 7 ) % COUNT_OF( types )], 50 + ( i * 37 ) % 100, seats,
+				 i % 4 == 0 ? "1-3,7" : i % 4 == 1 ? "2" : "" );
+	}
+	fprintf( tickets, "id|ticket_number|user_id|show_id|seat_number|payment_method|payment_account|transaction_number|status\n" );
+	fprintf( users, "id|username|password\n0|sabbir ahmod|1234\n1|tirtho|1234\n" );
+	fclose( shows );
+	fclose( tickets );
+	fclose( users );
+	return 0;
+}
+
+/**
+ * @brief Load the shows, the tickets and the ID sequences of the dataset.
+ *
+ * @return true on success.
+ */
+static bool loadDataset() {
+	return loadShowsFromFile( SHOWS_DATABASE ) == TEST_SHOWS && loadTicketsFromFile( TICKETS_DATABASE, TICKETS_JOURNAL ) >= 0 &&
+		   loadIdSequences( ID_SEQUENCES ) == 0;
+}
+
+/**
+ * @brief Parse a seat list into a bitmap and write it back.
+ *
+ * @param size Size of the bitmap.
+ * @param text The seat list.
+ * @param expectedSkipped The number of numbers and ranges expected to reach past the end.
+ * @param expectedList The seat list expected to be written back.
+ * @return true if both match.
+ */
+static bool parsesAs( int size, const char* text, int expectedSkipped, const char* expectedList ) {
+	Bitmap bitmap;
+	FILE* file = tmpfile();
+	if( file == NULL || bitmapInit( &bitmap, size ) != 0 ) {
+		return false;
+	}
+	int skipped = bitmapParseList( &bitmap, text, strlen( text ) );
+	bitmapWriteList( &bitmap, file );
+	char written[256] = "";
+	rewind( file );
+	size_t length = fread( written, 1, sizeof( written ) - 1, file );
+	written[length] = '\0';
+	fclose( file );
+	bitmapFree( &bitmap );
+	return skipped == expectedSkipped && strcmp( written, expectedList ) == 0;
+}
+
+/**
+ * @brief Check the parsing and writing of text seat lists.
+ */
+static void testSeatLists() {
+	CHECK( parsesAs( 31, "2,14,7", 0, "2,7,14" ) );
+	CHECK( parsesAs( 31, "1,2,3,5,6,9", 0, "1-3,5,6,9" ) );
+	CHECK( parsesAs( 31, "1-30,45", 1, "1-30" ) );
+	CHECK( parsesAs( 31, " 3 , 4-4 ;x7-", 0, "3,4,7" ) );
+	CHECK( parsesAs( 31, "", 0, "" ) );
+	CHECK( parsesAs( 31, "5-99999999999999999999999999", 1, "5-30" ) );
+	CHECK( parsesAs( 31, "1-2147483647", 1, "1-30" ) );
+	CHECK( parsesAs( 31, "99999999999999999999,30", 1, "30" ) );
+	CHECK( parsesAs( 31, "20-5", 0, "" ) );
+
+	Bitmap written, parsed;
+	FILE* file = tmpfile();
+	if( file == NULL || bitmapInit( &written, 1000 ) != 0 || bitmapInit( &parsed, 1000 ) != 0 ) {
+		CHECK( false );
+		return;
+	}
+	for( int bit = 1; bit < 1000; bit++ ) {
+		if( rand() % 3 != 0 ) {
+			bitmapSet( &written, bit );
+		}
+	}
+	bitmapWriteList( &written, file );
+	long length = ftell( file );
+	char* text = malloc( length + 1 );
+	rewind( file );
+	CHECK( text != NULL && fread( text, 1, length, file ) == (size_t)length );
+	if( text != NULL ) {
+		CHECK( bitmapParseList( &parsed, text, length ) == 0 );
+	}
+	bool same = true;
+	for( int bit = 0; bit < 1000; bit++ ) {
+		same = same && bitmapTest( &written, bit ) == bitmapTest( &parsed, bit );
+	}
+	CHECK( same );
+	free( text );
+	fclose( file );
+	bitmapFree( &written );
+	bitmapFree( &parsed );
+}
+
+/**
+ * @brief Check that booked and canceled tickets come back the same from the journal and from the compacted
+ * databases, payment fields included.
+ */
+static void testJournalReplay() {
+	const char* method = "bKash \xC3\xA4\\\"#";
+	const char* account = "01-700,000 000\t'x'";
+	int seats[] = { 10, 11, 12 };
+	BookedTicket booked[3];
+	char transactionNumber[TRANSACTION_NUMBER_LENGTH];
+	CHECK( bookSeats( 1, 5, seats, 1, "a|b", account, booked, transactionNumber ) == BOOKING_BAD_PAYMENT );
+	CHECK( bookSeats( 1, 5, seats, 1, method, "01\n700", booked, transactionNumber ) == BOOKING_BAD_PAYMENT );
+	CHECK( bookSeats( 1, 5, seats, 1, method, "01\r700", booked, transactionNumber ) == BOOKING_BAD_PAYMENT );
+	CHECK( bookSeats( 1, 5, seats, 1, "", account, booked, transactionNumber ) == BOOKING_BAD_PAYMENT );
+	int ticketsBefore = getTicketCount();
+	CHECK( bookSeats( 1, 5, seats, 3, method, account, booked, transactionNumber ) == BOOKING_OK );
+	CHECK( getTicketCount() == ticketsBefore + 3 );
+	CHECK( changeTicketStatus( booked[1].ticketId, 1, 0 ) == BOOKING_OK );
+
+	// a record torn by a crash is ignored
+	FILE* journal = fopen( TICKETS_JOURNAL, "a" );
+	CHECK( journal != NULL );
+	if( journal != NULL ) {
+		fprintf( journal, "P|%d|TORN0000A|1|5|13|bKash|0170", ticketsBefore + 100 );
+		fclose( journal );
+	}
+	for( int pass = 0; pass < 2; pass++ ) {
+		freeTickets();
+		freeShows();
+		if( !loadDataset() ) {
+			CHECK( false );
+			return;
+		}
+		CHECK( getTicketCount() == ticketsBefore + 3 );
+		CHECK( getTicketByNumber( "TORN0000A" ) == NULL );
+		const Show* show = getShowById( 5 );
+		CHECK( isSeatFree( show, 13 ) );
+		for( int i = 0; i < 3; i++ ) {
+			const Ticket* ticket = getTicketByNumber( booked[i].ticketNumber );
+			CHECK( ticket != NULL );
+			if( ticket == NULL ) {
+				continue;
+			}
+			CHECK( ticket->id == booked[i].ticketId );
+			CHECK( ticket->userId == 1 && ticket->showId == 5 && ticket->seatNumber == seats[i] );
+			CHECK( ticket->status == ( i == 1 ? 0 : 1 ) );
+			CHECK( strcmp( getString( ticket->paymentMethod ), method ) == 0 );
+			CHECK( strcmp( getString( ticket->paymentAccount ), account ) == 0 );
+			CHECK( strcmp( getString( ticket->transactionNumber ), transactionNumber ) == 0 );
+			CHECK( isSeatFree( show, seats[i] ) == ( i == 1 ) );
+		}
+		// the second pass loads the databases the journal was compacted into
+		if( pass == 0 ) {
+			CHECK( compactTicketsWhenDue( true ) == 1 );
+		}
+	}
+}
+
+/**
+ * @brief Check that held seats are taken until their hold expires, and free afterwards.
+ */
+static void testHoldExpiry() {
+	setHoldSeconds( 1 );
+	Show* show = getShowById( 6 );
+	int available = getAvailableSeats( show );
+	int heldSeats[] = { 4, 5 };
+	int confirmedSeats[] = { 8 };
+	int expiring = holdSeats( 0, 6, heldSeats, 2 );
+	int confirmed = holdSeats( 0, 6, confirmedSeats, 1 );
+	CHECK( expiring >= 0 && confirmed >= 0 );
+	CHECK( !isSeatFree( show, 4 ) && !isSeatFree( show, 5 ) );
+	CHECK( getAvailableSeats( show ) == available - 3 );
+	BookedTicket booked[1];
+	char transactionNumber[TRANSACTION_NUMBER_LENGTH];
+	CHECK( holdSeats( 1, 6, heldSeats + 1, 1 ) == BOOKING_SEAT_TAKEN );
+	CHECK( bookSeats( 1, 6, heldSeats, 1, "bKash", "0170", booked, transactionNumber ) == BOOKING_SEAT_TAKEN );
+	CHECK( confirmHold( confirmed, 1, "bKash", "0170", 1, booked, transactionNumber ) == BOOKING_NO_HOLD );
+	CHECK( confirmHold( confirmed, 0, "bKash", "0170", 1, booked, transactionNumber ) == 1 );
+
+	sleepSeconds( 2 );
+	releaseExpiredHolds();
+	CHECK( isSeatFree( show, 4 ) && isSeatFree( show, 5 ) );
+	CHECK( !isSeatFree( show, 8 ) );
+	CHECK( getAvailableSeats( show ) == available - 1 );
+	CHECK( confirmHold( expiring, 0, "bKash", "0170", 2, booked, transactionNumber ) == BOOKING_NO_HOLD );
+	CHECK( releaseHold( expiring, 0 ) == BOOKING_NO_HOLD );
+	setHoldSeconds( 0 );
+}
+
+/**
+ * @brief Check filterShows() and searchShows() against a scan of every show.
+ */
+static void testFilterAndSearch() {
+	int numShows = getShowCount();
+	int* positions = malloc( sizeof( int ) * numShows );
+	if( positions == NULL ) {
+		CHECK( false );
+		return;
+	}
+	// book and hold seats so that the free seats of the shows differ from the shows database
+	for( int i = 0; i < 200; i++ ) {
+		const Show* show = getShowByIndex( rand() % numShows );
+		int seat = 1 + rand() % show->seats;
+		if( i % 2 == 0 ) {
+			BookedTicket booked;
+			char transactionNumber[TRANSACTION_NUMBER_LENGTH];
+			bookSeats( 0, show->id, &seat, 1, "Nagad", "0180", &booked, transactionNumber );
+		} else {
+			holdSeats( 0, show->id, &seat, 1 );
+		}
+	}
+	bool filtered = true;
+	for( int i = 0; i < RANDOM_CHECKS && filtered; i++ ) {
+		const Show* sample = getShowByIndex( rand() % numShows );
+		ShowFilter filter;
+		initShowFilter( &filter );
+		if( rand() % 2 == 0 ) {
+			filter.genre = rand() % 4 == 0 ? "CLASSICAL" : getString( sample->type );
+		}
+		if( rand() % 2 == 0 ) {
+			filter.venue = getString( sample->venue );
+		}
+		if( rand() % 2 == 0 ) {
+			filter.minPrice = 40 + rand() % 120;
+			filter.maxPrice = filter.minPrice + rand() % 60;
+		}
+		if( rand() % 2 == 0 ) {
+			filter.fromDay = sample->day - rand() % 400;
+			filter.toDay = sample->day + rand() % 400;
+		}
+		if( rand() % 2 == 0 ) {
+			filter.minFreeSeats = 1 + rand() % 64;
+		}
+		int count = filterShows( &filter, positions, numShows );
+		int expected = 0;
+		for( int position = 0; position < numShows && filtered; position++ ) {
+			const Show* show = getShowByDateOrder( position );
+			if( ( filter.genre == NULL || equalsFolded( getString( show->type ), filter.genre ) ) &&
+					( filter.venue == NULL || equalsFolded( getString( show->venue ), filter.venue ) ) &&
+					show->price >= filter.minPrice && show->price <= filter.maxPrice && show->day >= filter.fromDay &&
+					show->day <= filter.toDay && getAvailableSeats( show ) >= filter.minFreeSeats ) {
+				filtered = expected < count && positions[expected] == position;
+				expected++;
+			}
+		}
+		filtered = filtered && count == expected;
+	}
+	CHECK( filtered );
+
+	bool searched = true;
+	for( int i = 0; i < RANDOM_CHECKS && searched; i++ ) {
+		const Show* sample = getShowByIndex( rand() % numShows );
+		int fields = 1 + rand() % SEARCH_ALL_FIELDS;
+		const char* text = getString( rand() % 3 == 0 ? sample->singer : rand() % 2 == 0 ? sample->venue : sample->type );
+		size_t textLength = strlen( text );
+		size_t start = rand() % textLength;
+		size_t length = 1 + rand() % 6;
+		char query[8];
+		snprintf( query, sizeof( query ), "%.*s", (int)length, text + start );
+		for( size_t j = 0; query[j] != '\0'; j++ ) {
+			if( rand() % 2 == 0 && query[j] >= 'a' && query[j] <= 'z' ) {
+				query[j] = (char)( query[j] - 'a' + 'A' );
+			}
+		}
+		SearchMode mode = rand() % 2 == 0 ? SEARCH_SUBSTRING : SEARCH_PREFIX;
+		int from = rand() % numShows;
+		int count = searchShows( query, fields, mode, from, positions, numShows );
+		int expected = 0;
+		for( int position = from; position < numShows && searched; position++ ) {
+			const Show* show = getShowByDateOrder( position );
+			if( ( ( fields & SEARCH_SINGER ) && containsQuery( getString( show->singer ), query, mode ) ) ||
+					( ( fields & SEARCH_VENUE ) && containsQuery( getString( show->venue ), query, mode ) ) ||
+					( ( fields & SEARCH_TYPE ) && containsQuery( getString( show->type ), query, mode ) ) ) {
+				searched = expected < count && positions[expected] == position;
+				expected++;
+			}
+		}
+		searched = searched && count == expected;
+	}
+	CHECK( searched );
+	CHECK( searchShows( "zzzz", SEARCH_ALL_FIELDS, SEARCH_SUBSTRING, 0, positions, numShows ) == 0 );
+	CHECK( searchShows( "", SEARCH_ALL_FIELDS, SEARCH_SUBSTRING, 10, positions, numShows ) == numShows - 10 );
+	free( positions );
+}
+
+int main( int argc, char* argv[] ) {
+	if( argc < 2 ) {
+		printf( "Usage: %s <new directory> [seed]\n", argv[0] );
+		return 1;
+	}
+	if( makeDirectory( argv[1] ) != 0 || changeDirectory( argv[1] ) != 0 || makeDirectory( "data" ) != 0 ||
+			writeDataset() != 0 ) {
+		printf( "Cannot create a dataset in %s\n", argv[1] );
+		return 1;
+	}
+	srand( argc > 2 ? (unsigned)atoi( argv[2] ) : 1 );
+	report = duplicateOutput();
+	if( report == NULL || freopen( NULL_DEVICE, "w", stdout ) == NULL || freopen( NULL_DEVICE, "r", stdin ) == NULL ) {
+		return 1;
+	}
+	testSeatLists();
+	if( !loadDataset() ) {
+		fprintf( report, "Cannot load the dataset under %s\n", argv[1] );
+		return 1;
+	}
+	testJournalReplay();
+	testHoldExpiry();
+	testFilterAndSearch();
+	freeTickets();
+	freeShows();
+	fprintf( report, failures == 0 ? "all tests passed\n" : "%d checks failed\n", failures );
+	return failures == 0 ? 0 : 1;
+}
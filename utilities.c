@@ -10,17 +10,20 @@
 #include <time.h>
 #include <stddef.h>
 #include "../include/utilities.h"
+#include "../include/catalog.h"
+#include "../include/tickets.h"
+#include "../include/booking.h"
+#include "../include/stats.h"
+#include "../include/pager.h"
+#include "../include/holds.h"
+#include "../include/search.h"
 
-#define MAX_SHOW 100
-#define MAX_TICKET 200
 #define MAX_FIELD 200
 
-#define SHOWS_DATABASE "data/shows.txt"
-#define TICKETS_DATABASE "data/tickets.txt"
-
 #ifdef _WIN32
 
 #include <windows.h>
+#include <io.h>
 
 /**
  * @brief Function to disable terminal echo (Windows)
@@ -45,6 +48,7 @@ void enableEcho() {
 #else
 
 #include <termios.h>
+#include <unistd.h>
 
 /**
  * @brief Function to disable terminal echo (Unix-like systems)
@@ -68,318 +72,412 @@ void enableEcho() {
 
 #endif
 
+static const char* monthNames[12] = {
+	"January", "February", "March", "April", "May", "June",
+	"July", "August", "September", "October", "November", "December"
+};
+
+/**
+ * @brief Convert a calendar date to a day number.
+ *
+ * Years start in March so that the leap day is the last day of a year and month lengths follow a fixed pattern.
+ *
+ * @param year The year.
+ * @param month The month, from 1 to 12.
+ * @param day The day of the month.
+ * @return The day number.
+ */
+static int toDayNumber( int year, int month, int day ) {
+	if( month <= 2 ) {
+		year--;
+		month += 12;
+	}
+	return 365 * year + year / 4 - year / 100 + year / 400 + ( 153 * ( month - 3 ) + 2 ) / 5 + day - 1;
+}
+
+/**
+ * @brief Convert a show date to a day number.
+ *
+ * Day numbers count days from 1 March of year 0, so later dates have larger numbers.
+ *
+ * @param date The show date in the format "day,month,year"; it need not be null-terminated.
+ * @param length Length of the date.
+ * @return The day number, or 0 if the date is malformed.
+ */
+int parseDate( const char* date, size_t length ) {
+	int parts[3] = { 0, 0, 0 };
+	int part = 0;
+	bool digits = false;
+	for( size_t i = 0; i < length; i++ ) {
+		if( date[i] >= '0' && date[i] <= '9' && parts[part] < 100000 ) {
+			parts[part] = parts[part] * 10 + ( date[i] - '0' );
+			digits = true;
+		} else if( date[i] == ',' && digits && part < 2 ) {
+			part++;
+			digits = false;
+		} else if( date[i] != ' ' ) {
+			return 0;
+		}
+	}
+	if( part != 2 || !digits || parts[0] < 1 || parts[0] > 31 || parts[1] < 1 || parts[1] > 12 || parts[2] < 1 ) {
+		return 0;
+	}
+	return toDayNumber( parts[2], parts[1], parts[0] );
+}
+
+/**
+ * @brief Get the current local date as a day number.
+ *
+ * @return The day number of today.
+ */
+int getCurrentDay() {
+	time_t now = time( NULL );
+	struct tm today;
+	#if defined(_WIN32) || defined(_WIN64)
+	localtime_s( &today, &now );
+	#else
+	localtime_r( &now, &today );
+	#endif
+	return toDayNumber( today.tm_year + 1900, today.tm_mon + 1, today.tm_mday );
+}
+
+/**
+ * @brief Format a day number as "day month, year", such as "05 March, 2025".
+ *
+ * @param day The day number.
+ * @param outputDate The output buffer.
+ * @param outputSize The size of the output buffer.
+ */
+void formatDate( int day, char* outputDate, int outputSize ) {
+	int era = day / 146097;
+	int dayOfEra = day - era * 146097;
+	int yearOfEra = ( dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096 ) / 365;
+	int year = era * 400 + yearOfEra;
+	int dayOfYear = dayOfEra - ( 365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100 );
+	int monthIndex = ( 5 * dayOfYear + 2 ) / 153;
+	int dayOfMonth = dayOfYear - ( 153 * monthIndex + 2 ) / 5 + 1;
+	int month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+	if( month <= 2 ) {
+		year++;
+	}
+	snprintf( outputDate, outputSize, "%02d %s, %d", dayOfMonth, monthNames[month - 1], year );
+}
+
+/**
+ * @brief Format one show for the pager.
+ *
+ * @param serial Number of the show as shown to the user.
+ * @param position Position of the show in date order.
+ */
+static void renderShowAt( int serial, int position ) {
+	const Show* show = getShowByDateOrder( position );
+	char formattedDate[30];
+	formatDate( show->day, formattedDate, sizeof( formattedDate ) );
+	appendOutput( "\t[0]Show: %d\n\t[0]Singer: %s\n\t[0]Date: %s\n\t[0]Venue: %s\n\t[0]Type: %s\n"
+			"\t[0]Available Seats: %d\n\n\n", serial, getString( show->singer ), formattedDate,
+			getString( show->venue ), getString( show->type ), getAvailableSeats( show ) );
+}
+
+/**
+ * @brief Format one upcoming show for the pager.
+ *
+ * @param serial Number of the show as shown to the user.
+ * @param item Offset of the show from the first upcoming show in date order.
+ * @param context Pointer to the date order position of the first upcoming show.
+ */
+static void renderShow( int serial, int item, void* context ) {
+	renderShowAt( serial, *(int*)context + item );
+}
+
+/**
+ * @brief Format one show found by a search for the pager.
+ *
+ * @param serial Number of the show as shown to the user.
+ * @param item Position of the show among the found shows.
+ * @param context The date order positions of the found shows.
+ */
+static void renderFoundShow( int serial, int item, void* context ) {
+	renderShowAt( serial, ( (int*)context )[item] );
+}
+
 /**
  * @brief View upcoming shows and their available seats.
  *
- * This function reads the show details from the specified file and displays the upcoming shows along with their
- * available seats. It also allows selecting a show based on user input.
+ * This function walks the resident catalog in date order from today on and displays the upcoming shows one page at
+ * a time, formatting only the shows on screen. It also allows selecting a show based on user input.
  *
- * @param filename The name of the file containing show details.
  * @param userId The user ID.
  * @param viewContent A flag indicating whether to display the show details.
  * @param hasSelect A flag indicating whether to allow show selection.
  * @param hasMenu A flag indicating whether to display a menu.
  * @return The selected show ID if `hasSelect` is true and a show is selected, otherwise -1.
  */
-int viewUpcomingShows( const char* filename, int userId, bool viewContent, bool hasSelect, bool hasMenu ) {
-	// Open the file for reading
-	FILE* file = fopen( filename, "r" );
-	if( file == NULL ) {
-		return -1;
-	}
-	Show shows[100];
-	char line[MAX_LENGTH];
-	fgets( line, sizeof( line ), file );
-	int numShows = 0;
-	int serial = 1;
-	time_t now = time( NULL );
-	struct tm* timeinfo = localtime( &now );
-	int currentYear = timeinfo->tm_year + 1900;
-	int currentMonth = timeinfo->tm_mon + 1;
-	int currentDay = timeinfo->tm_mday;
-	int availableShowId[MAX_SHOW];
-	while( fgets( line, sizeof( line ), file ) ) {
-		sscanf( line, "%d|%[^|]|%[^|]|%[^|]|%[^|]|%d|%d|%[^\n]", &shows[numShows].id, shows[numShows].singer,
-				shows[numShows].date, shows[numShows].venue, shows[numShows].type, &shows[numShows].price,
-				&shows[numShows].seats, shows[numShows].booked );
-		int showYear, showMonth, showDay;
-		sscanf( shows[numShows].date, "%d,%d,%d", &showDay, &showMonth, &showYear );
-		if( viewContent ) {
-			if( showYear > currentYear || ( showYear == currentYear && showMonth > currentMonth ) ||
-					( showYear == currentYear && showMonth == currentMonth && showDay >= currentDay ) ) {
-				char formattedDate[30];
-				convertDate( shows[numShows].date, formattedDate, sizeof( formattedDate ) );
-				availableShowId[serial - 1] = shows[numShows].id;
-				int bookedSeats = countBookedSeats( shows[numShows].booked );
-				int availableSeats = shows[numShows].seats - bookedSeats;
-				printf( "\t[0]Show: %d\n", serial );
-				printf( "\t[0]Singer: %s\n", shows[numShows].singer );
-				printf( "\t[0]Date: %s\n", formattedDate );
-				printf( "\t[0]Venue: %s\n", shows[numShows].venue );
-				printf( "\t[0]Type: %s\n", shows[numShows].type );
-				printf( "\t[0]Available Seats: %d\n", availableSeats );
-				printf( "\n\n" );
-				serial++;
-			}
-		}
-		numShows++;
-	}
-	fclose( file );
-	if( serial - 1 == 0 ) {
+int viewUpcomingShows( int userId, bool viewContent, bool hasSelect, bool hasMenu ) {
+	StatTimer timer;
+	startTimer( &timer, STAT_VIEW_SHOWS );
+	releaseExpiredHolds();
+	int first = findFirstShowOnOrAfter( getCurrentDay() );
+	int numUpcoming = viewContent ? getShowCount() - first : 0;
+	if( numUpcoming == 0 ) {
+		stopTimer( &timer );
 		printf( "No shows found!\n" );
 		return -1;
 	}
-	if( hasSelect ) {
-		printf( "Select a show " );
-		int selectedCustomSerial = selectPopup( serial );
-		return availableShowId[selectedCustomSerial - 1];
-	}
-	return -1;
+	Pager pager;
+	initPager( &pager, numUpcoming, renderShow, &first, "show", hasSelect );
+	showPage( &pager );
+	stopTimer( &timer );
+	int selected = runPager( &pager );
+	return selected >= 0 ? getShowByDateOrder( first + selected )->id : -1;
 }
 
 /**
- * @brief Count the number of booked seats.
+ * @brief Search the upcoming shows by singer, venue or type and view the matches.
  *
- * This helper function counts the number of booked seats from the given string of booked seats.
- *
- * @param bookedSeats The string containing the booked seats, separated by commas.
- * @return The count of booked seats.
+ * Reads the query from its own line. Matches are found through the search index and listed in date order, one
+ * page at a time.
  */
-int countBookedSeats( const char* bookedSeats ) {
-	int count = 0;
-	char* token = strtok( bookedSeats, "," );
-	while( token != NULL ) {
-		count++;
-		token = strtok( NULL, "," );
+void searchUpcomingShows() {
+	printf( "Search singer, venue or type: " );
+	scanf( "%*[^\n]" );
+	scanf( "%*c" );
+	char query[MAX_LENGTH];
+	if( fgets( query, sizeof( query ), stdin ) == NULL ) {
+		return;
 	}
-	return count;
+	query[strcspn( query, "\n" )] = '\0';
+	StatTimer timer;
+	startTimer( &timer, STAT_VIEW_SHOWS );
+	releaseExpiredHolds();
+	int first = findFirstShowOnOrAfter( getCurrentDay() );
+	int numUpcoming = getShowCount() - first;
+	int* positions = malloc( sizeof( int ) * ( numUpcoming + 1 ) );
+	int found = positions != NULL ? searchShows( query, SEARCH_ALL_FIELDS, SEARCH_SUBSTRING, first, positions,
+												 numUpcoming ) : -1;
+	if( found <= 0 ) {
+		stopTimer( &timer );
+		printf( found == 0 ? "No shows found!\n" : "System error, please contact with respective developers.\n" );
+		free( positions );
+		return;
+	}
+	Pager pager;
+	initPager( &pager, found, renderFoundShow, positions, "show", false );
+	showPage( &pager );
+	stopTimer( &timer );
+	runPager( &pager );
+	free( positions );
 }
 
 /**
- * @brief Select and return number
- * @param serial Number of array
- * @return The ID of the selected show
+ * @brief Count the number of booked seats.
+ *
+ * This helper function counts the number of booked seats in the given seat map.
+ *
+ * @param bookedSeats The seat map of the show.
+ * @return The count of booked seats.
  */
-int selectPopup( int serial ) {
-	int selectedCustomSerial = -1;
-	int validInput = 0;
-	while( !validInput ) {
-		printf( "(-1 to cancel): " );
-		scanf( "%d", &selectedCustomSerial );
-		if( selectedCustomSerial >= 1 && selectedCustomSerial <= serial ) {
-			validInput = 1;
-		} else if( selectedCustomSerial == -1 ) {
-			printf( "Canceled.\n" );
-			validInput = 1;
-			return -1;
-		} else {
-			printf( "Invalid selection. Please try again.\n" );
-		}
-	}
-	return selectedCustomSerial;
+int countBookedSeats( const Bitmap* bookedSeats ) {
+	return bitmapCount( bookedSeats );
 }
 
 /**
- * @brief Buy tickets for the specified seat numbers.
+ * @brief Let the user pick seats and pay for them, then book them.
+ *
+ * Free seats are listed as ranges. Entering 0 as the first seat lets the seat allocator pick adjacent seats. The
+ * picked seats are held for the user while they pay, so nobody else can book them in the meantime.
  *
- * @param tickets tickets array of tickets
- * @param shows shows array of shows
- * @param ticketFilename The name of the tickets database file.
- * @param showFilename The name of the shows database file.
+ * @param show The show.
  * @param userId The ID of the user.
- * @param showId The ID of the show.
+ * @param seat_quantity Number of seats to buy.
+ * @param seat_numbers Buffer for seat_quantity seat numbers.
+ * @param booked Buffer for seat_quantity booked tickets.
  */
-void buyTicket( Ticket tickets[], Show shows[], const char* ticketFilename, const char* showFilename, int userId, int showId ) {
-	srand( time( NULL ) );
-	FILE *fileTicket = fopen( ticketFilename, "r" );
-	FILE *fileShow = fopen( showFilename, "r" );
-	if( fileTicket == NULL ) {
-		printf( "System error, please contact with respective developers..\n" );
-		return;
-	}
-	if( fileShow == NULL ) {
-		printf( "System error, please contact with respective developers..\n" );
-		fclose( fileShow );
-		return;
-	}
-	int numTickets = 0;
-	int numShows = 0;
-	char line[MAX_LENGTH * 3];
-	fgets( line, sizeof( line ), fileTicket );
-	fgets( line, sizeof( line ), fileShow );
-	while( fgets( line, sizeof( line ), fileTicket ) ) {
-		sscanf( line, "%d|%[^|]|%d|%d|%d|%[^|]|%[^|]|%[^|]|%d", &( tickets[numTickets].id ),
-				tickets[numTickets].ticketNumber,
-				&( tickets[numTickets].userId ),
-				&( tickets[numTickets].showId ),
-				&( tickets[numTickets].seatNumber ),
-				tickets[numTickets].paymentMethod,
-				tickets[numTickets].paymentAccount,
-				tickets[numTickets].transactionNumber,
-				&( tickets[numTickets].status ) );
-		numTickets++;
-	}
-	while( fgets( line, sizeof( line ), fileShow ) ) {
-		sscanf( line, "%d|%[^|]|%[^|]|%[^|]|%[^|]|%d|%d|%[^\n]", &( shows[numShows].id ),
-				shows[numShows].singer,
-				shows[numShows].date,
-				shows[numShows].venue,
-				shows[numShows].type,
-				&( shows[numShows].price ),
-				&( shows[numShows].seats ),
-				shows[numShows].booked );
-		numShows++;
+static void purchaseSeats( Show* show, int userId, int seat_quantity, int seat_numbers[], BookedTicket booked[] ) {
+	printf( "Available seats: " );
+	int isFirst = 1;
+	int length;
+	for( int j = findFreeSeatRun( show, 1, show->seats + 1, &length ); j >= 0;
+			j = findFreeSeatRun( show, j + length, show->seats + 1, &length ) ) {
+		if( !isFirst ) {
+			printf( ", " );
+		}
+		isFirst = 0;
+		if( length > 2 ) {
+			printf( "%d-%d", j, j + length - 1 );
+		} else if( length == 2 ) {
+			printf( "%d, %d", j, j + 1 );
+		} else {
+			printf( "%d", j );
+		}
 	}
-	fclose( fileTicket );
-	fclose( fileShow );
-	for( int i = 0; i < numShows; ++i ) {
-		if( shows[i].id == showId ) {
-			printf( "Cost for %s's %s show is %d BDT/ticket\n", shows[i].singer, shows[i].type, shows[i].price );
-			int seat_quantity;
-			printf( "How many seats do you want to buy? (1 seat/ticket): " );
-			scanf( "%d", &seat_quantity );
-			int seat_numbers[seat_quantity];
-			printf( "Available seats: " );
-			int j;
-			int isFirst = 1;
-			for( j = 1; j <= shows[i].seats; j++ ) {
-				if( strstr( shows[i].booked, itoa( j, line, 10 ) ) == NULL ) {
-					if( isFirst ) {
-						printf( "%d", j );
-						isFirst = 0;
-					} else {
-						printf( ", %d", j );
-					}
-				}
-			}
-			char ticketNumbers[seat_quantity][10];
-			printf( "\nSelect seat(s) from above available seat(s): " );
-			for( int k = 0; k < seat_quantity; ++k ) {
-				int seat_number;
-				scanf( "%d", &seat_number );
-				for( int m = 0; m < k; ++m ) {
-					if( seat_number == seat_numbers[m] ) {
-						printf( "Duplicate seat number detected! Please select unique seats.\n" );
-						return;
-					}
-				}
-				if( strstr( shows[i].booked, itoa( seat_number, line, 10 ) ) != NULL ) {
-					printf( "Seat number %d is already booked!\n", seat_number );
-					return;
-				}
-				seat_numbers[k] = seat_number;
-				generateRandomCode( ticketNumbers[k], 10 );
-			}
-			printf( "You have selected %d (", seat_quantity );
-			for( int k = 0; k < seat_quantity; ++k ) {
-				printf( "%d", seat_numbers[k] );
-				if( k + 1 != seat_quantity ) {
-					printf( ", " );
-				}
-			}
-			printf( ") totaling %d BDT\n", shows[i].price * seat_quantity );
-			const char *payment_method;
-			printf( "Please select a payment method\n" );
-			printf( "\t1.bKash\n" );
-			printf( "\t2.Nagad\n" );
-			printf( "\t3.Rocket\n" );
-			printf( "Select: " );
-			int payment_m;
-			scanf( "%d", &payment_m );
-			if( payment_m >= 1 && payment_m <= 3 ) {
-				if( payment_m == 1 ) {
-					payment_method = "bKash";
-				} else if( payment_m == 2 ) {
-					payment_method = "Nagad";
-				} else {
-					payment_method = "Rocket";
-				}
-			} else {
+	printf( "\nSelect seat(s) from above available seat(s), or 0 for the best adjacent seats: " );
+	for( int k = 0; k < seat_quantity; ++k ) {
+		int seat_number;
+		scanf( "%d", &seat_number );
+		if( k == 0 && seat_number == 0 ) {
+			int first = findAdjacentSeats( show, seat_quantity, 0, true );
+			if( first < 0 ) {
+				printf( "There are no %d adjacent free seats!\n", seat_quantity );
 				return;
 			}
-			scanf( "%*[^\n]" );
-			scanf( "%*c" );
-			printf( "Please enter your %s account number: ", payment_method );
-			char payment_account[MAX_FIELD];
-			fgets( payment_account, sizeof( payment_account ), stdin );
-			payment_account[strcspn( payment_account, "\n" )] = '\0';
-			char transactionNum[10];
-			generateTransactionNumber( transactionNum, sizeof( transactionNum ) );
-			printf( "\nThank you! Transaction ID %s, %d ticket(s) purchased, and %d BDT credited from your %s account (%s).\n", transactionNum, seat_quantity, shows[i].price * seat_quantity, payment_method, payment_account );
-			printf( "Purchased ticket(s):\n" );
-			for( int k = 0; k < seat_quantity; ++k ) {
-				printf( "\t%s\n", ticketNumbers[k] );
-				tickets[numTickets].id = numTickets;
-				strcpy( tickets[numTickets].ticketNumber, ticketNumbers[k] );
-				tickets[numTickets].userId = userId;
-				tickets[numTickets].showId = showId;
-				tickets[numTickets].seatNumber = seat_numbers[k];
-				strcpy( tickets[numTickets].paymentMethod, payment_method );
-				strcpy( tickets[numTickets].paymentAccount, payment_account );
-				strcpy( tickets[numTickets].transactionNumber, transactionNum );
-				tickets[numTickets].status = 1;
-				numTickets++;
+			for( int m = 0; m < seat_quantity; ++m ) {
+				seat_numbers[m] = first + m;
 			}
-			char updatedBooked[MAX_LENGTH] = "";
-			strcpy( updatedBooked, shows[i].booked );
-			for( int j = 0; j < seat_quantity; j++ ) {
-				int selectedSeat = seat_numbers[j];
-				if( strstr( shows[i].booked, itoa( selectedSeat, line, 10 ) ) == NULL ) {
-					if( strlen( shows[i].booked ) > 0 || j > 0 ) {
-						strcat( updatedBooked, "," );
-					}
-					sprintf( line, "%d", selectedSeat );
-					strcat( updatedBooked, line );
-				}
-			}
-			strcpy( shows[i].booked, updatedBooked );
 			break;
 		}
+		for( int m = 0; m < k; ++m ) {
+			if( seat_number == seat_numbers[m] ) {
+				printf( "Duplicate seat number detected! Please select unique seats.\n" );
+				return;
+			}
+		}
+		if( seat_number < 1 || seat_number > show->seats ) {
+			printf( "Seat number %d does not exist!\n", seat_number );
+			return;
+		}
+		if( !isSeatFree( show, seat_number ) ) {
+			printf( "Seat number %d is already booked!\n", seat_number );
+			return;
+		}
+		seat_numbers[k] = seat_number;
 	}
-	fileTicket = fopen( ticketFilename, "w" );
-	fileShow = fopen( showFilename, "w" );
-	if( fileTicket == NULL ) {
-		printf( "System error, please contact with respective developers.\n" );
+	printf( "You have selected %d (", seat_quantity );
+	for( int k = 0; k < seat_quantity; ++k ) {
+		printf( "%d", seat_numbers[k] );
+		if( k + 1 != seat_quantity ) {
+			printf( ", " );
+		}
+	}
+	printf( ") totaling %d BDT\n", show->price * seat_quantity );
+	int holdId = holdSeats( userId, show->id, seat_numbers, seat_quantity );
+	if( holdId < 0 ) {
+		printf( "Booking failed: %s\n", getBookingError( holdId ) );
 		return;
 	}
-	if( fileShow == NULL ) {
-		printf( "System error, please contact with respective developers.\n" );
-		fclose( fileShow );
+	printf( "Your seats are held for %d seconds.\n", getHoldSeconds() );
+	const char *payment_method;
+	printf( "Please select a payment method\n" );
+	printf( "\t1.bKash\n" );
+	printf( "\t2.Nagad\n" );
+	printf( "\t3.Rocket\n" );
+	printf( "Select: " );
+	int payment_m;
+	scanf( "%d", &payment_m );
+	if( payment_m >= 1 && payment_m <= 3 ) {
+		if( payment_m == 1 ) {
+			payment_method = "bKash";
+		} else if( payment_m == 2 ) {
+			payment_method = "Nagad";
+		} else {
+			payment_method = "Rocket";
+		}
+	} else {
+		releaseHold( holdId, userId );
 		return;
 	}
-	fprintf( fileTicket, "id|ticket_number|user_id|show_id|seat_number|payment_method|payment_account|transaction_number|status\n" );
-	fprintf( fileShow, "id|singer|date|type|price|seats|booked\n" );
-	for( int i = 0; i < numTickets; i++ ) {
-		fprintf( fileTicket, "%d|%s|%d|%d|%d|%s|%s|%s|%d\n", tickets[i].id,
-				 tickets[i].ticketNumber,
-				 tickets[i].userId,
-				 tickets[i].showId,
-				 tickets[i].seatNumber,
-				 tickets[i].paymentMethod,
-				 tickets[i].paymentAccount,
-				 tickets[i].transactionNumber,
-				 tickets[i].status );
+	scanf( "%*[^\n]" );
+	scanf( "%*c" );
+	char payment_account[MAX_FIELD];
+	char transactionNum[TRANSACTION_NUMBER_LENGTH];
+	int result;
+	do {
+		printf( "Please enter your %s account number: ", payment_method );
+		if( fgets( payment_account, sizeof( payment_account ), stdin ) == NULL ) {
+			releaseHold( holdId, userId );
+			return;
+		}
+		payment_account[strcspn( payment_account, "\n" )] = '\0';
+		result = confirmHold( holdId, userId, payment_method, payment_account, seat_quantity, booked, transactionNum );
+		if( result == BOOKING_BAD_PAYMENT ) {
+			printf( "The account number must not be empty or contain '|'.\n" );
+		}
+	} while( result == BOOKING_BAD_PAYMENT );
+	if( result == BOOKING_NO_HOLD ) {
+		printf( "Your seat hold has expired, please select the seats again.\n" );
+		return;
+	} else if( result < 0 ) {
+		printf( "Booking failed: %s\n", getBookingError( result ) );
+		return;
+	}
+	printf( "\nThank you! Transaction ID %s, %d ticket(s) purchased, and %d BDT credited from your %s account (%s).\n", transactionNum, seat_quantity, show->price * seat_quantity, payment_method, payment_account );
+	printf( "Purchased ticket(s):\n" );
+	for( int k = 0; k < seat_quantity; ++k ) {
+		printf( "\t%s\n", booked[k].ticketNumber );
+	}
+}
+
+/**
+ * @brief Buy tickets for the specified seat numbers.
+ *
+ * @param userId The ID of the user.
+ * @param showId The ID of the show.
+ */
+void buyTicket( int userId, int showId ) {
+	Show* show = getShowById( showId );
+	if( show == NULL ) {
+		return;
+	}
+	printf( "Cost for %s's %s show is %d BDT/ticket\n", getString( show->singer ), getString( show->type ), show->price );
+	int seat_quantity;
+	printf( "How many seats do you want to buy? (1 seat/ticket): " );
+	scanf( "%d", &seat_quantity );
+	releaseExpiredHolds();
+	int availableSeatCount = getAvailableSeats( show );
+	if( seat_quantity < 1 || seat_quantity > availableSeatCount ) {
+		printf( "Only %d seat(s) are available!\n", availableSeatCount );
+		return;
 	}
-	for( int i = 0; i < numShows; i++ ) {
-		fprintf( fileShow, "%d|%s|%s|%s|%s|%d|%d|%s\n",
-				 shows[i].id,
-				 shows[i].singer,
-				 shows[i].date,
-				 shows[i].venue,
-				 shows[i].type,
-				 shows[i].price,
-				 shows[i].seats,
-				 shows[i].booked );
+	int* seat_numbers = malloc( sizeof( int ) * seat_quantity );
+	BookedTicket* booked = malloc( sizeof( BookedTicket ) * seat_quantity );
+	if( seat_numbers != NULL && booked != NULL ) {
+		purchaseSeats( show, userId, seat_quantity, seat_numbers, booked );
 	}
-	fclose( fileTicket );
-	fclose( fileShow );
+	free( seat_numbers );
+	free( booked );
+}
+
+/**
+ * @brief Tickets listed by showTicketsByUserId().
+ */
+typedef struct {
+	int* tickets;
+	int today;
+} TicketListing;
+
+/**
+ * @brief Format one ticket for the pager.
+ *
+ * @param serial Number of the ticket as shown to the user.
+ * @param item Position of the ticket in the listing.
+ * @param context The TicketListing.
+ */
+static void renderTicket( int serial, int item, void* context ) {
+	const TicketListing* listing = context;
+	const Ticket* ticket = getTicketByIndex( listing->tickets[item] );
+	const Show* show = getShowById( ticket->showId );
+	appendOutput( "\t[0]Ticket: %d\n\t[0]Ticket Number: %s\n", serial, getString( ticket->ticketNumber ) );
+	if( show != NULL ) {
+		appendOutput( "\t[0]Show: %s's %s show\n\t[0]Venue: %s\n", getString( show->singer ), getString( show->type ),
+				getString( show->venue ) );
+	}
+	appendOutput( "\t[0]Seat Number: %d\n\t[0]Payment Method: %s\n\t[0]Payment Account: %s\n"
+			"\t[0]Transaction Number: %s\n", ticket->seatNumber, getString( ticket->paymentMethod ),
+			getString( ticket->paymentAccount ), getString( ticket->transactionNumber ) );
+	if( !ticket->status ) {
+		appendOutput( "\t[0]Status: Canceled\n" );
+	} else if( show != NULL && show->day >= listing->today ) {
+		appendOutput( "\t[0]Status: Active\n" );
+	} else if( show != NULL ) {
+		appendOutput( "\t[0]Status: Expired\n" );
+	}
+	appendOutput( "\n\n" );
 }
 
 /**
  * @brief Displays show tickets based on a user ID and allows the user to select a ticket.
  *
- * @param tickets       Array of tickets.
- * @param ticketFilename The name of the tickets database file.
+ * Tickets are shown one page at a time; only the tickets on screen are formatted.
+ *
  * @param userId        ID of the user to filter the tickets.
  * @param viewContent        Whether it show content
  * @param hasSelect        Selection enabled?
@@ -388,234 +486,40 @@ void buyTicket( Ticket tickets[], Show shows[], const char* ticketFilename, cons
  *
  * @return The ID of the selected ticket, or -1 if no ticket is selected.
  */
-int showTicketsByUserId( const Ticket tickets[], const char* ticketFilename, int userId, bool viewContent, bool hasSelect, bool hasMenu, bool forBooking ) {
-	FILE* file = fopen( SHOWS_DATABASE, "r" );
-	if( file == NULL ) {
+int showTicketsByUserId( int userId, bool viewContent, bool hasSelect, bool hasMenu, bool forBooking ) {
+	StatTimer timer;
+	startTimer( &timer, STAT_LIST_TICKETS );
+	TicketListing listing;
+	listing.tickets = malloc( sizeof( int ) * ( getUserTicketCount( userId ) + 1 ) );
+	if( listing.tickets == NULL ) {
+		stopTimer( &timer );
 		return -1;
 	}
-	Show shows[100];
-	char line[MAX_LENGTH];
-	fgets( line, sizeof( line ), file );
-	int numShows = 0;
-	while( fgets( line, sizeof( line ), file ) ) {
-		sscanf( line, "%d|%[^|]|%[^|]|%[^|]|%[^|]|%d|%d|%[^\n]", &shows[numShows].id, shows[numShows].singer,
-				shows[numShows].date, shows[numShows].venue, shows[numShows].type, &shows[numShows].price,
-				&shows[numShows].seats, shows[numShows].booked );
-		numShows++;
-	}
-	FILE *fileTicket = fopen( ticketFilename, "r" );
-	if( fileTicket == NULL ) {
-		printf( "System error, please contact with respective developers..\n" );
-	}
+	listing.today = getCurrentDay();
 	int numTickets = 0;
-	fgets( line, sizeof( line ), fileTicket );
-	while( fgets( line, sizeof( line ), fileTicket ) ) {
-		sscanf( line, "%d|%[^|]|%d|%d|%d|%[^|]|%[^|]|%[^|]|%d", &( tickets[numTickets].id ),
-				tickets[numTickets].ticketNumber,
-				&( tickets[numTickets].userId ),
-				&( tickets[numTickets].showId ),
-				&( tickets[numTickets].seatNumber ),
-				tickets[numTickets].paymentMethod,
-				tickets[numTickets].paymentAccount,
-				tickets[numTickets].transactionNumber,
-				&( tickets[numTickets].status ) );
-		numTickets++;
-	}
-	fclose( fileTicket );
-	int serial = 1;
-	int availableTickets[MAX_TICKET];
-	if( !forBooking ) {
-		for( int i = 0; i < numTickets; ++i ) {
-			if( tickets[i].userId == userId ) {
-				availableTickets[serial - 1] = tickets[i].id;
-				if( viewContent ) {
-					printf( "\t[0]Ticket: %d\n", serial );
-					printf( "\t[0]Ticket Number: %s\n", tickets[i].ticketNumber );
-					for( int x = 0; x < numShows; ++x ) {
-						if( tickets[i].showId == shows[x].id ) {
-							printf( "\t[0]Show: %s's %s show\n", shows[x].singer, shows[x].type );
-							printf( "\t[0]Venue: %s\n", shows[x].venue );
-						}
-					}
-					printf( "\t[0]Seat Number: %d\n", tickets[i].seatNumber );
-					printf( "\t[0]Payment Method: %s\n", tickets[i].paymentMethod );
-					printf( "\t[0]Payment Account: %s\n", tickets[i].paymentAccount );
-					printf( "\t[0]Transaction Number: %s\n", tickets[i].transactionNumber );
-					if( tickets[i].status ) {
-						for( int x = 0; x < numShows; ++x ) {
-							if( tickets[i].showId == shows[x].id ) {
-								time_t now = time( NULL );
-								struct tm* timeinfo = localtime( &now );
-								int currentYear = timeinfo->tm_year + 1900;
-								int currentMonth = timeinfo->tm_mon + 1;
-								int currentDay = timeinfo->tm_mday;
-								int showYear, showMonth, showDay;
-								sscanf( shows[x].date, "%d,%d,%d", &showDay, &showMonth, &showYear );
-								if( showYear > currentYear || ( showYear == currentYear && showMonth > currentMonth ) ||
-										( showYear == currentYear && showMonth == currentMonth && showDay >= currentDay ) ) {
-									printf( "\t[0]Status: Active\n" );
-								} else {
-									printf( "\t[0]Status: Expired\n" );
-								}
-							}
-						}
-					} else {
-						printf( "\t[0]Status: Canceled\n" );
-					}
-					printf( "\n\n" );
-				}
-				++serial;
-			}
-		}
-	} else {
-		for( int i = 0; i < numTickets; ++i ) {
-			for( int x = 0; x < numShows; ++x ) {
-				if( tickets[i].showId == shows[x].id ) {
-					time_t now = time( NULL );
-					struct tm* timeinfo = localtime( &now );
-					int currentYear = timeinfo->tm_year + 1900;
-					int currentMonth = timeinfo->tm_mon + 1;
-					int currentDay = timeinfo->tm_mday;
-					int showYear, showMonth, showDay;
-					sscanf( shows[x].date, "%d,%d,%d", &showDay, &showMonth, &showYear );
-					if( tickets[i].userId == userId && ( showYear > currentYear || ( showYear == currentYear && showMonth > currentMonth ) ||
-														 ( showYear == currentYear && showMonth == currentMonth && showDay >= currentDay ) ) ) {
-						availableTickets[serial - 1] = tickets[i].id;
-						if( viewContent ) {
-							printf( "\t[0]Ticket: %d\n", serial );
-							printf( "\t[0]Ticket Number: %s\n", tickets[i].ticketNumber );
-							for( int x = 0; x < numShows; ++x ) {
-								if( tickets[i].showId == shows[x].id ) {
-									printf( "\t[0]Show: %s's %s show\n", shows[x].singer, shows[x].type );
-									printf( "\t[0]Venue: %s\n", shows[x].venue );
-								}
-							}
-							printf( "\t[0]Seat Number: %d\n", tickets[i].seatNumber );
-							printf( "\t[0]Payment Method: %s\n", tickets[i].paymentMethod );
-							printf( "\t[0]Payment Account: %s\n", tickets[i].paymentAccount );
-							printf( "\t[0]Transaction Number: %s\n", tickets[i].transactionNumber );
-							if( tickets[i].status ) {
-								for( int x = 0; x < numShows; ++x ) {
-									if( tickets[i].showId == shows[x].id ) {
-										time_t now = time( NULL );
-										struct tm* timeinfo = localtime( &now );
-										int currentYear = timeinfo->tm_year + 1900;
-										int currentMonth = timeinfo->tm_mon + 1;
-										int currentDay = timeinfo->tm_mday;
-										int showYear, showMonth, showDay;
-										sscanf( shows[x].date, "%d,%d,%d", &showDay, &showMonth, &showYear );
-										if( showYear > currentYear || ( showYear == currentYear && showMonth > currentMonth ) ||
-												( showYear == currentYear && showMonth == currentMonth && showDay >= currentDay ) ) {
-											printf( "\t[0]Status: Active\n" );
-										} else {
-											printf( "\t[0]Status: Expired\n" );
-										}
-									}
-								}
-							} else {
-								printf( "\t[0]Status: Canceled\n" );
-							}
-							printf( "\n\n" );
-						}
-						++serial;
-					}
-				}
-			}
+	for( int index = getFirstUserTicket( userId ); index >= 0; index = getNextUserTicket( index ) ) {
+		const Show* show = getShowById( getTicketByIndex( index )->showId );
+		if( forBooking && ( show == NULL || show->day < listing.today ) ) {
+			continue;
 		}
+		listing.tickets[numTickets++] = index;
 	}
-	if( serial - 1 == 0 ) {
+	if( numTickets == 0 ) {
+		stopTimer( &timer );
 		printf( "No tickets found!\n" );
+		free( listing.tickets );
 		return -1;
 	}
-	if( hasSelect ) {
-		printf( "Select a ticket " );
-		int selectedTicketId = selectPopup( serial );
-		return availableTickets[selectedTicketId - 1];
-	}
-	return -1;
-}
-
-/**
- * Update the booked field of a show by removing a seat number.
- *
- * @param booked The booked field string to update.
- * @param seatNumber The seat number to remove from the booked field.
- */
-void updateBookedField( char* booked, int seatNumber ) {
-	int length = strlen( booked );
-	int i, j;
-	int commaCount = 0;
-	for( i = 0; i < length; i++ ) {
-		if( booked[i] == ',' ) {
-			commaCount++;
-		}
-	}
-	char updatedBooked[length + 1];
-	memset( updatedBooked, '\0', sizeof( updatedBooked ) );
-	j = 0;
-	for( i = 0; i < length; i++ ) {
-		if( booked[i] != ',' ) {
-			int currentSeat = 0;
-			while( i < length && booked[i] != ',' ) {
-				currentSeat = ( currentSeat * 10 ) + ( booked[i] - '0' );
-				i++;
-			}
-			if( currentSeat != seatNumber ) {
-				sprintf( &updatedBooked[j], "%d", currentSeat );
-				j += strlen( &updatedBooked[j] );
-				if( i < length ) {
-					updatedBooked[j] = ',';
-					j++;
-				}
-			}
-		}
-	}
-	strcpy( booked, updatedBooked );
-}
-
-/**
- * Update the booked field of a show in the shows.txt file.
- *
- * @param showId The ID of the show to update.
- * @param seatNumber The seat number to remove from the booked field.
- */
-void updateBookedFieldInFile( int showId, int seatNumber ) {
-	Show shows[MAX_SHOW];
-	int numShows = 0;
-	FILE* file = fopen( SHOWS_DATABASE, "r" );
-	if( file == NULL ) {
-		printf( "System error\n" );
-		return;
-	}
-	char line[200];
-	fgets( line, sizeof( line ), file );
-	while( fgets( line, sizeof( line ), file ) != NULL && numShows < MAX_SHOW ) {
-		sscanf( line, "%d|%[^|]|%[^|]|%[^|]|%[^|]|%d|%d|%[^\n]",
-				&( shows[numShows].id ), shows[numShows].singer, shows[numShows].date, shows[numShows].venue,
-				shows[numShows].type, &( shows[numShows].price ), &( shows[numShows].seats ),
-				shows[numShows].booked );
-		numShows++;
-	}
-	fclose( file );
-	if( showId >= 0 && showId < numShows ) {
-		updateBookedField( shows[showId].booked, seatNumber );
-		file = fopen( SHOWS_DATABASE, "w" );
-		if( file == NULL ) {
-			printf( "Error opening file for writing: %s\n", SHOWS_DATABASE );
-			return;
-		}
-		fprintf( file, "id|singer|date|venue|type|price|seats|booked\n" );
-		for( int i = 0; i < numShows; i++ ) {
-			fprintf( file, "%d|%s|%s|%s|%s|%d|%d|%s\n",
-					 shows[i].id, shows[i].singer, shows[i].date, shows[i].venue,
-					 shows[i].type, shows[i].price, shows[i].seats,
-					 shows[i].booked );
-		}
-		fclose( file );
-		printf( "Ticket updated successfully\n" );
-	} else {
-		printf( "Invalid show ID\n" );
+	Pager pager;
+	initPager( &pager, numTickets, renderTicket, &listing, "ticket", hasSelect );
+	if( viewContent ) {
+		showPage( &pager );
 	}
+	stopTimer( &timer );
+	int selected = runPager( &pager );
+	int selectedId = selected >= 0 ? getTicketByIndex( listing.tickets[selected] )->id : -1;
+	free( listing.tickets );
+	return selectedId;
 }
 
 /**
@@ -626,22 +530,12 @@ void updateBookedFieldInFile( int showId, int seatNumber ) {
  * @param seatNumber Pointer to store the extracted seat number.
  */
 void getShowIDAndSeatNumber( int ticketId, int* showId, int* seatNumber ) {
-	FILE* file = fopen( TICKETS_DATABASE, "r" );
-	if( file == NULL ) {
-		printf( "System error\n" );
+	const Ticket* ticket = getTicketById( ticketId );
+	if( ticket == NULL ) {
 		return;
 	}
-	char line[1000];
-	while( fgets( line, sizeof( line ), file ) ) {
-		int currentTicketId, currentShowId, currentSeatNumber;
-		sscanf( line, "%d|%*[^|]|%*[^|]|%d|%d|%*[^|]|%*[^|]|%*[^|]|%*[^|]", &currentTicketId, &currentShowId, &currentSeatNumber );
-		if( currentTicketId == ticketId ) {
-			*showId = currentShowId;
-			*seatNumber = currentSeatNumber;
-			break;
-		}
-	}
-	fclose( file );
+	*showId = ticket->showId;
+	*seatNumber = ticket->seatNumber;
 }
 
 /**
@@ -651,118 +545,57 @@ void getShowIDAndSeatNumber( int ticketId, int* showId, int* seatNumber ) {
  * @param newStatus The new status for the ticket.
  */
 void updateTicketStatus( int ticketId, int newStatus ) {
-	Ticket tickets[MAX_TICKET];
-	int numTickets = 0;
-	FILE* file = fopen( TICKETS_DATABASE, "r" );
-	if( file == NULL ) {
-		printf( "System error\n" );
-		return;
-	}
-	char line[200];
-	fgets( line, sizeof( line ), file );
-	while( fgets( line, sizeof( line ), file ) != NULL && numTickets < MAX_TICKET ) {
-		sscanf( line, "%d|%[^|]|%d|%d|%d|%[^|]|%[^|]|%[^|]|%d",
-				&( tickets[numTickets].id ), tickets[numTickets].ticketNumber, &( tickets[numTickets].userId ),
-				&( tickets[numTickets].showId ), &( tickets[numTickets].seatNumber ),
-				tickets[numTickets].paymentMethod, tickets[numTickets].paymentAccount,
-				tickets[numTickets].transactionNumber, &( tickets[numTickets].status ) );
-		numTickets++;
-	}
-	fclose( file );
-	for( int i = 0; i < numTickets; i++ ) {
-		if( tickets[i].id == ticketId ) {
-			if( tickets[i].status == 0 ) {
-				printf( "Ticket is already canceled\n" );
-				break;
-			}
-			tickets[i].status = newStatus;
-			updateBookedFieldInFile( tickets[i].showId, tickets[i].seatNumber );
-		}
-	}
-	file = fopen( TICKETS_DATABASE, "w" );
-	if( file == NULL ) {
-		return;
-	}
-	fprintf( file, "id|ticket_number|user_id|show_id|seat_number|payment_method|payment_account|transaction_number|status\n" );
-	for( int i = 0; i < numTickets; i++ ) {
-		fprintf( file, "%d|%s|%d|%d|%d|%s|%s|%s|%d\n",
-				 tickets[i].id, tickets[i].ticketNumber, tickets[i].userId,
-				 tickets[i].showId, tickets[i].seatNumber,
-				 tickets[i].paymentMethod, tickets[i].paymentAccount,
-				 tickets[i].transactionNumber, tickets[i].status );
+	int result = changeTicketStatus( ticketId, -1, newStatus );
+	if( result == BOOKING_UNCHANGED && newStatus == 0 ) {
+		printf( "Ticket is already canceled\n" );
+	} else if( result == BOOKING_OK ) {
+		printf( "Ticket updated successfully\n" );
+	} else if( result == BOOKING_FAILED ) {
+		printf( "System error, please contact with respective developers.\n" );
 	}
-	fclose( file );
 }
 
 /**
- * @brief Generate a random code with the pattern of 3 letters, 5 numbers, and 1 letter.
+ * @brief Converts a date string from the format "day,month,year" to "day month, year".
  *
- * @param code The character array to hold the generated code.
- * @param codeLength The length of the code, including the null terminator.
- */
-void generateRandomCode( char* code, int codeLength ) {
-	const char* letters = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-	const char* numbers = "0123456789";
-	for( int i = 0; i < 3; i++ ) {
-		code[i] = letters[rand() % 26];
-	}
-	for( int i = 3; i < 8; i++ ) {
-		code[i] = numbers[rand() % 10];
-	}
-	code[8] = letters[rand() % 26];
-	code[codeLength - 1] = '\0';
-}
-
-/**
- * @brief Generate a random alphanumeric character.
+ * This function takes an input date string in the format "day,month,year" and converts it
+ * to the format "day month, year". The converted date is stored in the output buffer.
  *
- * @return The generated character.
+ * @param[out] inputDate The input date string in the format "day,month,year".
+ * @param[out] outputDate The output buffer to store the converted date.
+ * @param[in] outputSize The size of the output buffer.
  */
-char generateRandomChar() {
-	int randomNum = rand() % 36;
-	if( randomNum < 10 ) {
-		return '0' + randomNum;
-	} else {
-		return 'A' + ( randomNum - 10 );
-	}
+void convertDate( const char* inputDate, char* outputDate, int outputSize ) {
+	formatDate( parseDate( inputDate, strlen( inputDate ) ), outputDate, outputSize );
 }
 
 /**
- * @brief Generate a transaction number based on the current time.
+ * @brief Replace a file with a fully written temporary file.
  *
- * @param transactionNumber The array to store the generated transaction number.
- * @param size The size of the transactionNumber array.
+ * @param tempFilename The name of the temporary file.
+ * @param filename The name of the file to replace.
+ * @return 0 on success, -1 on failure.
  */
-void generateTransactionNumber( char* transactionNumber, size_t size ) {
-	time_t currentTime = time( NULL );
-	struct tm* timeinfo = localtime( &currentTime );
-	int hour = timeinfo->tm_hour;
-	int minute = timeinfo->tm_min;
-	int second = timeinfo->tm_sec;
-	char randomChars[4];
-	for( int i = 0; i < 3; i++ ) {
-		randomChars[i] = generateRandomChar();
-	}
-	randomChars[3] = '\0';
-	snprintf( transactionNumber, size, "%c%c%c%02d%02d%02d", randomChars[0], randomChars[1], randomChars[2], hour, minute, second );
+int replaceFile( const char* tempFilename, const char* filename ) {
+	#if defined(_WIN32) || defined(_WIN64)
+	remove( filename );
+	#endif
+	return rename( tempFilename, filename ) == 0 ? 0 : -1;
 }
 
 /**
- * @brief Converts a date string from the format "day,month,year" to "day month, year".
- *
- * This function takes an input date string in the format "day,month,year" and converts it
- * to the format "day month, year". The converted date is stored in the output buffer.
+ * @brief Write the buffered data of a file and wait until the operating system has it on disk.
  *
- * @param[out] inputDate The input date string in the format "day,month,year".
- * @param[out] outputDate The output buffer to store the converted date.
- * @param[in] outputSize The size of the output buffer.
+ * @param file The file.
+ * @return 0 on success, -1 on failure.
  */
-void convertDate( const char* inputDate, char* outputDate, int outputSize ) {
-	int day, month, year;
-	sscanf( inputDate, "%d,%d,%d", &day, &month, &year );
-	struct tm dateStruct = { 0 };
-	dateStruct.tm_mday = day;
-	dateStruct.tm_mon = month - 1;
-	dateStruct.tm_year = year - 1900;
-	strftime( outputDate, outputSize, "%d %B, %Y", &dateStruct );
+int syncFile( FILE* file ) {
+	if( fflush( file ) != 0 ) {
+		return -1;
+	}
+	#if defined(_WIN32) || defined(_WIN64)
+	return _commit( _fileno( file ) ) == 0 ? 0 : -1;
+	#else
+	return fsync( fileno( file ) ) == 0 ? 0 : -1;
+	#endif
 }
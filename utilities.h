@@ -5,33 +5,53 @@
 #ifndef UTILITIES_H
 #define UTILITIES_H
 
+#include <stdio.h>
 #include <stdbool.h>
+#include <time.h>
+#include "bitmap.h"
+#include "strpool.h"
 
 #define MAX_LENGTH 500
 
 /**
  * @brief Struct representing a show
+ *
+ * Text fields are handles into the string pool; read them with getString(). The date is also kept as a day number
+ * (see parseDate()) so that dates compare and sort as integers. The number of free seats is kept in step with the
+ * seat map by setSeatBooked(); read it with getAvailableSeats(). Seats reserved during payment are marked in a
+ * separate map of held seats, allocated on the first hold, which is never saved. The position of the show in date
+ * order is set whenever the catalog is loaded.
  */
 typedef struct {
 	int id;
-	char singer[MAX_LENGTH];
-	char date[MAX_LENGTH];
-	char venue[MAX_LENGTH];
-	char type[MAX_LENGTH];
+	StrId singer;
+	StrId date;
+	int day;
+	StrId venue;
+	StrId type;
 	int price;
 	int seats;
-	char booked[MAX_LENGTH];
+	int available;
+	Bitmap booked;
+	int heldSeats;
+	Bitmap held;
+	int position;
 } Show;
 
+/**
+ * @brief Struct representing a ticket
+ *
+ * Text fields are handles into the string pool; read them with getString().
+ */
 typedef struct {
 	int id;
-	char ticketNumber[MAX_LENGTH];
+	StrId ticketNumber;
 	int userId;
 	int showId;
 	int seatNumber;
-	char paymentMethod[MAX_LENGTH];
-	char paymentAccount[MAX_LENGTH];
-	char transactionNumber[MAX_LENGTH];
+	StrId paymentMethod;
+	StrId paymentAccount;
+	StrId transactionNumber;
 	int status;
 } Ticket;
 
@@ -44,55 +64,77 @@ void disableEcho();
  * @brief Function to enable terminal echo
  */
 void enableEcho();
+
+/**
+ * @brief Convert a show date to a day number.
+ *
+ * Day numbers count days from 1 March of year 0, so later dates have larger numbers.
+ *
+ * @param date The show date in the format "day,month,year"; it need not be null-terminated.
+ * @param length Length of the date.
+ * @return The day number, or 0 if the date is malformed.
+ */
+int parseDate( const char* date, size_t length );
+
+/**
+ * @brief Get the current local date as a day number.
+ *
+ * @return The day number of today.
+ */
+int getCurrentDay();
+
+/**
+ * @brief Format a day number as "day month, year", such as "05 March, 2025".
+ *
+ * @param day The day number.
+ * @param outputDate The output buffer.
+ * @param outputSize The size of the output buffer.
+ */
+void formatDate( int day, char* outputDate, int outputSize );
+
 /**
  * @brief View upcoming shows and their available seats.
  *
- * This function reads the show details from the specified file and displays the upcoming shows along with their
+ * This function reads the show details from the resident catalog and displays the upcoming shows along with their
  * available seats. It also allows selecting a show based on user input.
  *
- * @param filename The name of the file containing show details.
  * @param userId The user ID.
  * @param viewContent A flag indicating whether to display the show details.
  * @param hasSelect A flag indicating whether to allow show selection.
  * @param hasMenu A flag indicating whether to display a menu.
  * @return The selected show ID if `hasSelect` is true and a show is selected, otherwise -1.
  */
-int viewUpcomingShows( const char* filename, int userId, bool viewContent, bool hasSelect, bool hasMenu );
+int viewUpcomingShows( int userId, bool viewContent, bool hasSelect, bool hasMenu );
 
 /**
- * @brief Count the number of booked seats.
- *
- * This helper function counts the number of booked seats from the given string of booked seats.
+ * @brief Search the upcoming shows by singer, venue or type and view the matches.
  *
- * @param bookedSeats The string containing the booked seats, separated by commas.
- * @return The count of booked seats.
+ * Reads the query from its own line. Matches are found through the search index and listed in date order, one
+ * page at a time.
  */
-int countBookedSeats( const char* bookedSeats );
+void searchUpcomingShows();
 
 /**
- * @brief Select and return number
- * @param serial Number of array
- * @return The ID of the selected show
+ * @brief Count the number of booked seats.
+ *
+ * This helper function counts the number of booked seats in the given seat map.
+ *
+ * @param bookedSeats The seat map of the show.
+ * @return The count of booked seats.
  */
-int selectPopup( int serial );
+int countBookedSeats( const Bitmap* bookedSeats );
 
 /**
  * @brief Buy tickets for the specified seat numbers.
  *
- * @param tickets tickets array of tickets
- * @param shows shows array of shows
- * @param ticketFilename The name of the tickets database file.
- * @param showFilename The name of the shows database file.
  * @param userId The ID of the user.
  * @param showId The ID of the show.
  */
-void buyTicket( Ticket tickets[], Show shows[], const char* ticketFilename, const char* showFilename, int userId, int showId );
+void buyTicket( int userId, int showId );
 
 /**
  * @brief Displays show tickets based on a user ID and allows the user to select a ticket.
  *
- * @param tickets       Array of tickets.
- * @param ticketFilename The name of the tickets database file.
  * @param userId        ID of the user to filter the tickets.
  * @param viewContent        Whether it show content
  * @param hasSelect        Selection enabled?
@@ -101,23 +143,7 @@ void buyTicket( Ticket tickets[], Show shows[], const char* ticketFilename, cons
  *
  * @return The ID of the selected ticket, or -1 if no ticket is selected.
  */
-int showTicketsByUserId( const Ticket tickets[], const char* ticketFilename, int userId, bool viewContent, bool hasSelect, bool hasMenu, bool forBooking );
-
-/**
- * Update the booked field of a show by removing a seat number.
- *
- * @param booked The booked field string to update.
- * @param seatNumber The seat number to remove from the booked field.
- */
-void updateBookedField( char* booked, int seatNumber );
-
-/**
- * Update the booked field of a show in the shows.txt file.
- *
- * @param showId The ID of the show to update.
- * @param seatNumber The seat number to remove from the booked field.
- */
-void updateBookedFieldInFile( int showId, int seatNumber );
+int showTicketsByUserId( int userId, bool viewContent, bool hasSelect, bool hasMenu, bool forBooking );
 
 /**
  * Updates the status of a ticket based on its ID.
@@ -136,29 +162,6 @@ void updateTicketStatus( int ticketId, int newStatus );
  */
 void getShowIDAndSeatNumber( int ticketId, int* showId, int* seatNumber );
 
-/**
- * @brief Generate a random code with the pattern of 3 letters, 5 numbers, and 1 letter.
- *
- * @param code The character array to hold the generated code.
- * @param codeLength The length of the code, including the null terminator.
- */
-void generateRandomCode( char* code, int codeLength );
-
-/**
- * @brief Generate a random alphanumeric character.
- *
- * @return The generated character.
- */
-char generateRandomChar();
-
-/**
- * @brief Generate a transaction number based on the current time.
- *
- * @param transactionNumber The array to store the generated transaction number.
- * @param size The size of the transactionNumber array.
- */
-void generateTransactionNumber( char* transactionNumber, size_t size );
-
 /**
  * Get the show date based on the show ID.
  *
@@ -181,4 +184,21 @@ int getShowDateById( const Show shows[], int showId, char* showDate );
  */
 void convertDate( const char* inputDate, char* outputDate, int outputSize );
 
+/**
+ * @brief Replace a file with a fully written temporary file.
+ *
+ * @param tempFilename The name of the temporary file.
+ * @param filename The name of the file to replace.
+ * @return 0 on success, -1 on failure.
+ */
+int replaceFile( const char* tempFilename, const char* filename );
+
+/**
+ * @brief Write the buffered data of a file and wait until the operating system has it on disk.
+ *
+ * @param file The file.
+ * @return 0 on success, -1 on failure.
+ */
+int syncFile( FILE* file );
+
 #endif // UTILITIES_H